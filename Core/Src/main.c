@@ -21,9 +21,23 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "Acquisition.h"
 #include "Application.h"
+#include "Batch.h"
+#include "Benchmark.h"
+#include "Button.h"
+#include "Command.h"
 #include "Driver.h"
+#include "FlashLog.h"
+#include "Link.h"
+#include "Pool.h"
+#include "Profiler.h"
 #include "Protocol.h"
+#include "Reliable.h"
+#include "Scheduler.h"
+#include "Stats.h"
+#include "Temperature.h"
+#include "Utils.h"
 
 /* USER CODE END Includes */
 
@@ -34,6 +48,7 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define SCHEDULER_REPORT_PERIOD_MS 10000
 
 /* USER CODE END PD */
 
@@ -44,6 +59,8 @@ UART_HandleTypeDef huart2;
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -52,6 +69,7 @@ UART_HandleTypeDef huart2;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
 
@@ -59,7 +77,32 @@ static void MX_USART2_UART_Init(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+static uint8_t hello_world_string[] = "Hello World";
 
+static void produce_date(void)
+{
+  send_date_data(5, 10, 2025);
+}
+
+static void produce_time(void)
+{
+  uint32_t seconds = Driver_GetTimeMs() / 1000;
+  send_time_data((seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60);
+}
+
+static void produce_hello_world(void)
+{
+  send_string_data(sizeof(hello_world_string) - 1, hello_world_string);
+}
+
+static void produce_temperature(void)
+{
+  int16_t centi_c;
+
+  if (temperature_get_centi(&centi_c)) {
+    send_temperature(centi_c);
+  }
+}
 
 /* USER CODE END 0 */
 
@@ -92,16 +135,49 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
   HAL_Delay(1000);
-
-
-  send_date_data(5, 10 , 2025);
-  send_time_data(12, 11, 10);
-  send_adc_data(55,200);
-  send_button_data(3, 1);
-  send_temperature(20);
+  Driver_CycleCounterInit();
+  pool_init();
+  command_init(stats_report_all);
+  link_init();
+#if PROFILER_ENABLED
+  profiler_init();
+#endif
+#if FLASH_LOG_ENABLED
+  // Khôi phục nhật ký trước khung đầu tiên: không có host cho đến khi nhận được khung từ host
+  flash_log_init();
+#endif
+#if PROTOCOL_CRC32_HW
+  Driver_CRC32_Init();
+#endif
+
+#if BENCHMARK_ENABLED
+  benchmark_crc16_report();
+  benchmark_send_report();
+  benchmark_priority_report();
+#endif
+
+  uint32_t now = Driver_GetTimeMs();
+  uint32_t last_report_ms = now;
+
+  scheduler_init();
+  scheduler_add(DATE_STREAM_DATA_ID,      produce_date,        date_stream_data_rate_hz,     now);
+  scheduler_add(TIME_STREAM_DATA_ID,      produce_time,        time_stream_data_rate_hz,     now);
+  scheduler_add(HELLO_WORLD_DATA_ID,      produce_hello_world, hello_world_data_rate_hz,     now);
+  scheduler_add(MCU_TEMPERATURE_DATA_ID,  produce_temperature, mcu_temperature_data_rate_hz, now);
+#if PROFILER_ENABLED
+  scheduler_add(PROFILER_DATA_ID,         profiler_send_report, profiler_data_rate_hz,       now);
+#endif
+
+  // ADC được lấy mẫu bởi TIM2/DMA, vòng lặp chỉ gửi các khối đã đầy
+  acquisition_start(adc_stream_data_rate_hz);
+  // Cảm biến nhiệt độ dùng nhóm injected của ADC1, xen giữa các mẫu của luồng ADC
+  temperature_init();
+  // Nút nhấn PA0 được ghi bởi ngắt EXTI0 và gửi theo sự kiện thay vì theo lịch
+  button_init();
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -111,6 +187,22 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    now = Driver_GetTimeMs();
+    link_poll(now);
+    reliable_poll(now);
+#if FLASH_LOG_ENABLED
+    flash_log_poll(now);
+#endif
+    button_poll();
+    acquisition_poll();
+    temperature_poll(now);
+    scheduler_run(now);
+    batch_poll();
+
+    if (now - last_report_ms >= SCHEDULER_REPORT_PERIOD_MS) {
+      last_report_ms = now;
+      stats_report_all();
+    }
   }
   /* USER CODE END 3 */
 }
@@ -194,6 +286,25 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Stream5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -211,10 +322,14 @@ static void MX_GPIO_Init(void)
 
   /*Configure GPIO pin : PA0 */
   GPIO_InitStruct.Pin = GPIO_PIN_0;
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_PULLUP;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+  /* EXTI interrupt init*/
+  HAL_NVIC_SetPriority(EXTI0_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(EXTI0_IRQn);
+
 /* USER CODE BEGIN MX_GPIO_Init_2 */
 /* USER CODE END MX_GPIO_Init_2 */
 }
@@ -0,0 +1,617 @@
+/*
+ * FrameDecoder.cpp
+ *
+ *  Created on: Apr 24, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "FrameDecoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace telemetry {
+
+namespace {
+
+constexpr std::array<uint16_t, 256> make_crc16_table()
+{
+    std::array<uint16_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint16_t crc = static_cast<uint16_t>(i);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> make_crc32_table()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto CRC16_TABLE = make_crc16_table();
+constexpr auto CRC32_TABLE = make_crc32_table();
+
+
+inline uint16_t get_u16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+inline uint32_t get_u32(const uint8_t* p) { return get_u16(p) | (static_cast<uint32_t>(get_u16(p + 2)) << 16); }
+
+
+// Kết quả đo một vị trí bắt đầu bằng 0xDE
+struct Span {
+    enum Kind { NEED, SKIP, FRAME } kind;
+    size_t length;                               // NEED: số byte cần có; FRAME: độ dài khung
+};
+
+
+/**
+ * @brief Xác định khung bắt đầu tại data[0] (luôn là 0xDE).
+ * Trả về NEED khi chưa đủ byte để biết, SKIP khi tiêu đề không hợp lệ.
+ */
+Span measure(const uint8_t* data, size_t length)
+{
+    if (length < 2) {
+        return { Span::NEED, 2 };
+    }
+
+    size_t  offset = 2;
+    uint8_t flags  = 0;
+    if (data[1] == HEADER_BYTE2_EXT) {
+        if (length < 3) {
+            return { Span::NEED, 3 };
+        }
+        flags = data[2];
+        if (flags & ~FRAME_KNOWN_FLAGS) {
+            return { Span::SKIP, 0 };
+        }
+        offset = 3;
+    } else if (data[1] != HEADER_BYTE2) {
+        return { Span::SKIP, 0 };
+    }
+
+    size_t header_size = offset + ((flags & FRAME_FLAG_TS32) ? 4 : 2) + ((flags & FRAME_FLAG_SEQ) ? 2 : 0) + 2;
+    if (length < header_size) {
+        return { Span::NEED, header_size };
+    }
+
+    uint16_t payload_size = get_u16(data + header_size - 2);
+    if (payload_size > MAX_PAYLOAD_SIZE) {
+        return { Span::SKIP, 0 };
+    }
+
+    size_t total = header_size + payload_size + ((flags & FRAME_FLAG_CRC32) ? 4 : 2);
+    if (length < total) {
+        return { Span::NEED, total };
+    }
+    return { Span::FRAME, total };
+}
+
+
+// Kích thước cố định của bản ghi trong khung gộp; 0 là không xác định
+constexpr size_t RECORD_SIZES[] = { 0, 13, 6, 7, 0, 4, 3 };
+
+size_t record_size(const uint8_t* record, size_t available)
+{
+    uint8_t data_id = record[0];
+    if (data_id == HELLO_WORLD_DATA_ID) {
+        return (available >= 3) ? 3u + get_u16(record + 1) : 0;
+    }
+    return (data_id < sizeof(RECORD_SIZES) / sizeof(RECORD_SIZES[0])) ? RECORD_SIZES[data_id] : 0;
+}
+
+} // namespace
+
+
+uint16_t crc16_modbus(const uint8_t* data, size_t length, uint16_t crc)
+{
+    while (length--) {
+        crc = static_cast<uint16_t>((crc >> 8) ^ CRC16_TABLE[(crc ^ *data++) & 0xFF]);
+    }
+    return crc;
+}
+
+
+uint32_t crc32_stm32(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    uint8_t  word[4];
+
+    for (size_t i = 0; i < length; i += 4) {
+        size_t n = std::min<size_t>(4, length - i);
+        std::memset(word, 0, sizeof(word));
+        std::memcpy(word, data + i, n);
+
+        // Word little-endian được nạp từ bit cao nhất, tức byte 3 trước
+        for (int b = 3; b >= 0; b--) {
+            crc = (crc << 8) ^ CRC32_TABLE[((crc >> 24) ^ word[b]) & 0xFF];
+        }
+    }
+    return crc;
+}
+
+
+FrameDecoder::FrameDecoder(RecordHandler& handler, Framing framing)
+    : handler_(handler), framing_(framing)
+{
+    pending_.reserve(MAX_FRAME_SIZE);
+}
+
+
+void FrameDecoder::reset()
+{
+    set_framing(framing_);
+    stats_ = DecoderStats{};
+}
+
+
+void FrameDecoder::set_framing(Framing framing)
+{
+    framing_        = framing;
+    pending_.clear();
+    cobs_code_      = 0;
+    cobs_remaining_ = 0;
+    cobs_discard_   = false;
+}
+
+
+void FrameDecoder::feed(const uint8_t* data, size_t length)
+{
+    stats_.bytes += length;
+
+    if (framing_ == Framing::COBS) {
+        feed_cobs(data, length);
+        return;
+    }
+
+    // Khung dở dang chỉ được bổ sung đúng số byte nó cần, phần còn lại của đoạn
+    // được giải mã tại chỗ
+    while (!pending_.empty()) {
+        Span span = measure(pending_.data(), pending_.size());
+        if (span.kind == Span::NEED) {
+            if (length == 0) {
+                return;
+            }
+            size_t take = std::min(span.length - pending_.size(), length);
+            pending_.insert(pending_.end(), data, data + take);
+            data   += take;
+            length -= take;
+            continue;
+        }
+
+        size_t used = parse(pending_.data(), pending_.size());
+        pending_.erase(pending_.begin(), pending_.begin() + used);
+    }
+
+    size_t used = parse(data, length);
+    pending_.assign(data + used, data + length);
+}
+
+
+/**
+ * @brief Giải mã mọi khung đầy đủ trong vùng nhớ.
+ * @return Số byte đã xử lý; phần còn lại bắt đầu bằng 0xDE và là một khung chưa đủ.
+ */
+size_t FrameDecoder::parse(const uint8_t* data, size_t length)
+{
+    size_t pos = 0;
+
+    while (pos < length) {
+        if (data[pos] != HEADER_BYTE1) {
+            const void* next = std::memchr(data + pos, HEADER_BYTE1, length - pos);
+            size_t found = next ? static_cast<size_t>(static_cast<const uint8_t*>(next) - data) : length;
+            stats_.skipped_bytes += found - pos;
+            pos = found;
+            continue;
+        }
+
+        Span span = measure(data + pos, length - pos);
+        if (span.kind == Span::NEED) {
+            break;
+        }
+        if (span.kind == Span::SKIP) {
+            stats_.skipped_bytes++;
+            pos++;
+            continue;
+        }
+
+        if (deliver(data + pos)) {
+            pos += span.length;
+        } else {
+            stats_.skipped_bytes++;
+            pos++;
+        }
+    }
+
+    return pos;
+}
+
+
+/**
+ * @brief Giải mã COBS từng nhóm vào pending_; khung được kiểm tra khi gặp byte 0.
+ */
+void FrameDecoder::feed_cobs(const uint8_t* data, size_t length)
+{
+    const uint8_t* end = data + length;
+
+    while (data < end) {
+        if (*data == 0) {
+            finish_cobs();
+            data++;
+            continue;
+        }
+
+        if (cobs_discard_) {
+            const void* zero = std::memchr(data, 0, static_cast<size_t>(end - data));
+            const uint8_t* next = zero ? static_cast<const uint8_t*>(zero) : end;
+            stats_.skipped_bytes += static_cast<size_t>(next - data);
+            data = next;
+            continue;
+        }
+
+        if (cobs_remaining_ == 0) {
+            // Nhóm trước, trừ nhóm đầy 0xFF, kết thúc bằng một byte 0 của dữ liệu gốc
+            if (cobs_code_ != 0 && cobs_code_ != 0xFF) {
+                pending_.push_back(0);
+            }
+            cobs_code_      = *data++;
+            cobs_remaining_ = static_cast<uint8_t>(cobs_code_ - 1);
+            continue;
+        }
+
+        // Phần còn lại của nhóm được chép một lần, dừng trước byte 0 (nhóm bị cắt ngang)
+        size_t run = std::min<size_t>(cobs_remaining_, static_cast<size_t>(end - data));
+        const void* zero = std::memchr(data, 0, run);
+        if (zero != nullptr) {
+            run = static_cast<size_t>(static_cast<const uint8_t*>(zero) - data);
+        }
+        pending_.insert(pending_.end(), data, data + run);
+        data            += run;
+        cobs_remaining_  = static_cast<uint8_t>(cobs_remaining_ - run);
+
+        if (pending_.size() > MAX_FRAME_SIZE) {
+            stats_.skipped_bytes += pending_.size();
+            pending_.clear();
+            cobs_discard_ = true;
+        }
+    }
+}
+
+
+/**
+ * @brief Kết thúc khung COBS đang đọc: khung phải trọn nhóm và có độ dài đúng bằng tiêu đề.
+ */
+void FrameDecoder::finish_cobs()
+{
+    bool started = (cobs_code_ != 0 || cobs_discard_);
+    bool ok = !cobs_discard_ && cobs_remaining_ == 0 && !pending_.empty() && pending_[0] == HEADER_BYTE1;
+
+    if (ok) {
+        Span span = measure(pending_.data(), pending_.size());
+        ok = (span.kind == Span::FRAME && span.length == pending_.size());
+    }
+
+    // Sai checksum được đếm bởi deliver(), các lỗi còn lại là lỗi tách khung
+    if (ok) {
+        deliver(pending_.data());
+    } else if (started) {
+        stats_.framing_errors++;
+        stats_.skipped_bytes += pending_.size();
+        handler_.on_frame(FrameInfo{});
+    }
+
+    pending_.clear();
+    cobs_code_      = 0;
+    cobs_remaining_ = 0;
+    cobs_discard_   = false;
+}
+
+
+/**
+ * @brief Kiểm tra checksum của một khung đủ độ dài rồi giải mã payload.
+ * @return true nếu khung hợp lệ.
+ */
+bool FrameDecoder::deliver(const uint8_t* frame)
+{
+    FrameInfo info{};
+    size_t offset = 2;
+    if (frame[1] == HEADER_BYTE2_EXT) {
+        info.flags = frame[2];
+        offset = 3;
+    }
+
+    if (info.flags & FRAME_FLAG_TS32) {
+        info.timestamp         = get_u32(frame + offset);
+        info.timestamp_us      = info.timestamp;
+        info.timestamp_wrap_us = 1ull << 32;
+        offset += 4;
+    } else {
+        info.timestamp         = get_u16(frame + offset);
+        info.timestamp_us      = info.timestamp * 1000ull;
+        info.timestamp_wrap_us = (1ull << 16) * 1000ull;
+        offset += 2;
+    }
+
+    if (info.flags & FRAME_FLAG_SEQ) {
+        info.seq = get_u16(frame + offset);
+        offset += 2;
+    }
+
+    info.payload_size = get_u16(frame + offset);
+    info.payload      = frame + offset + 2;
+
+    size_t crc_length = offset + 2 + info.payload_size;
+    if (info.flags & FRAME_FLAG_CRC32) {
+        info.checksum     = get_u32(frame + crc_length);
+        info.computed_crc = crc32_stm32(frame, crc_length);
+    } else {
+        info.checksum     = get_u16(frame + crc_length);
+        info.computed_crc = crc16_modbus(frame, crc_length);
+    }
+    info.valid = (info.checksum == info.computed_crc);
+
+    if (info.valid) {
+        stats_.frames++;
+        decode_payload(info);
+    } else {
+        stats_.crc_errors++;
+    }
+
+    handler_.on_frame(info);
+    return info.valid;
+}
+
+
+void FrameDecoder::decode_payload(const FrameInfo& info)
+{
+    if (info.payload_size == 0) {
+        stats_.payload_errors++;
+        return;
+    }
+
+    const uint8_t* payload = info.payload;
+    if (payload[0] != BATCH_DATA_ID) {
+        decode_record(info, payload, info.payload_size);
+        return;
+    }
+
+    // Khung gộp: [data_id][record_count][bản ghi ...]
+    if (info.payload_size < 2) {
+        stats_.payload_errors++;
+        return;
+    }
+
+    uint8_t count  = payload[1];
+    size_t  offset = 2;
+    for (uint8_t i = 0; i < count; i++) {
+        size_t available = info.payload_size - offset;
+        size_t size = (offset < info.payload_size) ? record_size(payload + offset, available) : 0;
+        if (size == 0 || size > available) {
+            stats_.payload_errors++;
+            return;
+        }
+        decode_record(info, payload + offset, size);
+        offset += size;
+    }
+}
+
+
+/**
+ * @brief Giải mã một bản ghi có đúng độ dài của data_id của nó.
+ */
+bool FrameDecoder::decode_record(const FrameInfo& info, const uint8_t* record, size_t length)
+{
+    switch (record[0]) {
+    case DATE_STREAM_DATA_ID:
+        if (length != 13) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_date(info, { get_u32(record + 1), get_u32(record + 5), get_u32(record + 9) });
+        return true;
+
+    case TIME_STREAM_DATA_ID:
+        if (length != 6) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_time(info, { record[1], get_u16(record + 2), get_u16(record + 4) });
+        return true;
+
+    case ADC_STREAM_DATA_ID:
+        if (length != 7) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_adc(info, { get_u32(record + 1), get_u16(record + 5) });
+        return true;
+
+    case HELLO_WORLD_DATA_ID:
+        if (length < 3 || length != 3u + get_u16(record + 1)) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_string(info, { std::string_view(reinterpret_cast<const char*>(record + 3), length - 3) });
+        return true;
+
+    case BUTTON_STATE_DATA_ID:
+        if (length != 4) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_button(info, { record[1], get_u16(record + 2) });
+        return true;
+
+    case MCU_TEMPERATURE_DATA_ID:
+        if (length != 3) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_temperature(info, { static_cast<int16_t>(get_u16(record + 1)) });
+        return true;
+
+    case PROFILER_DATA_ID: {
+        // [data_id][probe_count][core_mhz] rồi probe_count bản ghi 49 byte
+        constexpr size_t probe_size = 1 + 4 * 4 + 2 * PROFILER_HISTOGRAM_BINS;
+        if (length < 3 || length != 3 + record[1] * probe_size) {
+            break;
+        }
+        for (uint8_t i = 0; i < record[1]; i++) {
+            const uint8_t* p = record + 3 + i * probe_size;
+            ProfilerProbe probe{};
+            probe.probe    = p[0];
+            probe.core_mhz = record[2];
+            probe.count    = get_u32(p + 1);
+            probe.min      = get_u32(p + 5);
+            probe.max      = get_u32(p + 9);
+            probe.mean     = get_u32(p + 13);
+            for (size_t b = 0; b < PROFILER_HISTOGRAM_BINS; b++) {
+                probe.histogram[b] = get_u16(p + 17 + 2 * b);
+            }
+            handler_.on_profiler(info, probe);
+        }
+        stats_.records++;
+        return true;
+    }
+
+    case ADC_BLOCK_DATA_ID:
+        if (!decode_adc_block(info, record, length)) {
+            break;
+        }
+        stats_.records++;
+        return true;
+
+    case LINK_DATA_ID:
+        // [data_id][op][baud (4)][arg (2)] rồi mẫu thử tùy chọn
+        if (length < 8) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_link(info, { record[1], get_u32(record + 2), get_u16(record + 6),
+                                 static_cast<uint16_t>(length - 8) });
+        return true;
+
+    case COMMAND_DATA_ID:
+        // [data_id][op][stream_id][status][value (4)]
+        if (length != 8) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_command(info, { record[1], record[2], record[3], get_u32(record + 4) });
+        return true;
+
+    case RELIABLE_DATA_ID:
+        // [data_id][op][seq (2)][value (4)]
+        if (length != 8) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_reliable(info, { record[1], get_u16(record + 2), get_u32(record + 4) });
+        return true;
+
+    case FLASH_LOG_DATA_ID:
+        // [data_id][op][arg (2)][value (4)]
+        if (length != 8) {
+            break;
+        }
+        stats_.records++;
+        handler_.on_flash_log(info, { record[1], get_u16(record + 2), get_u32(record + 4) });
+        return true;
+
+    default:
+        break;
+    }
+
+    stats_.payload_errors++;
+    handler_.on_unknown(info, record, length);
+    return false;
+}
+
+
+/**
+ * @brief Giải mã khối ADC nén [data_id][encoding][first_sample (4)][count (2)][dữ liệu],
+ *      mỗi mẫu được gửi tới on_adc() như một bản ghi ADC thường.
+ * Cả khối được kiểm tra trước khi gửi mẫu đầu tiên, nên khối hỏng không sinh ra mẫu nào.
+ */
+bool FrameDecoder::decode_adc_block(const FrameInfo& info, const uint8_t* record, size_t length)
+{
+    constexpr size_t header_size = 8;
+    if (length < header_size) {
+        return false;
+    }
+
+    const uint8_t  encoding = record[1];
+    const uint32_t first    = get_u32(record + 2);
+    const uint16_t count    = get_u16(record + 6);
+    const uint8_t* data     = record + header_size;
+    const size_t   size     = length - header_size;
+
+    // Mỗi mẫu chiếm ít nhất một byte payload nên khối hợp lệ không vượt quá MAX_PAYLOAD_SIZE mẫu
+    if (count > MAX_PAYLOAD_SIZE) {
+        return false;
+    }
+    uint16_t values[MAX_PAYLOAD_SIZE];
+    size_t   n = 0;
+
+    if (encoding == ADC_BLOCK_PACKED12) {
+        if (size != count / 2 * 3u + (count & 1u) * 2u) {
+            return false;
+        }
+        for (; n + 1 < count; n += 2, data += 3) {
+            values[n]     = static_cast<uint16_t>(data[0] | ((data[1] & 0x0F) << 8));
+            values[n + 1] = static_cast<uint16_t>((data[1] >> 4) | (data[2] << 4));
+        }
+        if (n < count) {
+            values[n++] = get_u16(data);
+        }
+    } else if (encoding == ADC_BLOCK_DELTA_VARINT) {
+        if (count == 0 || size < 2) {
+            return false;
+        }
+        int32_t value = get_u16(data);
+        values[n++] = static_cast<uint16_t>(value);
+
+        uint32_t zigzag = 0;
+        unsigned shift  = 0;
+        for (size_t i = 2; i < size; i++) {
+            if (shift > 28) {
+                return false;
+            }
+            zigzag |= static_cast<uint32_t>(data[i] & 0x7F) << shift;
+            shift += 7;
+            if (data[i] & 0x80) {
+                continue;
+            }
+            if (n == count) {
+                return false;
+            }
+            value += static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+            values[n++] = static_cast<uint16_t>(value);
+            zigzag = 0;
+            shift  = 0;
+        }
+        if (n != count || shift != 0) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        handler_.on_adc(info, { first + static_cast<uint32_t>(i), values[i] });
+    }
+    return true;
+}
+
+} // namespace telemetry
@@ -0,0 +1,213 @@
+/*
+ * FrameDecoder.hpp
+ *
+ *  Created on: Apr 24, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Bộ giải mã khung phía host, cùng định dạng với Lib/Src/Protocol.c và payload
+ * data_id_t của Lib/Src/Application.c. Dữ liệu được nạp theo từng đoạn bất kỳ;
+ * các khung nằm trọn trong đoạn được giải mã ngay trên bộ đệm của người gọi,
+ * chỉ phần khung bị cắt ở cuối đoạn mới được chép lại.
+ */
+
+#ifndef HOST_FRAMEDECODER_HPP_
+#define HOST_FRAMEDECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace telemetry {
+
+/** @brief Hằng số của khung, khớp với Protocol.h. */
+constexpr uint8_t  HEADER_BYTE1     = 0xDE;
+constexpr uint8_t  HEADER_BYTE2     = 0xAB;
+constexpr uint8_t  HEADER_BYTE2_EXT = 0xAC;
+constexpr uint8_t  FRAME_FLAG_CRC32 = 0x01;
+constexpr uint8_t  FRAME_FLAG_TS32  = 0x02;
+constexpr uint8_t  FRAME_FLAG_SEQ   = 0x04;
+constexpr uint8_t  FRAME_FLAG_LOG   = 0x08;
+constexpr uint8_t  FRAME_KNOWN_FLAGS = FRAME_FLAG_CRC32 | FRAME_FLAG_TS32 | FRAME_FLAG_SEQ | FRAME_FLAG_LOG;
+constexpr uint16_t MAX_PAYLOAD_SIZE = 1024;
+
+/** @brief Độ dài lớn nhất của một khung: tiêu đề mở rộng 11 byte, payload và CRC-32. */
+constexpr size_t MAX_FRAME_SIZE = 11 + MAX_PAYLOAD_SIZE + 4;
+
+
+/** @brief Cách tách khung trong luồng byte, khớp PROTOCOL_COBS của Protocol.h. */
+enum class Framing : uint8_t {
+    RAW  = 0,                                    /**< Khung nguyên dạng, tìm tiêu đề DE AB/DE AC. */
+    COBS = 1,                                    /**< Khung mã hóa COBS, kết thúc bằng byte 0. */
+};
+
+
+/** @brief Loại dữ liệu trong payload, khớp với data_id_t trong Application.h. */
+enum DataId : uint8_t {
+    DATE_STREAM_DATA_ID     = 1,
+    TIME_STREAM_DATA_ID     = 2,
+    ADC_STREAM_DATA_ID      = 3,
+    HELLO_WORLD_DATA_ID     = 4,
+    BUTTON_STATE_DATA_ID    = 5,
+    MCU_TEMPERATURE_DATA_ID = 6,
+    BATCH_DATA_ID           = 7,
+    PROFILER_DATA_ID        = 8,
+    LINK_DATA_ID            = 9,
+    ADC_BLOCK_DATA_ID       = 10,
+    COMMAND_DATA_ID         = 11,
+    RELIABLE_DATA_ID        = 12,
+    FLASH_LOG_DATA_ID       = 13,
+};
+
+
+/** @brief Mã hóa của khối ADC nén, khớp với adc_block_encoding_t trong Application.h. */
+enum AdcBlockEncoding : uint8_t {
+    ADC_BLOCK_PACKED12     = 0,
+    ADC_BLOCK_DELTA_VARINT = 1,
+};
+
+
+/** @brief Thông tin của một khung đã đủ độ dài (hợp lệ hoặc sai checksum). */
+struct FrameInfo {
+    bool           valid;                        /**< Checksum khớp. */
+    uint8_t        flags;                        /**< Cờ khung mở rộng, 0 với khung gốc DE AB. */
+    uint32_t       timestamp;                    /**< Timestamp thô (ms 16 bit hoặc us 32 bit). */
+    uint64_t       timestamp_us;                 /**< Timestamp quy ra micro giây. */
+    uint64_t       timestamp_wrap_us;            /**< Chu kỳ tràn của timestamp_us. */
+    uint16_t       seq;                          /**< Số thứ tự của chế độ tin cậy, chỉ có nghĩa khi có FRAME_FLAG_SEQ. */
+    uint32_t       checksum;                     /**< Checksum trong khung. */
+    uint32_t       computed_crc;                 /**< Checksum tính lại. */
+    const uint8_t* payload;                      /**< Payload, chỉ hợp lệ trong lúc gọi callback. */
+    uint16_t       payload_size;
+};
+
+
+struct DateRecord        { uint32_t days; uint32_t month; uint32_t year; };
+struct TimeRecord        { uint8_t hour; uint16_t minute; uint16_t second; };
+struct AdcRecord         { uint32_t sample_count; uint16_t value; };
+struct StringRecord      { std::string_view text; };
+struct ButtonRecord      { uint8_t button_id; uint16_t state; };
+struct TemperatureRecord { int16_t centi_celsius; };
+
+/** @brief Khung điều khiển liên kết (Lib/Inc/Link.h); mẫu thử của PROBE_ACK không được giữ lại. */
+struct LinkRecord        { uint8_t op; uint32_t baud; uint16_t arg; uint16_t probe_length; };
+
+/** @brief Lệnh hoặc trả lời lệnh (Lib/Inc/Command.h); op có bit 0x80 ở khung trả lời. */
+struct CommandRecord     { uint8_t op; uint8_t stream_id; uint8_t status; uint32_t value; };
+
+/** @brief Điều khiển chế độ truyền tin cậy (Lib/Inc/Reliable.h). */
+struct ReliableRecord    { uint8_t op; uint16_t seq; uint32_t value; };
+
+/** @brief Điều khiển nhật ký flash (Lib/Inc/FlashLog.h). */
+struct FlashLogRecord    { uint8_t op; uint16_t arg; uint32_t value; };
+
+constexpr size_t PROFILER_HISTOGRAM_BINS = 16;
+
+/** @brief Thống kê của một điểm đo trong báo cáo profiler (data_id 8). */
+struct ProfilerProbe {
+    uint8_t  probe;
+    uint8_t  core_mhz;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint16_t histogram[PROFILER_HISTOGRAM_BINS];
+};
+
+
+/**
+ * @brief Nơi nhận các bản ghi đã giải mã.
+ * Các bản ghi của một khung (nhiều bản ghi nếu là khung gộp) được gửi trước,
+ *      on_frame() được gọi sau cùng cho mọi khung kể cả khung sai checksum; với
+ *      Framing::COBS, khung không tách được cũng được báo bằng một FrameInfo rỗng (valid = false).
+ */
+class RecordHandler {
+public:
+    virtual ~RecordHandler() = default;
+
+    virtual void on_date(const FrameInfo&, const DateRecord&) {}
+    virtual void on_time(const FrameInfo&, const TimeRecord&) {}
+    /** @brief Một mẫu ADC, từ bản ghi ADC_STREAM_DATA_ID hoặc từ khối nén ADC_BLOCK_DATA_ID. */
+    virtual void on_adc(const FrameInfo&, const AdcRecord&) {}
+    virtual void on_string(const FrameInfo&, const StringRecord&) {}
+    virtual void on_button(const FrameInfo&, const ButtonRecord&) {}
+    virtual void on_temperature(const FrameInfo&, const TemperatureRecord&) {}
+    virtual void on_profiler(const FrameInfo&, const ProfilerProbe&) {}
+    virtual void on_link(const FrameInfo&, const LinkRecord&) {}
+    virtual void on_command(const FrameInfo&, const CommandRecord&) {}
+    virtual void on_reliable(const FrameInfo&, const ReliableRecord&) {}
+    virtual void on_flash_log(const FrameInfo&, const FlashLogRecord&) {}
+
+    /** @brief Bản ghi có data_id hoặc kích thước không nhận ra. */
+    virtual void on_unknown(const FrameInfo&, const uint8_t* /*record*/, size_t /*length*/) {}
+
+    virtual void on_frame(const FrameInfo&) {}
+};
+
+
+struct DecoderStats {
+    uint64_t bytes;                              /**< Tổng số byte đã nạp. */
+    uint64_t frames;                             /**< Số khung hợp lệ. */
+    uint64_t records;                            /**< Số bản ghi đã giải mã (kể cả trong khung gộp). */
+    uint64_t crc_errors;                         /**< Số khung đủ độ dài nhưng sai checksum. */
+    uint64_t payload_errors;                     /**< Số bản ghi không giải mã được. */
+    uint64_t skipped_bytes;                      /**< Số byte bị bỏ qua khi tìm tiêu đề hoặc của khung COBS hỏng. */
+    uint64_t framing_errors;                     /**< Số khung COBS không giải mã được hoặc sai độ dài. */
+};
+
+
+/**
+ * @brief Bộ giải mã khung dạng luồng.
+ * Nhận cả khung gốc DE AB lẫn khung mở rộng DE AC. Khi tiêu đề, độ dài hoặc checksum
+ *      không hợp lệ, bộ giải mã chỉ bỏ qua một byte rồi tìm 0xDE kế tiếp, nên một tiêu
+ *      đề giả không làm mất các khung thật nằm bên trong vùng độ dài của nó.
+ * Với Framing::COBS, khung được giải mã dần vào bộ đệm riêng và chỉ được kiểm tra khi
+ *      gặp byte 0; khung hỏng bị bỏ nguyên và khung kế tiếp bắt đầu ngay sau byte 0 đó.
+ */
+class FrameDecoder {
+public:
+    explicit FrameDecoder(RecordHandler& handler, Framing framing = Framing::RAW);
+
+    /**
+     * @brief Nạp một đoạn byte nhận được.
+     * @param[in] data   Dữ liệu, chỉ cần tồn tại trong lúc gọi.
+     * @param[in] length Số byte.
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /** @brief Bỏ phần khung dở dang và xóa thống kê. */
+    void reset();
+
+    /** @brief Đổi cách tách khung, phần khung dở dang bị bỏ. */
+    void set_framing(Framing framing);
+
+    const DecoderStats& stats() const { return stats_; }
+
+private:
+    size_t parse(const uint8_t* data, size_t length);
+    void   feed_cobs(const uint8_t* data, size_t length);
+    void   finish_cobs();
+    bool   deliver(const uint8_t* frame);
+    void   decode_payload(const FrameInfo& info);
+    bool   decode_record(const FrameInfo& info, const uint8_t* record, size_t length);
+    bool   decode_adc_block(const FrameInfo& info, const uint8_t* record, size_t length);
+
+    RecordHandler&       handler_;
+    std::vector<uint8_t> pending_;               // Khung dở dang ở cuối đoạn trước (đã giải mã với COBS)
+    DecoderStats         stats_{};
+    Framing              framing_;
+    uint8_t              cobs_code_ = 0;         // Byte mã của nhóm COBS đang đọc, 0 = chưa có nhóm nào
+    uint8_t              cobs_remaining_ = 0;    // Số byte còn lại của nhóm đang đọc
+    bool                 cobs_discard_ = false;  // Khung đang đọc quá dài, bỏ đến byte 0 kế tiếp
+};
+
+
+/** @brief CRC16 Modbus dạng bảng, khớp calculate_crc16() của firmware. */
+uint16_t crc16_modbus(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+/** @brief CRC-32 của bộ CRC phần cứng STM32F4 (word little-endian, đệm 0). */
+uint32_t crc32_stm32(const uint8_t* data, size_t length);
+
+} // namespace telemetry
+
+#endif /* HOST_FRAMEDECODER_HPP_ */
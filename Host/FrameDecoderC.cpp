@@ -0,0 +1,204 @@
+/*
+ * FrameDecoderC.cpp
+ *
+ *  Created on: Apr 24, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "FrameDecoderC.h"
+#include "FrameDecoder.hpp"
+
+#include <initializer_list>
+#include <new>
+
+using namespace telemetry;
+
+namespace {
+
+frame_decoder_frame_t to_c(const FrameInfo& info)
+{
+    frame_decoder_frame_t frame;
+    frame.valid             = info.valid;
+    frame.flags             = info.flags;
+    frame.payload_size      = info.payload_size;
+    frame.seq               = info.seq;
+    frame.timestamp         = info.timestamp;
+    frame.timestamp_us      = info.timestamp_us;
+    frame.timestamp_wrap_us = info.timestamp_wrap_us;
+    frame.checksum          = info.checksum;
+    frame.computed_crc      = info.computed_crc;
+    frame.payload           = info.payload;
+    return frame;
+}
+
+
+// Chuyển các bản ghi C++ có kiểu thành frame_decoder_record_t cho callback C
+class CallbackHandler : public RecordHandler {
+public:
+    CallbackHandler(frame_decoder_record_cb on_record, frame_decoder_frame_cb on_frame, void* user)
+        : on_record_(on_record), on_frame_(on_frame), user_(user) {}
+
+    void on_date(const FrameInfo& info, const DateRecord& r) override
+    {
+        emit(info, DATE_STREAM_DATA_ID, { r.days, r.month, r.year });
+    }
+
+    void on_time(const FrameInfo& info, const TimeRecord& r) override
+    {
+        emit(info, TIME_STREAM_DATA_ID, { r.hour, r.minute, r.second });
+    }
+
+    void on_adc(const FrameInfo& info, const AdcRecord& r) override
+    {
+        emit(info, ADC_STREAM_DATA_ID, { r.sample_count, r.value });
+    }
+
+    void on_string(const FrameInfo& info, const StringRecord& r) override
+    {
+        emit(info, HELLO_WORLD_DATA_ID, { static_cast<uint32_t>(r.text.size()) },
+             reinterpret_cast<const uint8_t*>(r.text.data()), r.text.size());
+    }
+
+    void on_button(const FrameInfo& info, const ButtonRecord& r) override
+    {
+        emit(info, BUTTON_STATE_DATA_ID, { r.button_id, r.state });
+    }
+
+    void on_temperature(const FrameInfo& info, const TemperatureRecord& r) override
+    {
+        emit(info, MCU_TEMPERATURE_DATA_ID, { static_cast<uint32_t>(static_cast<int32_t>(r.centi_celsius)) });
+    }
+
+    void on_profiler(const FrameInfo& info, const ProfilerProbe& r) override
+    {
+        emit(info, PROFILER_DATA_ID, { r.probe, r.count, r.min, r.max, r.mean, r.core_mhz },
+             reinterpret_cast<const uint8_t*>(r.histogram), sizeof(r.histogram));
+    }
+
+    void on_link(const FrameInfo& info, const LinkRecord& r) override
+    {
+        emit(info, LINK_DATA_ID, { r.op, r.baud, r.arg, r.probe_length });
+    }
+
+    void on_command(const FrameInfo& info, const CommandRecord& r) override
+    {
+        emit(info, COMMAND_DATA_ID, { r.op, r.stream_id, r.status, r.value });
+    }
+
+    void on_reliable(const FrameInfo& info, const ReliableRecord& r) override
+    {
+        emit(info, RELIABLE_DATA_ID, { r.op, r.seq, r.value });
+    }
+
+    void on_flash_log(const FrameInfo& info, const FlashLogRecord& r) override
+    {
+        emit(info, FLASH_LOG_DATA_ID, { r.op, r.arg, r.value });
+    }
+
+    void on_unknown(const FrameInfo& info, const uint8_t* record, size_t length) override
+    {
+        emit(info, 0, {}, record, length);
+    }
+
+    void on_frame(const FrameInfo& info) override
+    {
+        if (on_frame_ != nullptr) {
+            frame_decoder_frame_t frame = to_c(info);
+            on_frame_(user_, &frame);
+        }
+    }
+
+private:
+    void emit(const FrameInfo& info, uint8_t data_id, std::initializer_list<uint32_t> values,
+              const uint8_t* data = nullptr, size_t length = 0)
+    {
+        if (on_record_ == nullptr) {
+            return;
+        }
+
+        frame_decoder_frame_t  frame = to_c(info);
+        frame_decoder_record_t record{};
+        record.data_id     = data_id;
+        record.data        = data;
+        record.data_length = static_cast<uint16_t>(length);
+
+        size_t i = 0;
+        for (uint32_t value : values) {
+            record.values[i++] = value;
+        }
+        on_record_(user_, &frame, &record);
+    }
+
+    frame_decoder_record_cb on_record_;
+    frame_decoder_frame_cb  on_frame_;
+    void*                   user_;
+};
+
+} // namespace
+
+
+struct frame_decoder {
+    CallbackHandler handler;
+    FrameDecoder    decoder;
+
+    frame_decoder(frame_decoder_record_cb on_record, frame_decoder_frame_cb on_frame, void* user)
+        : handler(on_record, on_frame, user), decoder(handler) {}
+};
+
+
+extern "C" {
+
+frame_decoder_t* frame_decoder_create(frame_decoder_record_cb on_record, frame_decoder_frame_cb on_frame, void* user)
+{
+    return new (std::nothrow) frame_decoder(on_record, on_frame, user);
+}
+
+
+void frame_decoder_destroy(frame_decoder_t* decoder)
+{
+    delete decoder;
+}
+
+
+void frame_decoder_feed(frame_decoder_t* decoder, const uint8_t* data, size_t length)
+{
+    if (decoder == nullptr || data == nullptr) {
+        return;
+    }
+    decoder->decoder.feed(data, length);
+}
+
+
+void frame_decoder_reset(frame_decoder_t* decoder)
+{
+    if (decoder != nullptr) {
+        decoder->decoder.reset();
+    }
+}
+
+
+void frame_decoder_set_cobs(frame_decoder_t* decoder, uint8_t enabled)
+{
+    if (decoder != nullptr) {
+        decoder->decoder.set_framing(enabled ? Framing::COBS : Framing::RAW);
+    }
+}
+
+
+void frame_decoder_get_stats(const frame_decoder_t* decoder, frame_decoder_stats_t* stats)
+{
+    if (decoder == nullptr || stats == nullptr) {
+        return;
+    }
+
+    const DecoderStats& s = decoder->decoder.stats();
+    stats->bytes          = s.bytes;
+    stats->frames         = s.frames;
+    stats->records        = s.records;
+    stats->crc_errors     = s.crc_errors;
+    stats->payload_errors = s.payload_errors;
+    stats->skipped_bytes  = s.skipped_bytes;
+    stats->framing_errors = s.framing_errors;
+}
+
+} // extern "C"
@@ -0,0 +1,94 @@
+/*
+ * FrameDecoderC.h
+ *
+ *  Created on: Apr 24, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Giao diện C của FrameDecoder để dùng từ Python (ctypes) hoặc C.
+ */
+
+#ifndef HOST_FRAMEDECODERC_H_
+#define HOST_FRAMEDECODERC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t        valid;
+    uint8_t        flags;
+    uint16_t       payload_size;
+    uint16_t       seq;                          /* chỉ có nghĩa khi flags có 0x04 (chế độ tin cậy) */
+    uint32_t       timestamp;
+    uint64_t       timestamp_us;
+    uint64_t       timestamp_wrap_us;
+    uint32_t       checksum;
+    uint32_t       computed_crc;
+    const uint8_t* payload;
+} frame_decoder_frame_t;
+
+
+/**
+ * @brief Một bản ghi đã giải mã.
+ * values theo data_id: date (days, month, year), time (hour, minute, second),
+ *      ADC (sample_count, value), button (button_id, state), temperature (0.01 °C, int32 có dấu),
+ *      profiler (probe, count, min, max, mean, core_mhz), link (op, baud, arg, probe_length),
+ *      command (op, stream_id, status, value), reliable (op, seq, value), flash log (op, arg, value).
+ * data/data_length: chuỗi của HELLO_WORLD_DATA_ID, histogram (uint16 LE) của profiler,
+ *      bản ghi thô khi data_id không nhận ra (data_id = 0).
+ */
+typedef struct {
+    uint8_t        data_id;
+    uint16_t       data_length;
+    uint32_t       values[6];
+    const uint8_t* data;
+} frame_decoder_record_t;
+
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t frames;
+    uint64_t records;
+    uint64_t crc_errors;
+    uint64_t payload_errors;
+    uint64_t skipped_bytes;
+    uint64_t framing_errors;
+} frame_decoder_stats_t;
+
+
+typedef void (*frame_decoder_record_cb)(void* user, const frame_decoder_frame_t* frame,
+                                        const frame_decoder_record_t* record);
+typedef void (*frame_decoder_frame_cb)(void* user, const frame_decoder_frame_t* frame);
+
+typedef struct frame_decoder frame_decoder_t;
+
+
+/**
+ * @brief Tạo bộ giải mã.
+ * @param[in] on_record Gọi cho mỗi bản ghi của khung hợp lệ, có thể NULL.
+ * @param[in] on_frame  Gọi sau các bản ghi của mỗi khung, kể cả khung sai checksum; có thể NULL.
+ * @param[in] user      Con trỏ được chuyển nguyên cho callback.
+ */
+frame_decoder_t* frame_decoder_create(frame_decoder_record_cb on_record, frame_decoder_frame_cb on_frame, void* user);
+
+void frame_decoder_destroy(frame_decoder_t* decoder);
+
+void frame_decoder_feed(frame_decoder_t* decoder, const uint8_t* data, size_t length);
+
+void frame_decoder_reset(frame_decoder_t* decoder);
+
+/**
+ * @brief Chọn cách tách khung: 0 = tìm tiêu đề, khác 0 = COBS (PROTOCOL_COBS của firmware).
+ */
+void frame_decoder_set_cobs(frame_decoder_t* decoder, uint8_t enabled);
+
+void frame_decoder_get_stats(const frame_decoder_t* decoder, frame_decoder_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FRAMEDECODERC_H_ */
@@ -0,0 +1,124 @@
+/*
+ * Sim.h
+ *
+ *  Created on: Apr 28, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Phần thay thế Driver.c và Utils.c khi build Lib/ trên máy host: UART được thay
+ * bằng một đích ghi (bộ nhớ, file hoặc pty) có thể giới hạn theo baud, đồng hồ
+ * ms/us được thay bằng đồng hồ mô phỏng.
+ */
+
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Tần số lõi được mô phỏng, dùng để đổi thời gian ra chu kỳ (Driver_GetCycles). */
+#define SIM_CORE_HZ 168000000u
+
+/** @brief Tần số APB1 được mô phỏng, dùng để tính bộ chia baud của USART2 (Driver_UART_CheckBaud). */
+#define SIM_PCLK1_HZ 42000000u
+
+
+typedef enum {
+    SIM_SINK_MEMORY = 0,                         /**< Ghi vào bộ đệm trong RAM, đọc lại bằng sim_sink_memory(). */
+    SIM_SINK_FILE   = 1,                         /**< Ghi vào file. */
+    SIM_SINK_PTY    = 2,                         /**< Ghi vào đầu master của một pty mới, py.py mở đầu slave;
+                                                      dữ liệu host ghi vào pty được đọc bởi Driver_UART_Read(). */
+} sim_sink_t;
+
+
+typedef enum {
+    SIM_CLOCK_MANUAL = 0,                        /**< Thời gian chỉ tăng qua sim_clock_advance_us(). */
+    SIM_CLOCK_REAL   = 1,                        /**< Thời gian thực (CLOCK_MONOTONIC) kể từ sim_clock_init(). */
+} sim_clock_mode_t;
+
+
+typedef struct {
+    uint64_t frames;                             /**< Số lần Commit/Send/SendV. */
+    uint64_t bytes;                              /**< Số byte đã ghi ra đích. */
+    uint64_t dropped;                            /**< Số byte bị bỏ do bộ đệm bộ nhớ đầy. */
+    uint64_t corrupted;                          /**< Số byte bị lật bit bởi sim_sink_set_error_rate(). */
+} sim_sink_stats_t;
+
+
+/**
+ * @brief Mở đích ghi cho UART mô phỏng.
+ * @param[in] sink     Loại đích.
+ * @param[in] path     Đường dẫn file (SIM_SINK_FILE), bỏ qua với các loại khác.
+ * @param[in] baud     Tốc độ baud để giới hạn tốc độ ghi (10 bit mỗi byte), 0 là không giới hạn.
+ * @param[in] capacity Dung lượng bộ đệm của SIM_SINK_MEMORY (byte).
+ * @return 0 nếu thành công, -1 nếu lỗi.
+ */
+int sim_sink_open(sim_sink_t sink, const char* path, uint32_t baud, size_t capacity);
+
+
+/** @brief Đóng đích ghi. */
+void sim_sink_close(void);
+
+
+/** @brief Tên đầu slave của pty (SIM_SINK_PTY), NULL với các loại khác. */
+const char* sim_sink_pty_name(void);
+
+
+/**
+ * @brief Lấy dữ liệu đã ghi vào SIM_SINK_MEMORY.
+ * @param[out] length Số byte.
+ * @return Con trỏ đến dữ liệu.
+ */
+const uint8_t* sim_sink_memory(size_t* length);
+
+
+/** @brief Xóa dữ liệu của SIM_SINK_MEMORY (thống kê được giữ nguyên). */
+void sim_sink_memory_reset(void);
+
+
+/** @brief Thống kê của đích ghi. */
+const sim_sink_stats_t* sim_sink_get_stats(void);
+
+
+/**
+ * @brief Mô phỏng đường truyền nhiễu: mỗi byte ghi ra đích bị lật một bit với xác suất ppm / 10^6.
+ * @param[in] ppm Tỉ lệ byte lỗi (phần triệu), 0 để tắt.
+ */
+void sim_sink_set_error_rate(uint32_t ppm);
+
+
+/**
+ * @brief Khởi tạo đồng hồ mô phỏng, thời gian bắt đầu từ 0.
+ * @param[in] mode Chế độ đồng hồ.
+ */
+void sim_clock_init(sim_clock_mode_t mode);
+
+
+/** @brief Tăng đồng hồ SIM_CLOCK_MANUAL. */
+void sim_clock_advance_us(uint64_t us);
+
+
+/** @brief Thời gian mô phỏng hiện tại (us). */
+uint64_t sim_clock_now_us(void);
+
+
+/**
+ * @brief Nạp nội dung flash mô phỏng của nhật ký (Driver_Flash_*) từ một file ảnh.
+ * Dùng cùng sim_flash_save() để thử khôi phục nhật ký sau khi "khởi động lại".
+ * @param[in] path Đường dẫn file ảnh.
+ * @return 1 nếu đã nạp, 0 nếu file chưa có (flash trống), -1 nếu file sai kích thước.
+ */
+int sim_flash_load(const char* path);
+
+
+/**
+ * @brief Lưu nội dung flash mô phỏng của nhật ký vào một file ảnh.
+ * @param[in] path Đường dẫn file ảnh.
+ * @return 0 nếu thành công, -1 nếu lỗi.
+ */
+int sim_flash_save(const char* path);
+
+
+/** @brief Thời gian CPU thực của tiến trình (ns), dùng để đo chi phí. */
+uint64_t sim_cpu_time_ns(void);
+
+#endif /* HOST_SIM_H_ */
@@ -0,0 +1,686 @@
+/*
+ * SimDriver.c
+ *
+ *  Created on: Apr 28, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Driver.h trên máy host: khung được ghi thẳng ra đích mô phỏng (bộ nhớ, file, pty)
+ * thay cho USART2/DMA; bộ CRC phần cứng được thay bằng mô hình phần mềm.
+ */
+
+#define _GNU_SOURCE
+
+#include "Driver.h"
+#include "Sim.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Đủ cho một khung tối đa (tiêu đề mở rộng, payload 1024 byte và CRC-32) sau khi mã hóa COBS
+#define SIM_STAGE_SIZE 1048
+
+static uint8_t tx_stage[SIM_STAGE_SIZE];
+static driver_uart_tx_stats_t tx_stats[DRIVER_UART_TX_CLASSES];
+static uint8_t tx_stage_priority = DRIVER_UART_PRIORITY_BULK;
+
+static sim_sink_t sink_kind = SIM_SINK_MEMORY;
+static int sink_fd = -1;
+static char sink_pty_name[64];
+static uint8_t* sink_memory = NULL;
+static size_t sink_memory_length = 0;
+static size_t sink_memory_capacity = 0;
+static sim_sink_stats_t sink_stats;
+
+// Giới hạn tốc độ: thời điểm byte kế tiếp được phép rời "dây"
+static uint32_t sink_baud = 0;
+static uint64_t sink_wire_free_ns = 0;
+
+// Nhiễu trên "dây": mỗi byte bị lật một bit với xác suất sink_error_ppm / 10^6
+static uint32_t sink_error_ppm = 0;
+static uint32_t sink_error_seed = 1;
+
+// Tốc độ baud của "USART2", chỉ dùng để giới hạn tốc độ khi đích được mở với baud khác 0
+static uint32_t uart_baud = DRIVER_UART_BAUD_DEFAULT;
+
+// ADC mô phỏng: các khối "đầy" theo đồng hồ mô phỏng, giữ tối đa hai khối như bộ đệm ping-pong
+static uint32_t adc_rate = 0;
+static uint64_t adc_start_us = 0;
+static uint32_t adc_next_block = 0;             // Số thứ tự của khối kế tiếp được lấy ra
+static uint32_t adc_noise = 1;
+static uint16_t adc_block[DRIVER_ADC_BLOCK_SIZE];
+static driver_adc_stats_t adc_stats;
+
+// Cảm biến nhiệt độ mô phỏng: loạt xong sau samples x ~23 us, quanh 31 °C theo hiệu chuẩn điển hình
+#define SIM_TEMP_CONVERSION_US 23
+static uint16_t temp_samples = 0;
+static uint64_t temp_done_us = 0;
+
+// Nút nhấn mô phỏng: mỗi 2 s một lần nhấn giữ 300 ms, cả hai cạnh đều dội vài lần
+#define SIM_BUTTON_PERIOD_US 2000000u
+#define SIM_BUTTON_FIRST_US  1000000u
+static const struct { uint32_t offset_us; uint8_t level; } sim_button_script[] = {
+    { 0, 0 }, { 300, 1 }, { 800, 0 },
+    { 300000, 1 }, { 300400, 0 }, { 301000, 1 },
+};
+#define SIM_BUTTON_EDGES (sizeof(sim_button_script) / sizeof(sim_button_script[0]))
+static uint64_t button_next_edge = 0;           // Số thứ tự của cạnh kế tiếp trong kịch bản lặp
+
+// Flash mô phỏng: ghi chỉ xóa bit như flash thật, xóa sector mất SIM_FLASH_ERASE_US theo đồng hồ mô phỏng
+#define SIM_FLASH_ERASE_US 1000000u
+#define SIM_FLASH_WORDS    (DRIVER_FLASH_LOG_SECTOR_SIZE / sizeof(uint32_t))
+static uint32_t sim_flash[DRIVER_FLASH_LOG_SECTORS][SIM_FLASH_WORDS];
+static uint8_t  sim_flash_ready = 0;
+static uint8_t  sim_flash_erasing = 0xFF;
+static uint64_t sim_flash_erase_done_us = 0;
+
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+ * @brief Chờ cho đến khi dây truyền mô phỏng rảnh đủ để phát size byte (8N1, 10 bit/byte).
+ */
+static void sink_pace(size_t size)
+{
+    if (sink_baud == 0) {
+        return;
+    }
+
+    uint64_t now = monotonic_ns();
+    if (sink_wire_free_ns < now) {
+        sink_wire_free_ns = now;
+    }
+    sink_wire_free_ns += (uint64_t)size * 10u * 1000000000u / sink_baud;
+
+    if (sink_wire_free_ns > now) {
+        uint64_t wait = sink_wire_free_ns - now;
+        struct timespec ts = { (time_t)(wait / 1000000000u), (long)(wait % 1000000000u) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+
+static void sink_emit(const uint8_t* data, size_t size)
+{
+    sink_pace(size);
+
+    if (sink_kind == SIM_SINK_MEMORY) {
+        size_t room = sink_memory_capacity - sink_memory_length;
+        size_t n = (size < room) ? size : room;
+        memcpy(sink_memory + sink_memory_length, data, n);
+        sink_memory_length += n;
+        sink_stats.dropped += size - n;
+    } else if (sink_fd >= 0) {
+        while (size > 0) {
+            ssize_t n = write(sink_fd, data, size);
+            if (n <= 0) {
+                sink_stats.dropped += size;
+                return;
+            }
+            sink_stats.bytes += (uint64_t)n;
+            data += n;
+            size -= (size_t)n;
+        }
+        return;
+    }
+
+    sink_stats.bytes += size;
+}
+
+
+static void sink_write(const uint8_t* data, size_t size)
+{
+    uint8_t chunk[256];
+
+    if (sink_error_ppm == 0) {
+        sink_emit(data, size);
+        return;
+    }
+
+    while (size > 0) {
+        size_t n = (size < sizeof(chunk)) ? size : sizeof(chunk);
+        memcpy(chunk, data, n);
+        for (size_t i = 0; i < n; i++) {
+            sink_error_seed = sink_error_seed * 1103515245u + 12345u;
+            if ((sink_error_seed >> 8) % 1000000u < sink_error_ppm) {
+                chunk[i] ^= (uint8_t)(1u << ((sink_error_seed >> 4) & 7));
+                sink_stats.corrupted++;
+            }
+        }
+        sink_emit(chunk, n);
+        data += n;
+        size -= n;
+    }
+}
+
+
+int sim_sink_open(sim_sink_t sink, const char* path, uint32_t baud, size_t capacity)
+{
+    sim_sink_close();
+    memset(&sink_stats, 0, sizeof(sink_stats));
+    sink_kind = sink;
+    sink_baud = baud;
+    sink_wire_free_ns = 0;
+    uart_baud = baud ? baud : DRIVER_UART_BAUD_DEFAULT;
+
+    switch (sink) {
+    case SIM_SINK_MEMORY:
+        sink_memory = malloc(capacity);
+        if (sink_memory == NULL) {
+            return -1;
+        }
+        sink_memory_capacity = capacity;
+        sink_memory_length = 0;
+        return 0;
+
+    case SIM_SINK_FILE:
+        sink_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return (sink_fd >= 0) ? 0 : -1;
+
+    case SIM_SINK_PTY:
+        sink_fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (sink_fd < 0 || grantpt(sink_fd) != 0 || unlockpt(sink_fd) != 0 ||
+            ptsname_r(sink_fd, sink_pty_name, sizeof(sink_pty_name)) != 0) {
+            sim_sink_close();
+            return -1;
+        }
+
+        // Chế độ raw để line discipline không đổi 0x0A thành 0x0D 0x0A trong khung;
+        // đầu master không chặn để Driver_UART_Read() trả về ngay khi host chưa gửi gì
+        struct termios tio;
+        if (tcgetattr(sink_fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(sink_fd, TCSANOW, &tio);
+        }
+        fcntl(sink_fd, F_SETFL, fcntl(sink_fd, F_GETFL) | O_NONBLOCK);
+        return 0;
+    }
+
+    return -1;
+}
+
+
+void sim_sink_close(void)
+{
+    if (sink_fd >= 0) {
+        close(sink_fd);
+        sink_fd = -1;
+    }
+    free(sink_memory);
+    sink_memory = NULL;
+    sink_memory_length = 0;
+    sink_memory_capacity = 0;
+    sink_pty_name[0] = '\0';
+}
+
+
+const char* sim_sink_pty_name(void)
+{
+    return (sink_kind == SIM_SINK_PTY && sink_pty_name[0] != '\0') ? sink_pty_name : NULL;
+}
+
+
+const uint8_t* sim_sink_memory(size_t* length)
+{
+    if (length != NULL) {
+        *length = sink_memory_length;
+    }
+    return sink_memory;
+}
+
+
+void sim_sink_memory_reset(void)
+{
+    sink_memory_length = 0;
+}
+
+
+const sim_sink_stats_t* sim_sink_get_stats(void)
+{
+    return &sink_stats;
+}
+
+
+void sim_sink_set_error_rate(uint32_t ppm)
+{
+    sink_error_ppm = (ppm > 1000000u) ? 1000000u : ppm;
+}
+
+
+void Driver_UART_Send(const uint8_t* data, size_t size)
+{
+    if (data == NULL) {
+        return;
+    }
+
+    sink_stats.frames++;
+    tx_stats[DRIVER_UART_PRIORITY_BULK].frames++;
+    sink_write(data, size);
+}
+
+
+uint8_t* Driver_UART_Reserve(size_t size, uint8_t priority)
+{
+    if (size > SIM_STAGE_SIZE) {
+        return NULL;
+    }
+
+    tx_stage_priority = (priority < DRIVER_UART_TX_CLASSES) ? priority : DRIVER_UART_PRIORITY_BULK;
+    return tx_stage;
+}
+
+
+void Driver_UART_Commit(uint8_t* region, size_t size)
+{
+    if (region == NULL) {
+        return;
+    }
+
+    sink_stats.frames++;
+    tx_stats[tx_stage_priority].frames++;
+    sink_write(region, size);
+}
+
+
+void Driver_UART_SendV(const driver_uart_segment_t* segments, size_t count)
+{
+    if (segments == NULL) {
+        return;
+    }
+
+    sink_stats.frames++;
+    tx_stats[DRIVER_UART_PRIORITY_BULK].frames++;
+    for (size_t i = 0; i < count; i++) {
+        sink_write(segments[i].data, segments[i].size);
+    }
+}
+
+
+void Driver_UART_Flush(void)
+{
+}
+
+
+uint8_t Driver_UART_IsBusy(void)
+{
+    return 0;
+}
+
+
+size_t Driver_UART_GetTxSpace(uint8_t priority)
+{
+    (void)priority;
+    return SIM_STAGE_SIZE;
+}
+
+
+const driver_uart_tx_stats_t* Driver_UART_GetTxStats(uint8_t priority)
+{
+    if (priority >= DRIVER_UART_TX_CLASSES) {
+        return NULL;
+    }
+
+    return &tx_stats[priority];
+}
+
+
+void Driver_UART_ResetTxStats(void)
+{
+    memset(tx_stats, 0, sizeof(tx_stats));
+}
+
+
+void Driver_UART_RxStart(void)
+{
+}
+
+
+size_t Driver_UART_Read(uint8_t* data, size_t size)
+{
+    if (sink_kind != SIM_SINK_PTY || sink_fd < 0 || data == NULL) {
+        return 0;
+    }
+
+    ssize_t n = read(sink_fd, data, size);
+    return (n > 0) ? (size_t)n : 0;
+}
+
+
+uint32_t Driver_UART_GetRxErrors(void)
+{
+    return 0;
+}
+
+
+/**
+ * @brief Cùng phép tính bộ chia như Driver.c với PCLK1 = SIM_PCLK1_HZ.
+ */
+uint32_t Driver_UART_CheckBaud(uint32_t baud, uint8_t* oversampling)
+{
+    if (baud == 0) {
+        return 0;
+    }
+
+    uint32_t div = (SIM_PCLK1_HZ + baud / 2) / baud;
+    if (div < 8 || div > 0xFFFF) {
+        return 0;
+    }
+
+    uint32_t actual = SIM_PCLK1_HZ / div;
+    uint32_t error = (actual > baud) ? actual - baud : baud - actual;
+    if ((uint64_t)error * 1000u > (uint64_t)baud * DRIVER_UART_BAUD_TOLERANCE) {
+        return 0;
+    }
+
+    if (oversampling != NULL) {
+        *oversampling = (div >= 16) ? 16 : 8;
+    }
+    return actual;
+}
+
+
+uint8_t Driver_UART_SetBaud(uint32_t baud)
+{
+    if (Driver_UART_CheckBaud(baud, NULL) == 0) {
+        return 0;
+    }
+
+    uart_baud = baud;
+    if (sink_baud != 0) {
+        sink_baud = baud;
+    }
+    return 1;
+}
+
+
+uint32_t Driver_UART_GetBaud(void)
+{
+    return uart_baud;
+}
+
+
+uint32_t Driver_ADC_Start(uint32_t rate_hz)
+{
+    if (rate_hz == 0 || rate_hz > DRIVER_ADC_RATE_MAX) {
+        return 0;
+    }
+
+    adc_rate = rate_hz;
+    adc_start_us = sim_clock_now_us();
+    adc_next_block = 0;
+    memset(&adc_stats, 0, sizeof(adc_stats));
+    return rate_hz;
+}
+
+
+void Driver_ADC_Stop(void)
+{
+    adc_rate = 0;
+}
+
+
+/**
+ * @brief Khối đầy cũ nhất theo đồng hồ mô phỏng, với tín hiệu tam giác 12 bit cộng nhiễu nhỏ.
+ * Khi người gọi chậm hơn hai khối, các khối cũ nhất bị tính là ghi đè giống DMA vòng.
+ */
+const uint16_t* Driver_ADC_GetBlock(uint32_t* first_sample)
+{
+    if (adc_rate == 0) {
+        return NULL;
+    }
+
+    uint64_t due = (sim_clock_now_us() - adc_start_us) * adc_rate / 1000000u;
+    uint32_t done = (uint32_t)(due / DRIVER_ADC_BLOCK_SIZE);
+    adc_stats.samples = done * DRIVER_ADC_BLOCK_SIZE;
+
+    if (done - adc_next_block > 2) {
+        adc_stats.overruns += done - adc_next_block - 2;
+        adc_next_block = done - 2;
+    }
+    if (done == adc_next_block) {
+        return NULL;
+    }
+
+    *first_sample = adc_next_block * DRIVER_ADC_BLOCK_SIZE;
+    for (uint32_t i = 0; i < DRIVER_ADC_BLOCK_SIZE; i++) {
+        uint32_t phase = (*first_sample + i) & 0x3FF;
+        adc_noise = adc_noise * 1103515245u + 12345u;
+        adc_block[i] = (uint16_t)(((phase < 0x200) ? phase : 0x3FF - phase) * 6 + 512 + ((adc_noise >> 16) & 7));
+    }
+
+    adc_next_block++;
+    adc_stats.blocks++;
+    return adc_block;
+}
+
+
+void Driver_ADC_ReleaseBlock(void)
+{
+}
+
+
+const driver_adc_stats_t* Driver_ADC_GetStats(void)
+{
+    return &adc_stats;
+}
+
+
+void Driver_ADC_IRQHandler(void)
+{
+}
+
+
+uint8_t Driver_TempSensor_Start(uint16_t samples)
+{
+    if (samples == 0 || temp_samples > 0) {
+        return 0;
+    }
+
+    temp_samples = samples;
+    temp_done_us = sim_clock_now_us() + (uint64_t)samples * SIM_TEMP_CONVERSION_US;
+    return 1;
+}
+
+
+uint16_t Driver_TempSensor_Read(uint32_t* sum)
+{
+    if (temp_samples == 0 || sim_clock_now_us() < temp_done_us) {
+        return 0;
+    }
+
+    uint16_t count = temp_samples;
+    *sum = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        adc_noise = adc_noise * 1103515245u + 12345u;
+        *sum += 960 + ((adc_noise >> 16) & 7);
+    }
+
+    temp_samples = 0;
+    return count;
+}
+
+
+uint8_t Driver_TempSensor_GetCalibration(uint16_t* cal30, uint16_t* cal110)
+{
+    *cal30 = 959;
+    *cal110 = 1207;
+    return 1;
+}
+
+
+void Driver_TempSensor_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief Cạnh kế tiếp của kịch bản khi thời điểm của nó đã qua.
+ * Thời điểm của cạnh là thời điểm trong kịch bản, nên độ trễ đo được gồm cả khoảng chờ
+ *      đến lần gọi kế tiếp giống như cạnh nằm trong hàng đợi của ngắt EXTI.
+ */
+uint8_t Driver_Button_Read(driver_button_edge_t* edge)
+{
+    uint64_t cycle = button_next_edge / SIM_BUTTON_EDGES;
+    uint32_t index = (uint32_t)(button_next_edge % SIM_BUTTON_EDGES);
+    uint64_t at_us = SIM_BUTTON_FIRST_US + cycle * SIM_BUTTON_PERIOD_US + sim_button_script[index].offset_us;
+
+    if (sim_clock_now_us() < at_us) {
+        return 0;
+    }
+
+    edge->cycles = (uint32_t)(at_us * (SIM_CORE_HZ / 1000000u));
+    edge->level = sim_button_script[index].level;
+    button_next_edge++;
+    return 1;
+}
+
+
+uint8_t Driver_Button_GetLevel(void)
+{
+    return (button_next_edge == 0) ? 1 : sim_button_script[(button_next_edge - 1) % SIM_BUTTON_EDGES].level;
+}
+
+
+uint32_t Driver_Button_GetDropped(void)
+{
+    return 0;
+}
+
+
+void Driver_CRC32_Init(void)
+{
+}
+
+
+/**
+ * @brief Mô hình phần mềm của bộ CRC STM32F4: word little-endian nạp từ bit cao, đệm 0.
+ */
+uint32_t Driver_CRC32_Calculate(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < length; i += 4) {
+        uint32_t word = 0;
+        size_t n = (length - i < 4) ? length - i : 4;
+        memcpy(&word, data + i, n);
+
+        crc ^= word;
+        for (int bit = 0; bit < 32; bit++) {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+        }
+    }
+    return crc;
+}
+
+
+/**
+ * @brief Flash mới xuất xưởng: mọi sector đều trống.
+ */
+static void sim_flash_prepare(void)
+{
+    if (!sim_flash_ready) {
+        memset(sim_flash, 0xFF, sizeof(sim_flash));
+        sim_flash_ready = 1;
+    }
+}
+
+
+int sim_flash_load(const char* path)
+{
+    sim_flash_prepare();
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    size_t n = fread(sim_flash, 1, sizeof(sim_flash), file);
+    fclose(file);
+    return (n == sizeof(sim_flash)) ? 1 : -1;
+}
+
+
+int sim_flash_save(const char* path)
+{
+    sim_flash_prepare();
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    size_t n = fwrite(sim_flash, 1, sizeof(sim_flash), file);
+    fclose(file);
+    return (n == sizeof(sim_flash)) ? 0 : -1;
+}
+
+
+const uint32_t* Driver_Flash_GetSector(uint8_t sector)
+{
+    if (sector >= DRIVER_FLASH_LOG_SECTORS) {
+        return NULL;
+    }
+
+    sim_flash_prepare();
+    return sim_flash[sector];
+}
+
+
+uint8_t Driver_Flash_Program(uint8_t sector, uint32_t offset, const uint32_t* words, uint16_t count)
+{
+    if (sector >= DRIVER_FLASH_LOG_SECTORS || (offset & 3u) != 0 || words == NULL ||
+        offset + (uint32_t)count * sizeof(uint32_t) > DRIVER_FLASH_LOG_SECTOR_SIZE ||
+        Driver_Flash_GetState() == DRIVER_FLASH_BUSY) {
+        return 0;
+    }
+
+    sim_flash_prepare();
+    for (uint16_t i = 0; i < count; i++) {
+        sim_flash[sector][offset / sizeof(uint32_t) + i] &= words[i];
+    }
+    return 1;
+}
+
+
+uint8_t Driver_Flash_EraseStart(uint8_t sector)
+{
+    if (sector >= DRIVER_FLASH_LOG_SECTORS || Driver_Flash_GetState() == DRIVER_FLASH_BUSY) {
+        return 0;
+    }
+
+    sim_flash_erasing = sector;
+    sim_flash_erase_done_us = sim_clock_now_us() + SIM_FLASH_ERASE_US;
+    return 1;
+}
+
+
+/**
+ * @brief Lần xóa đang chạy kết thúc khi đồng hồ mô phỏng vượt qua thời điểm xong.
+ */
+uint8_t Driver_Flash_GetState(void)
+{
+    if (sim_flash_erasing >= DRIVER_FLASH_LOG_SECTORS) {
+        return DRIVER_FLASH_IDLE;
+    }
+    if (sim_clock_now_us() < sim_flash_erase_done_us) {
+        return DRIVER_FLASH_BUSY;
+    }
+
+    sim_flash_prepare();
+    memset(sim_flash[sim_flash_erasing], 0xFF, sizeof(sim_flash[0]));
+    sim_flash_erasing = 0xFF;
+    return DRIVER_FLASH_IDLE;
+}
+
+
+void Driver_Flash_IRQHandler(void)
+{
+}
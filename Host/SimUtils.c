@@ -0,0 +1,115 @@
+/*
+ * SimUtils.c
+ *
+ *  Created on: Apr 28, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Utils.h trên máy host: đồng hồ mô phỏng thay cho HAL_GetTick() và DWT CYCCNT.
+ */
+
+#include "Sim.h"
+#include "Utils.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+uint32_t SystemCoreClock = SIM_CORE_HZ;
+
+static sim_clock_mode_t clock_mode = SIM_CLOCK_MANUAL;
+static uint64_t clock_manual_us = 0;
+static uint64_t clock_origin_ns = 0;
+
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+void sim_clock_init(sim_clock_mode_t mode)
+{
+    clock_mode = mode;
+    clock_manual_us = 0;
+    clock_origin_ns = monotonic_ns();
+}
+
+
+void sim_clock_advance_us(uint64_t us)
+{
+    clock_manual_us += us;
+}
+
+
+uint64_t sim_clock_now_us(void)
+{
+    if (clock_mode == SIM_CLOCK_REAL) {
+        return (monotonic_ns() - clock_origin_ns) / 1000u;
+    }
+    return clock_manual_us;
+}
+
+
+uint64_t sim_cpu_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+uint32_t Driver_GetTimeMs(void)
+{
+    return (uint32_t)(sim_clock_now_us() / 1000u);
+}
+
+
+void Driver_CycleCounterInit(void)
+{
+}
+
+
+uint32_t Driver_GetCycles(void)
+{
+    return (uint32_t)Driver_GetCycles64();
+}
+
+
+uint64_t Driver_GetCycles64(void)
+{
+    return sim_clock_now_us() * (SIM_CORE_HZ / 1000000u);
+}
+
+
+uint32_t Driver_GetTimeUs(void)
+{
+    return (uint32_t)sim_clock_now_us();
+}
+
+
+uint32_t Driver_CyclesToUs(uint32_t cycles)
+{
+    return cycles / (SIM_CORE_HZ / 1000000u);
+}
+
+
+uint16_t format_line(char *buffer, size_t size, const char *format, ...)
+{
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, size, format, args);
+    va_end(args);
+
+    if (len < 0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+
+    return (len >= (int)size) ? (uint16_t)(size - 1) : (uint16_t)len;
+}
@@ -0,0 +1,274 @@
+/*
+ * decoder_bench.cpp
+ *
+ *  Created on: Apr 24, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Đo tốc độ của FrameDecoder trên một bản ghi luồng tổng hợp nhiều MB: tỉ lệ các
+ * loại khung giống firmware (ADC 50 Hz, ngày/giờ, chuỗi, khung gộp, khung mở rộng),
+ * có chèn byte rác và khung hỏng để đo cả đường tìm lại tiêu đề.
+ *
+ * Cách dùng: decoder_bench [MB] [chunk_bytes] [capture.bin|-] [raw|cobs]
+ *      cobs: mọi khung được mã hóa COBS như firmware build với PROTOCOL_COBS=1;
+ *      byte rác hoặc byte phân cách hỏng làm mất thêm đúng một khung.
+ */
+
+#include "FrameDecoder.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace telemetry;
+
+namespace {
+
+constexpr int BENCH_PASSES = 5;
+
+struct Capture {
+    std::vector<uint8_t> bytes;
+    uint64_t frames    = 0;                      // Số khung đã ghi
+    uint64_t corrupted = 0;                      // Số khung bị làm hỏng một byte
+    uint64_t records   = 0;                      // Số bản ghi trong các khung còn nguyên
+};
+
+
+void put_u16(std::vector<uint8_t>& out, uint16_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put_u32(std::vector<uint8_t>& out, uint32_t value)
+{
+    put_u16(out, static_cast<uint16_t>(value));
+    put_u16(out, static_cast<uint16_t>(value >> 16));
+}
+
+
+// Đóng khung payload theo cùng định dạng với reserve_packet()/commit_packet()
+void append_frame(std::vector<uint8_t>& out, const std::vector<uint8_t>& payload, uint32_t time_us, uint8_t flags)
+{
+    size_t start = out.size();
+    out.push_back(HEADER_BYTE1);
+    if (flags != 0) {
+        out.push_back(HEADER_BYTE2_EXT);
+        out.push_back(flags);
+    } else {
+        out.push_back(HEADER_BYTE2);
+    }
+    if (flags & FRAME_FLAG_TS32) {
+        put_u32(out, time_us);
+    } else {
+        put_u16(out, static_cast<uint16_t>(time_us / 1000));
+    }
+    put_u16(out, static_cast<uint16_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+
+    if (flags & FRAME_FLAG_CRC32) {
+        put_u32(out, crc32_stm32(out.data() + start, out.size() - start));
+    } else {
+        put_u16(out, crc16_modbus(out.data() + start, out.size() - start));
+    }
+}
+
+
+// Mã hóa COBS phần out[start:] tại chỗ và thêm byte phân cách, giống cobs_encode_*() của Lib/Src/Cobs.c
+void cobs_encode_tail(std::vector<uint8_t>& out, size_t start)
+{
+    std::vector<uint8_t> raw(out.begin() + start, out.end());
+    out.resize(start);
+
+    size_t code = out.size();
+    out.push_back(1);
+    for (uint8_t byte : raw) {
+        if (byte != 0) {
+            out.push_back(byte);
+            out[code]++;
+        }
+        if (byte == 0 || out[code] == 0xFF) {
+            code = out.size();
+            out.push_back(1);
+        }
+    }
+    out.push_back(0);
+}
+
+
+std::vector<uint8_t> adc_record(uint32_t sample, uint16_t value)
+{
+    std::vector<uint8_t> r{ ADC_STREAM_DATA_ID };
+    put_u32(r, sample);
+    put_u16(r, value);
+    return r;
+}
+
+std::vector<uint8_t> string_record(size_t length)
+{
+    std::vector<uint8_t> r{ HELLO_WORLD_DATA_ID };
+    put_u16(r, static_cast<uint16_t>(length));
+    for (size_t i = 0; i < length; i++) {
+        r.push_back(static_cast<uint8_t>('a' + i % 26));
+    }
+    return r;
+}
+
+
+Capture make_capture(size_t target_bytes, Framing framing)
+{
+    Capture capture;
+    bool lose_next = false;                      // Byte rác hoặc byte phân cách hỏng dính vào khung kế
+    std::mt19937 rng(12345);
+    uint32_t time_us = 0;
+    uint32_t sample  = 0;
+
+    capture.bytes.reserve(target_bytes + MAX_FRAME_SIZE);
+
+    while (capture.bytes.size() < target_bytes) {
+        std::vector<uint8_t> payload;
+        uint32_t records = 1;
+        uint8_t  flags   = 0;
+        uint32_t kind    = rng() % 100;
+
+        if (kind < 70) {
+            payload = adc_record(sample++, static_cast<uint16_t>(rng() & 0xFFF));
+        } else if (kind < 78) {
+            payload = string_record(11);
+        } else if (kind < 80) {
+            payload = string_record(1 + rng() % (MAX_PAYLOAD_SIZE - 3));
+        } else if (kind < 84) {
+            payload = { DATE_STREAM_DATA_ID };
+            put_u32(payload, 5); put_u32(payload, 10); put_u32(payload, 2025);
+        } else if (kind < 88) {
+            payload = { TIME_STREAM_DATA_ID, 12 };
+            put_u16(payload, 34); put_u16(payload, 56);
+        } else if (kind < 90) {
+            payload = { BUTTON_STATE_DATA_ID, 0 };
+            put_u16(payload, 1);
+        } else if (kind < 92) {
+            payload = { MCU_TEMPERATURE_DATA_ID };
+            put_u16(payload, 41);
+        } else {
+            // Khung gộp 40 mẫu ADC, một phần dùng khung mở rộng CRC-32/timestamp us
+            payload = { BATCH_DATA_ID, 40 };
+            for (int i = 0; i < 40; i++) {
+                std::vector<uint8_t> r = adc_record(sample++, static_cast<uint16_t>(rng() & 0xFFF));
+                payload.insert(payload.end(), r.begin(), r.end());
+            }
+            records = 40;
+            flags = static_cast<uint8_t>(rng() % 4);
+        }
+
+        // Thỉnh thoảng có byte rác giữa hai khung, kể cả 0xDE giả
+        if (rng() % 200 == 0) {
+            size_t garbage = 1 + rng() % 16;
+            for (size_t i = 0; i < garbage; i++) {
+                capture.bytes.push_back((i == 0) ? HEADER_BYTE1 : static_cast<uint8_t>(rng()));
+            }
+            lose_next = lose_next || (framing == Framing::COBS && capture.bytes.back() != 0);
+        }
+
+        size_t start = capture.bytes.size();
+        append_frame(capture.bytes, payload, time_us, flags);
+        if (framing == Framing::COBS) {
+            cobs_encode_tail(capture.bytes, start);
+        }
+        capture.frames++;
+        time_us += 20000;
+
+        bool lost = lose_next;
+        lose_next = false;
+        if (rng() % 1000 == 0) {
+            size_t at = start + rng() % (capture.bytes.size() - start);
+            capture.bytes[at] ^= static_cast<uint8_t>(1 + rng() % 255);
+            lost = true;
+            lose_next = (framing == Framing::COBS && at == capture.bytes.size() - 1);
+        }
+        if (lost) {
+            capture.corrupted++;
+        } else {
+            capture.records += records;
+        }
+    }
+
+    return capture;
+}
+
+
+class CountingHandler : public RecordHandler {
+public:
+    uint64_t adc_sum = 0;
+    uint64_t text_bytes = 0;
+
+    void on_adc(const FrameInfo&, const AdcRecord& r) override { adc_sum += r.value; }
+    void on_string(const FrameInfo&, const StringRecord& r) override { text_bytes += r.text.size(); }
+};
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 8;
+    size_t chunk     = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    Framing framing  = (argc > 4 && std::strcmp(argv[4], "cobs") == 0) ? Framing::COBS : Framing::RAW;
+    if (megabytes == 0 || chunk == 0) {
+        std::fprintf(stderr, "usage: %s [MB] [chunk_bytes] [capture.bin] [raw|cobs]\n", argv[0]);
+        return 2;
+    }
+
+    Capture capture = make_capture(megabytes << 20, framing);
+
+    if (argc > 3 && std::strcmp(argv[3], "-") != 0) {
+        FILE* f = std::fopen(argv[3], "wb");
+        if (f == nullptr) {
+            std::perror(argv[3]);
+            return 2;
+        }
+        std::fwrite(capture.bytes.data(), 1, capture.bytes.size(), f);
+        std::fclose(f);
+    }
+
+    double best_s = 1e30;
+    DecoderStats stats{};
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        CountingHandler handler;
+        FrameDecoder decoder(handler, framing);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < capture.bytes.size(); offset += chunk) {
+            size_t n = std::min(chunk, capture.bytes.size() - offset);
+            decoder.feed(capture.bytes.data() + offset, n);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (elapsed < best_s) {
+            best_s = elapsed;
+        }
+        stats = decoder.stats();
+    }
+
+    std::printf("capture  %.1f MB, %llu frames (%llu corrupted), chunk %zu B\n",
+                capture.bytes.size() / 1048576.0, (unsigned long long)capture.frames,
+                (unsigned long long)capture.corrupted, chunk);
+    std::printf("decoded  %llu frames, %llu records, %llu crc errors, %llu payload errors, %llu skipped bytes, "
+                "%llu framing errors\n",
+                (unsigned long long)stats.frames, (unsigned long long)stats.records,
+                (unsigned long long)stats.crc_errors, (unsigned long long)stats.payload_errors,
+                (unsigned long long)stats.skipped_bytes, (unsigned long long)stats.framing_errors);
+    std::printf("speed    %.2f Mframes/s, %.1f MB/s, %.1f ns/frame (best of %d)\n",
+                stats.frames / best_s / 1e6, capture.bytes.size() / best_s / 1048576.0,
+                best_s * 1e9 / stats.frames, BENCH_PASSES);
+
+    // Mọi khung còn nguyên phải được giải mã đúng một lần
+    uint64_t expected = capture.frames - capture.corrupted;
+    if (stats.frames != expected || stats.records != capture.records || stats.payload_errors != 0) {
+        std::printf("FAIL: expected %llu frames, %llu records\n",
+                    (unsigned long long)expected, (unsigned long long)capture.records);
+        return 1;
+    }
+    return 0;
+}
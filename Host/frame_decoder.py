@@ -0,0 +1,215 @@
+"""
+Lớp bọc ctypes cho bộ giải mã khung C++ (libframedecoder.so, xem FrameDecoderC.h).
+
+NativeDecoder.feed() nhận một đoạn byte bất kỳ và trả về danh sách (frame, payload_info)
+có cùng dạng với decode_frame()/decode_payload() của py.py, nên py.py dùng được
+trực tiếp mà không đổi phần ghi CSV/log.
+
+Chạy trực tiếp để so tốc độ với bộ giải mã Python thuần trên một bản ghi luồng:
+    python3 frame_decoder.py build/capture.bin
+"""
+
+import ctypes
+import os
+
+_LIB_PATH = os.environ.get(
+    "FRAME_DECODER_LIB",
+    os.path.join(os.path.dirname(os.path.abspath(__file__)), "build", "libframedecoder.so"))
+
+PROFILER_PROBES = ["pack_packet", "calculate_crc16", "send_packet", "commit_packet", "uart_transmit"]
+LINK_OPS = ["", "propose", "accept", "reject", "probe", "probe_ack", "commit", "commit_ack",
+            "keepalive", "status"]
+COMMAND_OPS = ["", "rate", "enable", "disable", "snapshot", "get"]
+COMMAND_STATUS = ["ok", "bad_stream", "bad_value", "unsupported"]
+RELIABLE_OPS = ["", "enable", "disable", "ack", "status"]
+FLASH_LOG_OPS = ["", "present", "dump", "status", "end"]
+FRAME_FLAG_SEQ = 0x04
+
+
+class _Frame(ctypes.Structure):
+    _fields_ = [
+        ("valid", ctypes.c_uint8),
+        ("flags", ctypes.c_uint8),
+        ("payload_size", ctypes.c_uint16),
+        ("seq", ctypes.c_uint16),
+        ("timestamp", ctypes.c_uint32),
+        ("timestamp_us", ctypes.c_uint64),
+        ("timestamp_wrap_us", ctypes.c_uint64),
+        ("checksum", ctypes.c_uint32),
+        ("computed_crc", ctypes.c_uint32),
+        ("payload", ctypes.c_void_p),
+    ]
+
+
+class _Record(ctypes.Structure):
+    _fields_ = [
+        ("data_id", ctypes.c_uint8),
+        ("data_length", ctypes.c_uint16),
+        ("values", ctypes.c_uint32 * 6),
+        ("data", ctypes.c_void_p),
+    ]
+
+
+class _Stats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_uint64) for name in
+                ("bytes", "frames", "records", "crc_errors", "payload_errors", "skipped_bytes",
+                 "framing_errors")]
+
+
+_RECORD_CB = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.POINTER(_Frame), ctypes.POINTER(_Record))
+_FRAME_CB = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.POINTER(_Frame))
+
+_lib = ctypes.CDLL(_LIB_PATH)
+_lib.frame_decoder_create.restype = ctypes.c_void_p
+_lib.frame_decoder_create.argtypes = [_RECORD_CB, _FRAME_CB, ctypes.c_void_p]
+_lib.frame_decoder_destroy.argtypes = [ctypes.c_void_p]
+_lib.frame_decoder_feed.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+_lib.frame_decoder_reset.argtypes = [ctypes.c_void_p]
+_lib.frame_decoder_set_cobs.argtypes = [ctypes.c_void_p, ctypes.c_uint8]
+_lib.frame_decoder_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Stats)]
+
+
+class NativeDecoder:
+    def __init__(self, cobs=False):
+        self._records = []
+        self._results = []
+        # Giữ tham chiếu đến callback để chúng không bị thu gom khi thư viện còn dùng
+        self._record_cb = _RECORD_CB(self._on_record)
+        self._frame_cb = _FRAME_CB(self._on_frame)
+        self._handle = _lib.frame_decoder_create(self._record_cb, self._frame_cb, None)
+        if not self._handle:
+            raise MemoryError("frame_decoder_create failed")
+        if cobs:
+            # Khung COBS của firmware build với PROTOCOL_COBS=1, tách ở byte 0
+            _lib.frame_decoder_set_cobs(self._handle, 1)
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            _lib.frame_decoder_destroy(self._handle)
+            self._handle = None
+
+    def feed(self, data):
+        """Nạp dữ liệu, trả về danh sách (frame, payload_info) của mọi khung đã đủ."""
+        self._results = []
+        data = bytes(data)
+        _lib.frame_decoder_feed(self._handle, data, len(data))
+        return self._results
+
+    def reset(self):
+        _lib.frame_decoder_reset(self._handle)
+        self._records = []
+
+    def stats(self):
+        s = _Stats()
+        _lib.frame_decoder_get_stats(self._handle, ctypes.byref(s))
+        return {name: getattr(s, name) for name, _ in _Stats._fields_}
+
+    def _on_record(self, _user, _frame, record_ptr):
+        r = record_ptr.contents
+        v = r.values
+        data_id = r.data_id
+        if data_id == 1:
+            self._records.append(("Date", v[0], v[1], v[2]))
+        elif data_id == 2:
+            self._records.append(("Time", v[0], v[1], v[2]))
+        elif data_id == 3:
+            self._records.append(("ADC", v[0], v[1]))
+        elif data_id == 4:
+            text = ctypes.string_at(r.data, r.data_length).decode('utf-8', errors='replace')
+            self._records.append(("String", text))
+        elif data_id == 5:
+            self._records.append(("Button", v[0], v[1]))
+        elif data_id == 6:
+            self._records.append(("Temperature", ctypes.c_int32(v[0]).value / 100))
+        elif data_id == 8:
+            raw = ctypes.string_at(r.data, r.data_length)
+            histogram = [int.from_bytes(raw[i:i+2], 'little') for i in range(0, len(raw), 2)]
+            probe = v[0]
+            self._records.append(("ProfilerProbe", v[5], {
+                "name": PROFILER_PROBES[probe] if probe < len(PROFILER_PROBES) else f"probe{probe}",
+                "count": v[1], "min": v[2], "max": v[3], "mean": v[4], "histogram": histogram,
+            }))
+        elif data_id == 9:
+            op = v[0]
+            self._records.append(("Link", LINK_OPS[op] if op < len(LINK_OPS) else f"op{op}", v[1], v[2]))
+        elif data_id == 11:
+            op, status = v[0] & 0x7F, v[2]
+            self._records.append(("Command", COMMAND_OPS[op] if op < len(COMMAND_OPS) else f"op{op}", v[1],
+                                  COMMAND_STATUS[status] if status < len(COMMAND_STATUS) else f"status{status}",
+                                  v[3]))
+        elif data_id == 12:
+            op = v[0]
+            self._records.append(("Reliable", RELIABLE_OPS[op] if op < len(RELIABLE_OPS) else f"op{op}", v[1], v[2]))
+        elif data_id == 13:
+            op = v[0]
+            self._records.append(("FlashLog", FLASH_LOG_OPS[op] if op < len(FLASH_LOG_OPS) else f"op{op}", v[1], v[2]))
+        else:
+            self._records.append(None)
+
+    def _on_frame(self, _user, frame_ptr):
+        f = frame_ptr.contents
+        payload = ctypes.string_at(f.payload, f.payload_size) if f.payload_size else b''
+        frame = {
+            "flags": f.flags,
+            "timestamp": f.timestamp,
+            "timestamp_us": f.timestamp_us,
+            "timestamp_wrap_us": f.timestamp_wrap_us,
+            "seq": f.seq if f.flags & FRAME_FLAG_SEQ else None,
+            "payload_size": f.payload_size,
+            "payload": payload,
+            "checksum": f.checksum,
+            "computed_crc": f.computed_crc,
+            "valid": bool(f.valid),
+        }
+
+        records, self._records = self._records, []
+        info = None
+        if f.valid and payload:
+            if payload[0] == 7:
+                info = ("Batch", records)
+            elif payload[0] == 10:
+                info = ("AdcBlock", records)
+            elif payload[0] == 8 and records:
+                info = ("Profiler", records[0][1], [r[2] for r in records])
+            elif records:
+                info = records[0]
+        self._results.append((frame, info))
+
+
+def _benchmark(path):
+    import sys
+    import time
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+    import py
+
+    with open(path, "rb") as f:
+        capture = f.read()
+
+    decoder = NativeDecoder()
+    start = time.perf_counter()
+    native_frames = 0
+    for offset in range(0, len(capture), 4096):
+        native_frames += sum(1 for frame, _ in decoder.feed(capture[offset:offset+4096]) if frame["valid"])
+    native_s = time.perf_counter() - start
+    print(f"native  {native_frames} frames in {native_s:.2f} s: {native_frames / native_s:,.0f} frames/s")
+
+    # Bộ giải mã Python thuần chỉ chạy trên phần đầu vì quá chậm với cả bản ghi
+    buffer = bytearray(capture[:256 * 1024])
+    start = time.perf_counter()
+    python_frames = 0
+    while True:
+        frame, rest = py.decode_frame(buffer)
+        if frame is None and len(rest) == len(buffer):
+            break
+        buffer = rest
+        if frame and frame["valid"]:
+            py.decode_payload(frame)
+            python_frames += 1
+    python_s = time.perf_counter() - start
+    print(f"python  {python_frames} frames in {python_s:.2f} s: {python_frames / python_s:,.0f} frames/s "
+          "(first 256 KiB)")
+
+
+if __name__ == "__main__":
+    import sys
+    _benchmark(sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), "build", "capture.bin"))
@@ -0,0 +1,436 @@
+/*
+ * protocol_bench.c
+ *
+ *  Created on: Apr 28, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Chạy Protocol.c/Application.c trên máy host với driver mô phỏng.
+ *
+ * protocol_bench [scale]
+ *      Đo từng loại luồng vào đích bộ nhớ: số khung/s, byte/s, ns CPU mỗi khung và
+ *      chi phí CRC của khung đó; mọi khung được kiểm tra lại checksum.
+ * protocol_bench stream <memory|file|pty> [path] [baud] [seconds] [error_ppm] [flash_image]
+ *      Phát luồng giống main.c theo thời gian thực, ví dụ vào pty cho py.py --port;
+ *      với pty, khung điều khiển liên kết từ host (py.py --negotiate) được xử lý như trên board.
+ *      error_ppm lật bit ngẫu nhiên trên đường truyền để thử chế độ tin cậy (build với
+ *      RELIABLE_ENABLED=1, py.py --reliable).
+ *      flash_image (build với FLASH_LOG_ENABLED=1) nạp và lưu lại flash mô phỏng của nhật ký,
+ *      để lần chạy sau phát lại những gì được lưu khi không có host (py.py --drain).
+ */
+
+#include "Acquisition.h"
+#include "Application.h"
+#include "Batch.h"
+#include "Button.h"
+#include "Cobs.h"
+#include "Command.h"
+#include "Crc16.h"
+#include "Driver.h"
+#include "FlashLog.h"
+#include "Link.h"
+#include "Profiler.h"
+#include "Protocol.h"
+#include "Reliable.h"
+#include "Scheduler.h"
+#include "Stats.h"
+#include "Sim.h"
+#include "Temperature.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_SINK_CAPACITY  (8u << 20)
+#define BENCH_CRC_ITERATIONS 20000u
+
+typedef struct {
+    const char *name;
+    void (*send)(uint32_t i);
+    uint32_t iterations;
+    uint8_t batched;                             // Luồng ADC đi qua khung gộp
+    uint16_t samples;                            // Số mẫu ADC mỗi lần gửi, 0 với luồng khác
+} bench_stream_t;
+
+#define BENCH_ADC_BLOCK 64
+
+static uint8_t bench_string[MAX_STRING_LEN];
+static uint16_t bench_adc_smooth[BENCH_ADC_BLOCK];
+static uint16_t bench_adc_noisy[BENCH_ADC_BLOCK];
+#if PROTOCOL_COBS
+static uint8_t bench_frame[FRAME_HEADER_SIZE_OF(0xFF) + MAX_PAYLOAD_SIZE + sizeof(uint32_t)];
+static uint8_t bench_first_frame[sizeof(bench_frame)];
+#endif
+
+
+static void send_date(uint32_t i)        { send_date_data(5, 10, 2025 + (i & 1)); }
+static void send_time(uint32_t i)        { send_time_data(i % 24, i % 60, i % 60); }
+static void send_adc(uint32_t i)         { send_adc_data(i, (uint16_t)(i & 0xFFF)); }
+static void send_button(uint32_t i)      { send_button_data(0, (uint16_t)(i & 1)); }
+static void send_temp(uint32_t i)        { send_temperature((int16_t)(3100 + (i & 63))); }
+static void send_string_short(uint32_t i){ (void)i; send_string_data(11, bench_string); }
+static void send_string_max(uint32_t i)  { (void)i; send_string_data(MAX_STRING_LEN, bench_string); }
+static void send_block_smooth(uint32_t i){ send_adc_block(i * BENCH_ADC_BLOCK, bench_adc_smooth, BENCH_ADC_BLOCK); }
+static void send_block_noisy(uint32_t i) { send_adc_block(i * BENCH_ADC_BLOCK, bench_adc_noisy, BENCH_ADC_BLOCK); }
+
+static const bench_stream_t bench_streams[] = {
+    { "date",        send_date,         200000, 0, 0 },
+    { "time",        send_time,         200000, 0, 0 },
+    { "adc",         send_adc,          200000, 0, 1 },
+    { "adc_batched", send_adc,          200000, 1, 1 },
+    { "adc_block",   send_block_smooth,  20000, 0, BENCH_ADC_BLOCK },
+    { "adc_noisy",   send_block_noisy,   20000, 0, BENCH_ADC_BLOCK },
+    { "button",      send_button,       200000, 0, 0 },
+    { "temperature", send_temp,         200000, 0, 0 },
+    { "string_11",   send_string_short, 200000, 0, 0 },
+    { "string_max",  send_string_max,    20000, 0, 0 },
+};
+
+
+/**
+ * @brief Kiểm tra một khung chưa mã hóa bắt đầu tại frame.
+ * Tiêu đề được đọc theo cờ của khung, kể cả số thứ tự khi chế độ tin cậy đang bật.
+ * @return Độ dài phần được tính checksum, 0 nếu khung sai.
+ * @param[out] frame_length Độ dài cả khung.
+ */
+static size_t verify_frame(const uint8_t *frame, size_t length, size_t *frame_length)
+{
+    uint8_t flags = 0;
+    size_t offset = 2;
+
+    if (length < PACKET_OVERHEAD || frame[0] != HEADER_BYTE1) {
+        return 0;
+    }
+    if (frame[1] == HEADER_BYTE2_EXT) {
+        flags = frame[2];
+        offset = 3;
+    } else if (frame[1] != HEADER_BYTE2) {
+        return 0;
+    }
+
+    offset += (flags & FRAME_FLAG_TS32) ? 4 : 2;
+    offset += (flags & FRAME_FLAG_SEQ) ? 2 : 0;
+    if (offset + 2 > length) {
+        return 0;
+    }
+    size_t crc_length = offset + 2 + (size_t)(frame[offset] | (frame[offset + 1] << 8));
+    size_t checksum_size = (flags & FRAME_FLAG_CRC32) ? 4 : 2;
+    if (crc_length + checksum_size > length) {
+        return 0;
+    }
+
+    const uint8_t *checksum = frame + crc_length;
+    if (flags & FRAME_FLAG_CRC32) {
+        uint32_t crc = (uint32_t)checksum[0] | ((uint32_t)checksum[1] << 8) |
+                       ((uint32_t)checksum[2] << 16) | ((uint32_t)checksum[3] << 24);
+        if (crc != Driver_CRC32_Calculate(frame, crc_length)) {
+            return 0;
+        }
+    } else if ((uint16_t)(checksum[0] | (checksum[1] << 8)) != calculate_crc16((uint8_t*)frame, (uint16_t)crc_length)) {
+        return 0;
+    }
+
+    *frame_length = crc_length + checksum_size;
+    return crc_length;
+}
+
+
+/**
+ * @brief Kiểm tra và đếm các khung trong dữ liệu đã ghi.
+ * Với PROTOCOL_COBS, mỗi khung được giải mã vào bench_frame trước khi kiểm tra
+ *      và phải có độ dài khớp đúng với tiêu đề.
+ * @return Số khung hợp lệ, -1 nếu gặp khung sai.
+ * @param[out] first_frame  Khung đầu tiên (chưa mã hóa).
+ * @param[out] first_length Độ dài phần được tính checksum của khung đầu tiên.
+ */
+static long verify_frames(const uint8_t *data, size_t length, const uint8_t **first_frame, size_t *first_length)
+{
+    long frames = 0;
+    size_t pos = 0;
+
+    while (pos < length) {
+        const uint8_t *frame = data + pos;
+        size_t available = length - pos;
+        size_t frame_length = 0;
+#if PROTOCOL_COBS
+        const uint8_t *end = memchr(frame, COBS_DELIMITER, available);
+        if (end == NULL) {
+            return -1;
+        }
+        pos += (size_t)(end - frame) + 1;
+        available = cobs_decode(bench_frame, sizeof(bench_frame), frame, (size_t)(end - frame));
+        frame = bench_frame;
+#endif
+
+        size_t crc_length = verify_frame(frame, available, &frame_length);
+        if (crc_length == 0) {
+            return -1;
+        }
+#if PROTOCOL_COBS
+        if (frame_length != available) {
+            return -1;
+        }
+#else
+        pos += frame_length;
+#endif
+
+        if (frames == 0 && first_length != NULL) {
+            *first_length = crc_length;
+            *first_frame = data;
+#if PROTOCOL_COBS
+            memcpy(bench_first_frame, bench_frame, frame_length);
+            *first_frame = bench_first_frame;
+#endif
+        }
+        frames++;
+    }
+
+    return frames;
+}
+
+
+/**
+ * @brief Đo chi phí tính checksum của một khung có crc_length byte.
+ */
+static double crc_ns_per_frame(const uint8_t *frame, size_t crc_length)
+{
+    volatile uint32_t sink = 0;
+    uint64_t start = sim_cpu_time_ns();
+
+    for (uint32_t n = 0; n < BENCH_CRC_ITERATIONS; n++) {
+#if PROTOCOL_CRC32_HW
+        sink += Driver_CRC32_Calculate(frame, crc_length);
+#else
+        sink += calculate_crc16((uint8_t*)frame, (uint16_t)crc_length);
+#endif
+    }
+
+    (void)sink;
+    return (double)(sim_cpu_time_ns() - start) / BENCH_CRC_ITERATIONS;
+}
+
+
+static int run_benchmark(double scale)
+{
+    double wire_bytes_per_sample[sizeof(bench_streams) / sizeof(bench_streams[0])] = { 0 };
+    int failed = 0;
+
+    if (sim_sink_open(SIM_SINK_MEMORY, NULL, 0, BENCH_SINK_CAPACITY) != 0) {
+        fprintf(stderr, "cannot allocate memory sink\n");
+        return 1;
+    }
+    sim_clock_init(SIM_CLOCK_MANUAL);
+
+    printf("engine=%d crc32_hw=%d ts_us=%d cobs=%d\n", CRC16_ENGINE, PROTOCOL_CRC32_HW, DRIVER_TIMESTAMP_US,
+           PROTOCOL_COBS);
+    printf("%-12s %9s %12s %10s %10s %10s %7s\n",
+           "stream", "frames", "frames/s", "MB/s", "ns/frame", "crc ns", "crc %");
+
+    for (size_t s = 0; s < sizeof(bench_streams) / sizeof(bench_streams[0]); s++) {
+        const bench_stream_t *stream = &bench_streams[s];
+        uint32_t iterations = (uint32_t)(stream->iterations * scale);
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        uint64_t cpu_ns = 0;
+        const uint8_t *crc_frame = NULL;
+        size_t crc_length = 0;
+        double crc_ns = 0;
+
+        batch_set_stream(ADC_STREAM_DATA_ID, stream->batched);
+        sim_sink_memory_reset();
+
+        for (uint32_t i = 0; i < iterations; ) {
+            // Đo theo từng đợt để bộ đệm của đích không bao giờ đầy
+            const sim_sink_stats_t *stats = sim_sink_get_stats();
+            uint64_t frames_before = stats->frames;
+            uint64_t bytes_before = stats->bytes;
+
+            uint64_t start = sim_cpu_time_ns();
+            while (i < iterations && stats->bytes - bytes_before < BENCH_SINK_CAPACITY / 2) {
+                stream->send(i++);
+            }
+            if (i == iterations) {
+                batch_flush();
+            }
+            cpu_ns += sim_cpu_time_ns() - start;
+
+            frames += stats->frames - frames_before;
+            bytes += stats->bytes - bytes_before;
+
+            size_t length;
+            const uint8_t *data = sim_sink_memory(&length);
+            long valid = verify_frames(data, length, &crc_frame, &crc_length);
+            if (valid < 0 || (uint64_t)valid != stats->frames - frames_before || stats->dropped != 0) {
+                printf("%-12s FAIL: %ld valid frames of %llu\n", stream->name, valid,
+                       (unsigned long long)(stats->frames - frames_before));
+                failed = 1;
+                break;
+            }
+            if (crc_ns == 0 && length > 0) {
+                crc_ns = crc_ns_per_frame(crc_frame, crc_length);
+            }
+            sim_sink_memory_reset();
+        }
+
+        double seconds = cpu_ns / 1e9;
+        double ns_per_frame = frames ? (double)cpu_ns / frames : 0;
+        printf("%-12s %9llu %12.0f %10.1f %10.1f %10.1f %6.1f%%\n", stream->name,
+               (unsigned long long)frames, frames / seconds, bytes / seconds / 1048576.0,
+               ns_per_frame, crc_ns, ns_per_frame > 0 ? 100.0 * crc_ns / ns_per_frame : 0);
+        if (stream->samples > 0 && iterations > 0) {
+            wire_bytes_per_sample[s] = (double)bytes / ((double)iterations * stream->samples);
+        }
+    }
+
+    // Số mẫu ADC/s qua cùng một đường UART tỉ lệ nghịch với số byte trên dây của mỗi mẫu
+    for (size_t s = 0; s < sizeof(bench_streams) / sizeof(bench_streams[0]); s++) {
+        if (wire_bytes_per_sample[s] > 0) {
+            printf("%-12s %6.2f B/sample, %7.0f samples/s at 115200 baud\n", bench_streams[s].name,
+                   wire_bytes_per_sample[s], 11520.0 / wire_bytes_per_sample[s]);
+        }
+    }
+
+    batch_set_stream(ADC_STREAM_DATA_ID, 1);
+    sim_sink_close();
+    return failed;
+}
+
+
+// Các producer giống main.c để phát một luồng thực tế
+static void produce_date(void)        { send_date_data(5, 10, 2025); }
+static void produce_hello_world(void) { send_string_data(11, (uint8_t*)"Hello World"); }
+static void produce_temperature(void)
+{
+    int16_t centi_c;
+
+    if (temperature_get_centi(&centi_c)) {
+        send_temperature(centi_c);
+    }
+}
+
+static void produce_time(void)
+{
+    uint32_t seconds = Driver_GetTimeMs() / 1000;
+    send_time_data((seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60);
+}
+
+static int run_stream(int argc, char **argv)
+{
+    const char *kind = (argc > 2) ? argv[2] : "pty";
+    const char *path = (argc > 3) ? argv[3] : "stream.bin";
+    uint32_t baud = (argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 10) : 115200;
+    uint32_t seconds = (argc > 5) ? (uint32_t)strtoul(argv[5], NULL, 10) : 10;
+    uint32_t error_ppm = (argc > 6) ? (uint32_t)strtoul(argv[6], NULL, 10) : 0;
+    const char *flash_image = (argc > 7) ? argv[7] : NULL;
+
+    sim_sink_t sink = SIM_SINK_PTY;
+    if (strcmp(kind, "file") == 0) {
+        sink = SIM_SINK_FILE;
+    } else if (strcmp(kind, "memory") == 0) {
+        sink = SIM_SINK_MEMORY;
+    }
+
+    if (sim_sink_open(sink, path, baud, BENCH_SINK_CAPACITY) != 0) {
+        perror("sim_sink_open");
+        return 1;
+    }
+    if (sim_sink_pty_name() != NULL) {
+        printf("pty: %s\n", sim_sink_pty_name());
+        fflush(stdout);
+    }
+
+    sim_sink_set_error_rate(error_ppm);
+    sim_clock_init(SIM_CLOCK_REAL);
+    uint32_t now = Driver_GetTimeMs();
+
+    command_init(stats_report_all);
+    link_init();
+#if FLASH_LOG_ENABLED
+    if (flash_image != NULL && sim_flash_load(flash_image) < 0) {
+        fprintf(stderr, "%s: wrong flash image size\n", flash_image);
+        return 1;
+    }
+    flash_log_init();
+#endif
+#if PROFILER_ENABLED
+    profiler_init();
+#endif
+    scheduler_init();
+    scheduler_add(DATE_STREAM_DATA_ID,     produce_date,        date_stream_data_rate_hz,     now);
+    scheduler_add(TIME_STREAM_DATA_ID,     produce_time,        time_stream_data_rate_hz,     now);
+    scheduler_add(HELLO_WORLD_DATA_ID,     produce_hello_world, hello_world_data_rate_hz,     now);
+    scheduler_add(MCU_TEMPERATURE_DATA_ID, produce_temperature, mcu_temperature_data_rate_hz, now);
+#if PROFILER_ENABLED
+    scheduler_add(PROFILER_DATA_ID,        profiler_send_report, profiler_data_rate_hz,       now);
+#endif
+
+    acquisition_start(adc_stream_data_rate_hz);
+    temperature_init();
+    button_init();
+
+    while (now < seconds * 1000u) {
+        link_poll(now);
+        reliable_poll(now);
+#if FLASH_LOG_ENABLED
+        flash_log_poll(now);
+#endif
+        button_poll();
+        acquisition_poll();
+        temperature_poll(now);
+        scheduler_run(now);
+        batch_poll();
+        usleep(500);
+        now = Driver_GetTimeMs();
+    }
+    batch_flush();
+
+    const driver_adc_stats_t *adc = Driver_ADC_GetStats();
+    printf("adc: %u samples, %u blocks, %u overruns\n", adc->samples, adc->blocks, adc->overruns);
+
+    char line[STATS_LINE_SIZE];
+    button_format_stats(line, sizeof(line));
+    printf("%s\n", line);
+#if RELIABLE_ENABLED
+    if (reliable_format_stats(line, sizeof(line)) > 0) {
+        printf("%s\n", line);
+    }
+#endif
+#if FLASH_LOG_ENABLED
+    if (flash_log_format_stats(line, sizeof(line)) > 0) {
+        printf("%s\n", line);
+    }
+    if (flash_image != NULL && sim_flash_save(flash_image) != 0) {
+        perror(flash_image);
+    }
+#else
+    (void)flash_image;
+#endif
+
+    const sim_sink_stats_t *stats = sim_sink_get_stats();
+    printf("stream: %llu frames, %llu bytes, %llu dropped, %llu corrupted in %u s, final baud %u\n",
+           (unsigned long long)stats->frames, (unsigned long long)stats->bytes, (unsigned long long)stats->dropped,
+           (unsigned long long)stats->corrupted, seconds, Driver_UART_GetBaud());
+    sim_sink_close();
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    for (size_t i = 0; i < sizeof(bench_string); i++) {
+        bench_string[i] = (uint8_t)('a' + i % 26);
+    }
+    // Tín hiệu chậm có nhiễu vài LSB (trường hợp thường gặp) và nhiễu trắng 12 bit (trường hợp xấu nhất)
+    srand(1);
+    for (size_t i = 0; i < BENCH_ADC_BLOCK; i++) {
+        bench_adc_smooth[i] = (uint16_t)(2048 + 8 * i + rand() % 8);
+        bench_adc_noisy[i] = (uint16_t)(rand() & 0xFFF);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "stream") == 0) {
+        return run_stream(argc, argv);
+    }
+
+    double scale = (argc > 1) ? atof(argv[1]) : 1.0;
+    return run_benchmark(scale > 0 ? scale : 1.0);
+}
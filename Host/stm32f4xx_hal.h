@@ -0,0 +1,37 @@
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Created on: May 20, 2025
+ *      Author: MACH TRONG HAI
+ *
+ * Phần HAL tối thiểu cho các file Lib/ build trên máy host (Profiler.c): tần số lõi
+ * mô phỏng và vùng tắt ngắt rỗng, vì chương trình mô phỏng không có ngắt.
+ */
+
+#ifndef HOST_STM32F4XX_HAL_H_
+#define HOST_STM32F4XX_HAL_H_
+
+#include "Sim.h"
+#include <stdint.h>
+
+/** @brief Tần số lõi, bằng SIM_CORE_HZ (định nghĩa trong SimUtils.c). */
+extern uint32_t SystemCoreClock;
+
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+    (void)primask;
+}
+
+
+static inline void __disable_irq(void)
+{
+}
+
+#endif /* HOST_STM32F4XX_HAL_H_ */
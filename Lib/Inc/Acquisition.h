@@ -0,0 +1,57 @@
+/*
+ * Acquisition.h
+ *
+ *  Created on: May 06, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_ACQUISITION_H_
+#define INC_ACQUISITION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Luồng ADC lấy mẫu bằng phần cứng: TIM2 kích ADC1, DMA ghi vòng vào bộ đệm ping-pong
+ * (Driver_ADC_*). Vòng lặp chính chỉ lấy các khối đã đầy và giao cả khối cho tầng
+ * đóng gói, nên nhịp lấy mẫu không phụ thuộc vào thời gian của vòng lặp chính.
+ * sample_count của mỗi mẫu là số thứ tự của nó kể từ acquisition_start(); khối bị
+ * ghi đè vẫn làm số thứ tự tăng, nên host thấy được khoảng trống.
+ */
+
+/**
+ * @brief Bắt đầu (hoặc khởi động lại) luồng ADC.
+ * @param[in]: rate_hz Tần số lấy mẫu (Hz).
+ * @return  Tần số thực tế, 0 nếu không đạt được (luồng bị dừng).
+ */
+uint32_t acquisition_start(uint32_t rate_hz);
+
+
+/**
+ * @brief Dừng luồng ADC.
+ */
+void acquisition_stop(void);
+
+
+/**
+ * @brief Tần số lấy mẫu hiện tại (Hz), 0 nếu luồng đang dừng.
+ */
+uint32_t acquisition_get_rate(void);
+
+
+/**
+ * @brief Gửi mọi khối ADC đã đầy.
+ * Cần được gọi ít nhất một lần trong mỗi khối (DRIVER_ADC_BLOCK_SIZE / tần số lấy mẫu).
+ */
+void acquisition_poll(void);
+
+
+/**
+ * @brief Ghi thống kê của luồng ADC thành một dòng văn bản.
+ * @param[in]: buffer Bộ đệm nhận chuỗi.
+ * @param[in]: size   Kích thước bộ đệm.
+ * @return  Độ dài chuỗi (không kể '\0'), 0 nếu luồng chưa chạy.
+ */
+uint16_t acquisition_format_stats(char *buffer, size_t size);
+
+#endif /* INC_ACQUISITION_H_ */
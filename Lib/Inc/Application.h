@@ -17,20 +17,67 @@ typedef enum {
     ADC_STREAM_DATA_ID = 3,
     HELLO_WORLD_DATA_ID = 4,
     BUTTON_STATE_DATA_ID = 5,
-    MCU_TEMPERATURE_DATA_ID = 6
+    MCU_TEMPERATURE_DATA_ID = 6,
+    BATCH_DATA_ID = 7,
+    PROFILER_DATA_ID = 8,
+    LINK_DATA_ID = 9,
+    ADC_BLOCK_DATA_ID = 10,
+    COMMAND_DATA_ID = 11,
+    RELIABLE_DATA_ID = 12,
+    FLASH_LOG_DATA_ID = 13
 } data_id_t;
 
 
 typedef enum {
  date_stream_data_rate_hz = 1,
  time_stream_data_rate_hz = 1,
- adc_stream_data_rate_hz = 50,
+ adc_stream_data_rate_hz = 1000,             /* Tần số lấy mẫu của ADC (acquisition_start) */
  hello_world_data_rate_hz = 2,
- button_state_data_rate_hz = 0,
- mcu_temperature_data_rate_hz = 0
+ button_state_data_rate_hz = 0,              /* Gửi theo sự kiện EXTI (Button.c) */
+ mcu_temperature_data_rate_hz = 1,
+ profiler_data_rate_hz = 1
 } freq_t;
 
 
+/**
+ * @brief Số ký tự tối đa của một khung chuỗi.
+ * Khác 0: send_string_data() chia chuỗi dài thành nhiều khung chuỗi nhỏ, để khung
+ *      ưu tiên cao chỉ phải chờ tối đa một đoạn thay vì cả chuỗi 1 KB.
+ * 0: mỗi chuỗi được gửi trong một khung.
+ */
+#ifndef STRING_SEGMENT_MAX
+#define STRING_SEGMENT_MAX 0
+#endif
+
+
+/**
+ * @brief Cách gửi khối mẫu ADC của send_adc_block().
+ * 1: mỗi khối là một khung ADC_BLOCK_DATA_ID nén (adc_block_data_t), khoảng 1.1-1.7 byte/mẫu.
+ * 0: mỗi mẫu là một bản ghi adc_stream_data_t 7 byte như trước.
+ */
+#ifndef ADC_BLOCK_CODEC
+#define ADC_BLOCK_CODEC 1
+#endif
+
+
+/** @brief Số mẫu tối đa trong một khung ADC_BLOCK_DATA_ID; khối dài hơn được chia nhiều khung. */
+#ifndef ADC_BLOCK_MAX_SAMPLES
+#define ADC_BLOCK_MAX_SAMPLES 128
+#endif
+
+
+/**
+ * @brief Mã hóa dữ liệu mẫu trong khung ADC_BLOCK_DATA_ID.
+ * Mẫu thứ i của khung có sample_count = first_sample + i nên không cần gửi số thứ tự.
+ */
+typedef enum {
+    ADC_BLOCK_PACKED12     = 0,                  /**< Mỗi cặp mẫu 12 bit trong 3 byte (a0..a7 | a8..a11 b0..b3 | b4..b11),
+                                                      mẫu lẻ cuối cùng chiếm 2 byte. */
+    ADC_BLOCK_DELTA_VARINT = 1,                  /**< Mẫu đầu 2 byte, sau đó zigzag(mẫu - mẫu trước) dạng
+                                                      varint 7 bit/byte, byte thấp trước. */
+} adc_block_encoding_t;
+
+
 #pragma pack(push, 1)
 typedef struct {
     uint8_t  data_id;
@@ -66,11 +113,41 @@ typedef struct {
 
 typedef struct {
     uint8_t  data_id;
-    uint16_t mcu_temperature_in_c;
+    int16_t  mcu_temperature_centi_c;          /* 0.01 °C, có dấu */
 } mcu_temperature_data_t;
+
+typedef struct {
+    uint8_t  data_id;
+    uint8_t  encoding;                           /* adc_block_encoding_t */
+    uint32_t first_sample;
+    uint16_t count;
+    uint8_t  data[];                             /* count mẫu đã mã hóa */
+} adc_block_data_t;
+
+typedef struct {
+    uint8_t  data_id;
+    uint8_t  record_count;
+    uint8_t  records[];                          /* Các bản ghi ở trên, nối tiếp nhau */
+} batch_data_t;
 #pragma pack(pop)
 
 
+/** @brief Kích thước phần đầu (data_id, string_len) của gói tin chuỗi. */
+#define STRING_HEADER_SIZE (sizeof(uint8_t) + sizeof(uint16_t))
+
+
+/** @brief Độ dài chuỗi tối đa để cả gói tin chuỗi vừa trong MAX_PAYLOAD_SIZE. */
+#define MAX_STRING_LEN (MAX_PAYLOAD_SIZE - STRING_HEADER_SIZE)
+
+
+/**
+ * @brief Lấy mức ưu tiên truyền của một loại dữ liệu.
+ * @param[in]: data_id Loại dữ liệu (data_id_t).
+ * @return  Mức ưu tiên (driver_uart_priority_t), DRIVER_UART_PRIORITY_BULK nếu không biết.
+ */
+uint8_t get_data_priority(uint8_t data_id);
+
+
 /**
  * @brief Gửi một gói tin dữ liệu
  * @param[in]: packet Con trỏ đến cấu trúc packet_t để gửi
@@ -106,6 +183,16 @@ void send_time_data(uint8_t hour, uint16_t minute, uint16_t second);
 void send_adc_data(uint32_t sample_count, uint16_t value);
 
 
+/**
+ * @brief Gửi một khối mẫu ADC liên tiếp
+ * Với ADC_BLOCK_CODEC, mỗi khung chọn mã hóa nhỏ hơn giữa delta varint và 12 bit đóng gói.
+ * @param[in]: first_sample Số thứ tự của mẫu đầu tiên, mẫu thứ i có sample_count = first_sample + i
+ * @param[in]: samples Con trỏ đến các mẫu
+ * @param[in]: count Số mẫu
+ */
+void send_adc_block(uint32_t first_sample, const uint16_t *samples, uint16_t count);
+
+
 /**
  * @brief Gửi dữ liệu dạng chuỗi
  * @param[in]: string_len Độ dài chuỗi
@@ -124,8 +211,8 @@ void send_button_data(uint8_t button_id, uint16_t button_state);
 
 /**
  * @brief Gửi nhiệt độ của MCU
- * @param[in]: mcu_temperature_in_c Nhiệt độ của MCU theo đơn vị °C
+ * @param[in]: mcu_temperature_centi_c Nhiệt độ của MCU theo đơn vị 0.01 °C
  */
-void send_temperature(uint16_t mcu_temperature_in_c);
+void send_temperature(int16_t mcu_temperature_centi_c);
 
 #endif /* INC_APPLICATION_H_ */
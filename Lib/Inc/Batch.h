@@ -0,0 +1,101 @@
+/*
+ * Batch.h
+ *
+ *  Created on: Apr 09, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_BATCH_H_
+#define INC_BATCH_H_
+
+#include <Application.h>
+#include <Protocol.h>
+#include <stdint.h>
+
+/** @brief Số bản ghi tối đa trong một khung gộp (mặc định). */
+#ifndef BATCH_DEFAULT_MAX_RECORDS
+#define BATCH_DEFAULT_MAX_RECORDS 32
+#endif
+
+
+/** @brief Số byte bản ghi tối đa trong một khung gộp (mặc định). */
+#ifndef BATCH_DEFAULT_MAX_BYTES
+#define BATCH_DEFAULT_MAX_BYTES 256
+#endif
+
+
+/** @brief Thời gian tối đa một bản ghi được giữ lại trước khi phát (mặc định, ms). */
+#ifndef BATCH_DEFAULT_MAX_AGE_MS
+#define BATCH_DEFAULT_MAX_AGE_MS 100
+#endif
+
+
+/** @brief Các data_id được gộp mặc định (bit n tương ứng data_id n). */
+#ifndef BATCH_DEFAULT_STREAM_MASK
+#define BATCH_DEFAULT_STREAM_MASK (1u << ADC_STREAM_DATA_ID)
+#endif
+
+
+/** @brief Kích thước phần đầu của payload gộp: data_id và số bản ghi. */
+#define BATCH_HEADER_SIZE (sizeof(uint8_t) + sizeof(uint8_t))
+
+
+/** @brief Số byte bản ghi lớn nhất mà một khung gộp có thể chứa. */
+#define BATCH_CAPACITY (MAX_PAYLOAD_SIZE - BATCH_HEADER_SIZE)
+
+
+/**
+ * @brief Cấu hình chính sách phát của khung gộp.
+ * Khung được phát khi đạt một trong ba ngưỡng; giá trị 0 giữ nguyên ngưỡng cũ.
+ * @param[in]: max_records Số bản ghi tối đa (1..255).
+ * @param[in]: max_bytes   Số byte bản ghi tối đa (tối đa BATCH_CAPACITY và khối lớn nhất của pool).
+ * @param[in]: max_age_ms  Thời gian giữ tối đa của bản ghi đầu tiên (ms).
+ */
+void batch_configure(uint8_t max_records, uint16_t max_bytes, uint32_t max_age_ms);
+
+
+/**
+ * @brief Bật hoặc tắt việc gộp cho một data_id.
+ * @param[in]: data_id Loại dữ liệu.
+ * @param[in]: enable  1 để gộp, 0 để gửi từng khung riêng.
+ */
+void batch_set_stream(uint8_t data_id, uint8_t enable);
+
+
+/**
+ * @brief Kiểm tra một data_id có đang được gộp hay không.
+ * @param[in]: data_id Loại dữ liệu.
+ * @return  1 nếu được gộp, 0 nếu không.
+ */
+uint8_t batch_is_stream_enabled(uint8_t data_id);
+
+
+/**
+ * @brief Giữ chỗ cho một bản ghi trong khung gộp hiện tại.
+ * Nếu khung hiện tại không đủ chỗ, nó được phát trước khi giữ chỗ.
+ * @param[in]: record_length Độ dài bản ghi (bao gồm data_id của bản ghi).
+ * Bộ đệm của khung gộp được lấy từ pool khi có bản ghi đầu tiên.
+ * @return  Con trỏ để ghi bản ghi, NULL nếu bản ghi lớn hơn max_bytes hoặc pool hết khối.
+ */
+uint8_t* batch_reserve(uint16_t record_length);
+
+
+/**
+ * @brief Xác nhận bản ghi vừa ghi và phát khung nếu đạt ngưỡng số bản ghi/số byte.
+ */
+void batch_commit(void);
+
+
+/**
+ * @brief Phát khung gộp nếu bản ghi cũ nhất đã quá max_age_ms.
+ * Cần được gọi định kỳ trong vòng lặp chính.
+ */
+void batch_poll(void);
+
+
+/**
+ * @brief Phát ngay khung gộp hiện tại (nếu có bản ghi).
+ */
+void batch_flush(void);
+
+#endif /* INC_BATCH_H_ */
@@ -0,0 +1,70 @@
+/*
+ * Benchmark.h
+ *
+ *  Created on: Apr 02, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_BENCHMARK_H_
+#define INC_BENCHMARK_H_
+
+#include <Crc16.h>
+#include <stdint.h>
+
+/**
+ * @brief Bật các hàm benchmark trên target.
+ * Khi bật cần định nghĩa thêm CRC16_ALL_ENGINES = 1 để mọi engine CRC được biên dịch.
+ */
+#ifndef BENCHMARK_ENABLED
+#define BENCHMARK_ENABLED 0
+#endif
+
+
+/** @brief Số lần lặp cho mỗi phép đo, kết quả là giá trị trung bình. */
+#define BENCHMARK_ITERATIONS 16
+
+
+/** @brief Số kích thước payload được đo (từ 3 đến MAX_PAYLOAD_SIZE byte). */
+#define BENCHMARK_CRC16_SIZE_COUNT 9
+
+
+typedef struct {
+    uint16_t length;                             /**< Độ dài dữ liệu được tính CRC. */
+    uint32_t cycles[CRC16_ENGINE_COUNT];         /**< Số chu kỳ trung bình của từng engine. */
+    uint8_t  match;                              /**< 1 nếu mọi engine cho kết quả giống engine bitwise. */
+} crc16_bench_result_t;
+
+
+/**
+ * @brief Đo số chu kỳ CPU của từng engine CRC16 trên các kích thước payload.
+ * @param[out]: results Mảng BENCHMARK_CRC16_SIZE_COUNT phần tử nhận kết quả.
+ */
+void benchmark_crc16_run(crc16_bench_result_t *results);
+
+
+/**
+ * @brief Chạy benchmark CRC16 và gửi kết quả dưới dạng gói tin chuỗi.
+ * Mỗi kích thước payload được gửi trên một dòng riêng.
+ */
+void benchmark_crc16_report(void);
+
+
+/**
+ * @brief Đo chi phí CPU để phát một khung: ba lần gọi Driver_UART_Send
+ *      so với một lần truyền gộp qua send_packet(), rồi gửi kết quả dưới dạng chuỗi.
+ */
+void benchmark_send_report(void);
+
+
+/** @brief Số chuỗi độ dài tối đa được phát trong benchmark độ trễ ưu tiên. */
+#define BENCHMARK_PRIORITY_FLOOD 8
+
+
+/**
+ * @brief Đo độ trễ xếp hàng của sự kiện nút nhấn khi UART đang bị chuỗi dài chiếm dụng.
+ * Phát BENCHMARK_PRIORITY_FLOOD chuỗi tối đa, mỗi chuỗi kèm một sự kiện nút nhấn, rồi gửi
+ *      độ trễ lớn nhất/trung bình. Biên dịch lại với DRIVER_UART_TX_PRIORITY = 0 để có số liệu FIFO.
+ */
+void benchmark_priority_report(void);
+
+#endif /* INC_BENCHMARK_H_ */
@@ -0,0 +1,90 @@
+/*
+ * Button.h
+ *
+ *  Created on: May 09, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_BUTTON_H_
+#define INC_BUTTON_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Nút nhấn PA0 theo sự kiện: ngắt EXTI0 ghi thời điểm (chu kỳ DWT) và mức của chân vào
+ * hàng đợi không khóa (Driver_Button_*), vòng lặp chính lọc dội và gửi button_state_data_t
+ * ngay khi trạng thái đổi. Cạnh đầu tiên được chấp nhận ngay (lọc dội theo cạnh đầu), các
+ * cạnh trong BUTTON_DEBOUNCE_MS sau đó bị bỏ; nếu chân đã ở mức khác khi hết thời gian đó
+ * thì mức mới được gửi. Độ trễ từ ngắt đến lúc khung vào hàng đợi truyền được thống kê.
+ */
+
+/** @brief Mã nút gửi trong button_state_data_t. */
+#define BUTTON_ID 0
+
+/** @brief Thời gian bỏ qua dội sau mỗi lần đổi trạng thái (ms). */
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 20
+#endif
+
+
+/** @brief Thống kê của nút nhấn. */
+typedef struct {
+    uint32_t events;                             /**< Số lần đổi trạng thái đã gửi. */
+    uint32_t bounces;                            /**< Số cạnh bị bỏ do dội. */
+    uint32_t latency_max_us;                     /**< Độ trễ lớn nhất từ ngắt đến lúc gửi (us). */
+    uint32_t latency_sum_us;                     /**< Tổng độ trễ (us), dùng để tính trung bình. */
+} button_stats_t;
+
+
+/**
+ * @brief Đọc trạng thái ban đầu của nút và bỏ các cạnh cũ trong hàng đợi.
+ */
+void button_init(void);
+
+
+/**
+ * @brief Lọc dội các cạnh đã ghi và gửi mỗi lần trạng thái đổi.
+ * Không chờ: thời gian chạy chỉ phụ thuộc số cạnh trong hàng đợi.
+ */
+void button_poll(void);
+
+
+/**
+ * @brief Bật hoặc tắt việc gửi sự kiện; các cạnh vẫn được lọc dội khi tắt để trạng thái luôn đúng.
+ * @param[in]: enabled 1 để gửi, 0 để không gửi.
+ */
+void button_set_enabled(uint8_t enabled);
+
+
+/**
+ * @brief Việc gửi sự kiện đang bật hay không.
+ */
+uint8_t button_is_enabled(void);
+
+
+/**
+ * @brief Gửi ngay trạng thái đã lọc hiện tại của nút (kể cả khi việc gửi sự kiện đang tắt).
+ */
+void button_send_state(void);
+
+
+/**
+ * @brief Lấy thống kê của nút nhấn.
+ */
+const button_stats_t* button_get_stats(void);
+
+
+/** @brief Bộ đệm đủ cho dòng của button_format_stats(): năm số 32 bit và '\0'. */
+#define BUTTON_STATS_LINE_SIZE (sizeof("button events= bounces= dropped= lat_max_us= lat_avg_us=") + 5 * 10)
+
+
+/**
+ * @brief Ghi thống kê của nút nhấn thành một dòng văn bản.
+ * @param[in]: buffer Bộ đệm nhận chuỗi.
+ * @param[in]: size   Kích thước bộ đệm.
+ * @return  Độ dài chuỗi (không kể '\0').
+ */
+uint16_t button_format_stats(char *buffer, size_t size);
+
+#endif /* INC_BUTTON_H_ */
@@ -0,0 +1,84 @@
+/*
+ * Cobs.h
+ *
+ *  Created on: May 14, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_COBS_H_
+#define INC_COBS_H_
+
+#include <Crc16.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Consistent Overhead Byte Stuffing: dữ liệu được chia thành các nhóm tối đa 254 byte
+ * khác 0, mỗi nhóm đứng sau một byte mã bằng độ dài nhóm + 1; byte 0 của dữ liệu gốc
+ * chỉ còn là ranh giới giữa hai nhóm (trừ sau nhóm đầy, mã 0xFF). Khung đã mã hóa không
+ * chứa byte 0 nào và kết thúc bằng COBS_DELIMITER, nên bên nhận đồng bộ lại ngay ở byte 0
+ * kế tiếp sau một lỗi: một byte hỏng chỉ làm mất khung chứa nó.
+ *
+ * Phần tăng thêm tối đa là 1 byte cho mỗi 254 byte (~0.4%) cộng byte mã đầu và byte phân cách.
+ * Bộ mã hóa ghi tiến: vùng đích có thể là chính vùng nguồn dịch lùi ít nhất
+ *      COBS_ENCODED_MAX(length) - length byte, để mã hóa tại chỗ trong bộ đệm truyền.
+ */
+
+/** @brief Byte phân cách khung, không bao giờ xuất hiện bên trong khung đã mã hóa. */
+#define COBS_DELIMITER 0x00
+
+
+/** @brief Số byte dữ liệu lớn nhất của một nhóm (mã 0xFF). */
+#define COBS_GROUP_MAX 254
+
+
+/** @brief Độ dài lớn nhất sau khi mã hóa length byte, kể cả byte phân cách. */
+#define COBS_ENCODED_MAX(length) ((length) + (length) / COBS_GROUP_MAX + 2)
+
+
+typedef struct {
+    uint8_t* start;                              /**< Đầu vùng đích. */
+    uint8_t* code;                               /**< Byte mã của nhóm đang mở. */
+    uint8_t* out;                                /**< Vị trí ghi kế tiếp. */
+} cobs_encoder_t;
+
+
+/**
+ * @brief Bắt đầu mã hóa một khung vào vùng đích.
+ * @param[out]: encoder Trạng thái bộ mã hóa.
+ * @param[in]:  dst     Vùng đích, đủ chỗ cho COBS_ENCODED_MAX() của cả khung.
+ */
+void cobs_encode_begin(cobs_encoder_t* encoder, uint8_t* dst);
+
+
+/**
+ * @brief Mã hóa tiếp một đoạn dữ liệu của khung.
+ * Khi crc khác NULL, đoạn dữ liệu được đưa vào CRC16 trong cùng lượt chép,
+ *      nên mỗi byte nguồn chỉ được đọc một lần cho cả checksum lẫn mã hóa.
+ * @param[in]: encoder Trạng thái bộ mã hóa.
+ * @param[in]: src     Dữ liệu nguồn, có thể nằm sau vùng đích trong cùng bộ đệm.
+ * @param[in]: length  Số byte.
+ * @param[in]: crc     Phép tính CRC16 cần cập nhật, có thể NULL.
+ */
+void cobs_encode_update(cobs_encoder_t* encoder, const uint8_t* src, size_t length, crc16_ctx_t* crc);
+
+
+/**
+ * @brief Đóng nhóm cuối và ghi byte phân cách.
+ * @param[in]: encoder Trạng thái bộ mã hóa.
+ * @return  Độ dài khung đã mã hóa, kể cả byte phân cách.
+ */
+size_t cobs_encode_end(cobs_encoder_t* encoder);
+
+
+/**
+ * @brief Giải mã một khung COBS (không kể byte phân cách).
+ * @param[out]: dst      Vùng nhận dữ liệu gốc.
+ * @param[in]:  capacity Kích thước vùng nhận.
+ * @param[in]:  src      Khung đã mã hóa.
+ * @param[in]:  length   Độ dài khung đã mã hóa.
+ * @return  Độ dài dữ liệu gốc, 0 nếu khung không hợp lệ hoặc không vừa vùng nhận.
+ */
+size_t cobs_decode(uint8_t* dst, size_t capacity, const uint8_t* src, size_t length);
+
+#endif /* INC_COBS_H_ */
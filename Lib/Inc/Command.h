@@ -0,0 +1,78 @@
+/*
+ * Command.h
+ *
+ *  Created on: May 10, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_COMMAND_H_
+#define INC_COMMAND_H_
+
+#include <Application.h>
+#include <stdint.h>
+
+/*
+ * Lệnh từ host trên đường RX, cùng khung DE AB + CRC16 với điều khiển liên kết (Link.c):
+ * payload là command_data_t với data_id = COMMAND_DATA_ID. Thiết bị trả lời mỗi lệnh bằng
+ * một command_data_t có op | COMMAND_OP_REPLY, status và tần số hiện tại của luồng.
+ *
+ * stream_id là data_id của luồng: các luồng của scheduler (ngày, giờ, chuỗi, nhiệt độ,
+ * profiler), ADC_STREAM_DATA_ID (hoặc ADC_BLOCK_DATA_ID) cho luồng ADC, BUTTON_STATE_DATA_ID
+ * cho nút nhấn (value = 1 nếu đang gửi) và COMMAND_STREAM_STATS cho các dòng thống kê.
+ */
+
+/** @brief stream_id của báo cáo thống kê định kỳ (chỉ hỗ trợ SNAPSHOT). */
+#define COMMAND_STREAM_STATS 0
+
+/** @brief Bit đánh dấu khung trả lời trong op. */
+#define COMMAND_OP_REPLY 0x80
+
+
+typedef enum {
+    COMMAND_OP_SET_RATE = 1,                     /**< Đặt tần số = value (Hz), 0 để tắt. */
+    COMMAND_OP_ENABLE   = 2,                     /**< Bật lại với tần số trước lần tắt gần nhất. */
+    COMMAND_OP_DISABLE  = 3,                     /**< Tắt luồng, ghi nhớ tần số hiện tại. */
+    COMMAND_OP_SNAPSHOT = 4,                     /**< Gửi ngay một bản ghi của luồng, ngoài lịch. */
+    COMMAND_OP_GET      = 5,                     /**< Chỉ trả lời tần số hiện tại. */
+} command_op_t;
+
+
+typedef enum {
+    COMMAND_STATUS_OK          = 0,
+    COMMAND_STATUS_BAD_STREAM  = 1,              /**< Luồng không tồn tại. */
+    COMMAND_STATUS_BAD_VALUE   = 2,              /**< Tần số ngoài giới hạn hoặc không có tần số để bật lại. */
+    COMMAND_STATUS_UNSUPPORTED = 3,              /**< Luồng không hỗ trợ lệnh này, hoặc op không hợp lệ. */
+} command_status_t;
+
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  data_id;
+    uint8_t  op;
+    uint8_t  stream_id;
+    uint8_t  status;                             /* 0 trong lệnh, command_status_t trong trả lời */
+    uint32_t value;
+} command_data_t;
+#pragma pack(pop)
+
+
+/** @brief Hàm gửi báo cáo thống kê, được gọi bởi SNAPSHOT của COMMAND_STREAM_STATS. */
+typedef void (*command_report_t)(void);
+
+
+/**
+ * @brief Khởi tạo bộ xử lý lệnh.
+ * @param[in]: report_stats Hàm gửi báo cáo thống kê, có thể NULL.
+ */
+void command_init(command_report_t report_stats);
+
+
+/**
+ * @brief Thực hiện một lệnh và gửi trả lời.
+ * @param[in]: payload Payload của khung (data_id = COMMAND_DATA_ID).
+ * @param[in]: size    Độ dài payload.
+ * @param[in]: now     Thời gian hiện tại (ms).
+ */
+void command_handle(const uint8_t* payload, uint16_t size, uint32_t now);
+
+#endif /* INC_COMMAND_H_ */
@@ -0,0 +1,158 @@
+/*
+ * Crc16.h
+ *
+ *  Created on: Apr 02, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_CRC16_H_
+#define INC_CRC16_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Engine CRC16 duyệt từng bit (8 vòng lặp/byte, không cần bảng). */
+#define CRC16_ENGINE_BITWISE    0
+
+/** @brief Engine CRC16 tra bảng 256 phần tử (512 byte flash). */
+#define CRC16_ENGINE_TABLE      1
+
+/** @brief Engine CRC16 slice-by-4, xử lý 4 byte/bước (2 KB flash). */
+#define CRC16_ENGINE_SLICE4     2
+
+/** @brief Engine CRC16 slice-by-8, xử lý 8 byte/bước (4 KB flash). */
+#define CRC16_ENGINE_SLICE8     3
+
+/** @brief Số lượng engine CRC16 hiện có. */
+#define CRC16_ENGINE_COUNT      4
+
+
+/** @brief Engine được dùng bởi calculate_crc16(). */
+#ifndef CRC16_ENGINE
+#define CRC16_ENGINE            CRC16_ENGINE_TABLE
+#endif
+
+
+/**
+ * @brief Biên dịch tất cả các engine và bảng tra (cần cho benchmark).
+ * Khi bằng 0 chỉ engine được chọn (và engine bitwise) được đưa vào flash.
+ */
+#ifndef CRC16_ALL_ENGINES
+#define CRC16_ALL_ENGINES       0
+#endif
+
+
+/** @brief Kernel tương ứng với CRC16_ENGINE. */
+#if CRC16_ENGINE == CRC16_ENGINE_SLICE8
+#define CRC16_KERNEL            crc16_slice8
+#elif CRC16_ENGINE == CRC16_ENGINE_SLICE4
+#define CRC16_KERNEL            crc16_slice4
+#elif CRC16_ENGINE == CRC16_ENGINE_TABLE
+#define CRC16_KERNEL            crc16_table
+#else
+#define CRC16_KERNEL            crc16_bitwise
+#endif
+
+
+/** @brief Giá trị khởi tạo của CRC-16/Modbus. */
+#define CRC16_INIT_VALUE        0xFFFF
+
+
+/**
+ * @brief Trạng thái của một phép tính CRC16 tăng dần.
+ * Dữ liệu có thể được đưa vào theo nhiều đoạn bất kỳ; kết quả giống hệt
+ *      khi tính trên cả khối liền một lần.
+ */
+typedef struct {
+    uint16_t crc;                                /**< Giá trị CRC tích lũy. */
+} crc16_ctx_t;
+
+
+/**
+ * @brief Tính CRC-16/Modbus bằng cách duyệt từng bit.
+ * @param[in]: crc    Giá trị CRC hiện tại (CRC16_INIT_VALUE cho khối đầu tiên).
+ * @param[in]: data   Con trỏ đến mảng dữ liệu cần tính CRC.
+ * @param[in]: length Độ dài của mảng dữ liệu.
+ * @return  Giá trị CRC sau khi xử lý dữ liệu.
+ */
+uint16_t crc16_bitwise(uint16_t crc, const uint8_t *data, size_t length);
+
+
+/**
+ * @brief Tính CRC-16/Modbus bằng bảng tra 256 phần tử.
+ * @param[in]: crc    Giá trị CRC hiện tại.
+ * @param[in]: data   Con trỏ đến mảng dữ liệu cần tính CRC.
+ * @param[in]: length Độ dài của mảng dữ liệu.
+ * @return  Giá trị CRC sau khi xử lý dữ liệu.
+ */
+uint16_t crc16_table(uint16_t crc, const uint8_t *data, size_t length);
+
+
+/**
+ * @brief Tính CRC-16/Modbus theo thuật toán slice-by-4.
+ * @param[in]: crc    Giá trị CRC hiện tại.
+ * @param[in]: data   Con trỏ đến mảng dữ liệu cần tính CRC.
+ * @param[in]: length Độ dài của mảng dữ liệu.
+ * @return  Giá trị CRC sau khi xử lý dữ liệu.
+ */
+uint16_t crc16_slice4(uint16_t crc, const uint8_t *data, size_t length);
+
+
+/**
+ * @brief Tính CRC-16/Modbus theo thuật toán slice-by-8.
+ * @param[in]: crc    Giá trị CRC hiện tại.
+ * @param[in]: data   Con trỏ đến mảng dữ liệu cần tính CRC.
+ * @param[in]: length Độ dài của mảng dữ liệu.
+ * @return  Giá trị CRC sau khi xử lý dữ liệu.
+ */
+uint16_t crc16_slice8(uint16_t crc, const uint8_t *data, size_t length);
+
+
+/**
+ * @brief Chép dữ liệu sang vùng đích đồng thời cập nhật CRC-16/Modbus.
+ * Mỗi byte nguồn chỉ được đọc một lần cho cả việc chép lẫn việc tính CRC,
+ *      dùng engine được chọn bởi CRC16_ENGINE.
+ * @param[in]:  crc    Giá trị CRC hiện tại.
+ * @param[out]: dst    Vùng nhận dữ liệu, chỉ được chồng lên src khi dst <= src.
+ * @param[in]:  src    Dữ liệu nguồn.
+ * @param[in]:  length Số byte cần chép.
+ * @return  Giá trị CRC sau khi xử lý dữ liệu.
+ */
+uint16_t crc16_copy(uint16_t crc, uint8_t *dst, const uint8_t *src, size_t length);
+
+
+
+/**
+ * @brief Bắt đầu một phép tính CRC16 tăng dần.
+ * @param[out]: ctx Trạng thái cần khởi tạo.
+ */
+void crc16_init(crc16_ctx_t *ctx);
+
+
+/**
+ * @brief Đưa thêm một đoạn dữ liệu vào phép tính CRC16 (engine CRC16_ENGINE).
+ * @param[in]: ctx    Trạng thái đang tính.
+ * @param[in]: data   Đoạn dữ liệu kế tiếp.
+ * @param[in]: length Độ dài đoạn dữ liệu, có thể bằng 0.
+ */
+void crc16_update(crc16_ctx_t *ctx, const void *data, size_t length);
+
+
+/**
+ * @brief Chép một đoạn dữ liệu sang vùng đích và đưa nó vào phép tính CRC16.
+ * @param[in]:  ctx    Trạng thái đang tính.
+ * @param[out]: dst    Vùng nhận dữ liệu, chỉ được chồng lên src khi dst <= src.
+ * @param[in]:  src    Đoạn dữ liệu kế tiếp.
+ * @param[in]:  length Độ dài đoạn dữ liệu.
+ */
+void crc16_update_copy(crc16_ctx_t *ctx, uint8_t *dst, const uint8_t *src, size_t length);
+
+
+/**
+ * @brief Kết thúc phép tính và trả về CRC16 của toàn bộ dữ liệu đã đưa vào.
+ * @param[in]: ctx Trạng thái đang tính (không bị thay đổi, có thể tiếp tục update).
+ * @return  Giá trị CRC16, giống calculate_crc16() trên cùng dữ liệu liền khối.
+ */
+uint16_t crc16_final(const crc16_ctx_t *ctx);
+
+#endif /* INC_CRC16_H_ */
@@ -11,14 +11,442 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * @brief Chế độ truyền UART.
+ * 1: dữ liệu được chép vào ring buffer và truyền nền bằng DMA (USART2_TX, DMA1 Stream6).
+ * 0: truyền chặn bằng HAL_UART_Transmit như trước.
+ */
+#ifndef DRIVER_UART_TX_DMA
+#define DRIVER_UART_TX_DMA 1
+#endif
+
+
+/**
+ * @brief Hàng đợi truyền nhiều mức ưu tiên.
+ * 1: mỗi mức ưu tiên có ring riêng, khung ưu tiên cao được truyền ở ranh giới khung kế tiếp.
+ * 0: mọi khung đi qua ring bulk theo thứ tự FIFO (dùng để so sánh độ trễ).
+ */
+#ifndef DRIVER_UART_TX_PRIORITY
+#define DRIVER_UART_TX_PRIORITY 1
+#endif
+
+
+/** @brief Mức ưu tiên của một khung truyền, số nhỏ hơn được truyền trước. */
+typedef enum {
+    DRIVER_UART_PRIORITY_URGENT = 0,             /**< Sự kiện cần báo ngay (nút nhấn). */
+    DRIVER_UART_PRIORITY_HIGH   = 1,             /**< Luồng đo lường tần số cao (ADC). */
+    DRIVER_UART_PRIORITY_NORMAL = 2,             /**< Dữ liệu định kỳ (ngày, giờ, nhiệt độ). */
+    DRIVER_UART_PRIORITY_BULK   = 3,             /**< Dữ liệu lớn, không gấp (chuỗi ký tự). */
+} driver_uart_priority_t;
+
+/** @brief Số mức ưu tiên của hàng đợi truyền. */
+#define DRIVER_UART_TX_CLASSES 4
+
+
+/**
+ * @brief Kích thước ring của từng mức ưu tiên (byte).
+ * Khung lớn hơn nửa ring của mức ưu tiên sẽ được chuyển sang ring bulk;
+ *      ring bulk phải lớn hơn hai lần một khung tối đa.
+ */
+#ifndef DRIVER_UART_TX_URGENT_SIZE
+#define DRIVER_UART_TX_URGENT_SIZE 256
+#endif
+
+#ifndef DRIVER_UART_TX_HIGH_SIZE
+#define DRIVER_UART_TX_HIGH_SIZE 1024
+#endif
+
+#ifndef DRIVER_UART_TX_NORMAL_SIZE
+#define DRIVER_UART_TX_NORMAL_SIZE 512
+#endif
+
+#ifndef DRIVER_UART_TX_BULK_SIZE
+#define DRIVER_UART_TX_BULK_SIZE 4096
+#endif
+
+
+/** @brief Tốc độ baud của USART2 sau khi khởi động, cũng là tốc độ liên kết quay về khi lỗi. */
+#ifndef DRIVER_UART_BAUD_DEFAULT
+#define DRIVER_UART_BAUD_DEFAULT 115200
+#endif
+
+
+/**
+ * @brief Sai số tốc độ baud lớn nhất được chấp nhận (phần nghìn).
+ * Sai số thực tế do bộ chia BRR của USART2 (APB1 42 MHz) gây ra; máy host cũng có sai số riêng
+ *      nên mỗi bên chỉ nên chiếm khoảng một nửa dung sai ~2-3% của khung 8N1.
+ */
+#ifndef DRIVER_UART_BAUD_TOLERANCE
+#define DRIVER_UART_BAUD_TOLERANCE 10
+#endif
+
+
+/**
+ * @brief Kích thước ring nhận (byte), phải là lũy thừa của 2.
+ * Main context cần đọc ring trước khi DMA ghi đầy nó (256 byte ~ 22 ms ở 115200 baud).
+ */
+#ifndef DRIVER_UART_RX_SIZE
+#define DRIVER_UART_RX_SIZE 256
+#endif
+
+
+/** @brief Thống kê độ trễ xếp hàng (commit đến lúc bắt đầu truyền) của một mức ưu tiên. */
+typedef struct {
+    uint32_t frames;                             /**< Số khung đã bắt đầu truyền. */
+    uint32_t latency_max_us;                     /**< Độ trễ lớn nhất (us). */
+    uint32_t latency_sum_us;                     /**< Tổng độ trễ (us), dùng để tính trung bình. */
+} driver_uart_tx_stats_t;
+
+
+/** @brief Một đoạn dữ liệu trong danh sách scatter-gather. */
+typedef struct {
+    const uint8_t* data;                         /**< Con trỏ đến dữ liệu của đoạn. */
+    size_t         size;                         /**< Số byte của đoạn. */
+} driver_uart_segment_t;
+
+
 /**
  * @brief Gửi dữ liệu qua giao tiếp UART.
  * Hàm này chịu trách nhiệm gửi một mảng dữ liệu qua giao tiếp UART.
+ * Ở chế độ DMA, dữ liệu được chép vào ring buffer và hàm trả về ngay;
+ *      hàm chỉ chờ khi ring buffer không còn đủ chỗ trống.
  * @param[in] data Con trỏ đến mảng dữ liệu cần gửi.
  * @param[in] size Kích thước của mảng dữ liệu (số byte).
  */
 void Driver_UART_Send(const uint8_t* data, size_t size);
 
+
+/**
+ * @brief Giữ chỗ một vùng liên tục trong bộ đệm truyền để ghi dữ liệu trực tiếp.
+ * Mỗi lần giữ chỗ phải được kết thúc bằng Driver_UART_Commit() trước lần giữ chỗ
+ *      hoặc lần gửi tiếp theo.
+ * @param[in] size     Số byte cần giữ chỗ.
+ * @param[in] priority Mức ưu tiên (driver_uart_priority_t) của khung.
+ * @return Con trỏ đến vùng nhớ được giữ chỗ, NULL nếu size quá lớn.
+ */
+uint8_t* Driver_UART_Reserve(size_t size, uint8_t priority);
+
+
+/**
+ * @brief Xác nhận vùng đã giữ chỗ và bắt đầu truyền nó.
+ * @param[in] region Con trỏ trả về bởi Driver_UART_Reserve().
+ * @param[in] size   Số byte đã ghi, không lớn hơn số byte đã giữ chỗ.
+ */
+void Driver_UART_Commit(uint8_t* region, size_t size);
+
+
+/**
+ * @brief Gửi nhiều đoạn dữ liệu như một lần truyền liên tục duy nhất.
+ * Dùng để phát cả khung (header, payload, checksum) bằng một giao dịch phần cứng.
+ * @param[in] segments Mảng các đoạn dữ liệu theo đúng thứ tự truyền.
+ * @param[in] count    Số phần tử của mảng segments.
+ */
+void Driver_UART_SendV(const driver_uart_segment_t* segments, size_t count);
+
+
+/**
+ * @brief Chờ cho đến khi toàn bộ dữ liệu trong ring buffer đã được truyền xong.
+ */
+void Driver_UART_Flush(void);
+
+
+/**
+ * @brief Kiểm tra UART còn dữ liệu đang chờ hoặc đang truyền hay không.
+ * @return 1 nếu còn dữ liệu chưa truyền xong, 0 nếu đã rảnh.
+ */
+uint8_t Driver_UART_IsBusy(void);
+
+
+/**
+ * @brief Số byte lớn nhất có thể giữ chỗ ở một mức ưu tiên mà Driver_UART_Reserve() không phải chờ.
+ * Dùng cho dữ liệu không gấp (FlashLog.c) để chỉ lấp phần bộ đệm còn trống thay vì chặn vòng lặp.
+ * @param[in] priority Mức ưu tiên (driver_uart_priority_t).
+ * @return Số byte.
+ */
+size_t Driver_UART_GetTxSpace(uint8_t priority);
+
+
+/**
+ * @brief Lấy thống kê độ trễ xếp hàng của một mức ưu tiên.
+ * Độ trễ đo bằng bộ đếm chu kỳ DWT, cần gọi Driver_CycleCounterInit() trước.
+ * @param[in] priority Mức ưu tiên.
+ * @return Con trỏ đến thống kê, NULL nếu mức ưu tiên không hợp lệ.
+ */
+const driver_uart_tx_stats_t* Driver_UART_GetTxStats(uint8_t priority);
+
+
+/**
+ * @brief Xóa thống kê độ trễ của mọi mức ưu tiên.
+ */
+void Driver_UART_ResetTxStats(void);
+
+
+/**
+ * @brief Bắt đầu nhận dữ liệu từ USART2 vào ring nhận.
+ * DMA1 Stream5 ghi vòng vào ring (HAL_UARTEx_ReceiveToIdle_DMA), CPU chỉ bị ngắt khi đường
+ *      nhận rảnh hoặc ở nửa/cuối ring; main context đọc lại bằng Driver_UART_Read().
+ */
+void Driver_UART_RxStart(void);
+
+
+/**
+ * @brief Lấy dữ liệu đã nhận ra khỏi ring nhận.
+ * @param[out] data Bộ đệm nhận dữ liệu.
+ * @param[in]  size Kích thước bộ đệm.
+ * @return Số byte đã chép, 0 nếu chưa có dữ liệu.
+ */
+size_t Driver_UART_Read(uint8_t* data, size_t size);
+
+
+/**
+ * @brief Số lỗi nhận (framing, noise, overrun và byte bị bỏ do ring nhận đầy) kể từ khi khởi động.
+ */
+uint32_t Driver_UART_GetRxErrors(void);
+
+
+/**
+ * @brief Kiểm tra USART2 có đạt được một tốc độ baud trong dung sai hay không.
+ * Oversampling 16 được ưu tiên vì chịu nhiễu tốt hơn; oversampling 8 chỉ dùng khi
+ *      baud vượt quá PCLK1/16.
+ * @param[in]  baud         Tốc độ cần kiểm tra.
+ * @param[out] oversampling Oversampling sẽ dùng (8 hoặc 16), có thể NULL.
+ * @return Tốc độ thực tế sau bộ chia, 0 nếu không đạt được.
+ */
+uint32_t Driver_UART_CheckBaud(uint32_t baud, uint8_t* oversampling);
+
+
+/**
+ * @brief Đổi tốc độ baud của USART2.
+ * Hàm chờ mọi khung đang xếp hàng được truyền xong ở tốc độ cũ rồi mới đổi,
+ *      nên khung gửi ngay trước lời gọi luôn đến đích nguyên vẹn.
+ * @param[in] baud Tốc độ mới.
+ * @return 1 nếu đã đổi, 0 nếu tốc độ không đạt được (tốc độ cũ được giữ nguyên).
+ */
+uint8_t Driver_UART_SetBaud(uint32_t baud);
+
+
+/**
+ * @brief Tốc độ baud hiện tại của USART2.
+ */
+uint32_t Driver_UART_GetBaud(void);
+
+
+/**
+ * @brief Số mẫu trong một khối ADC (một nửa bộ đệm ping-pong).
+ * Khối càng lớn thì main context càng có nhiều thời gian để lấy khối trước khi DMA
+ *      ghi đè lên nó: thời gian đó bằng DRIVER_ADC_BLOCK_SIZE / tần số lấy mẫu.
+ */
+#ifndef DRIVER_ADC_BLOCK_SIZE
+#define DRIVER_ADC_BLOCK_SIZE 64
+#endif
+
+
+/** @brief Tần số lấy mẫu ADC lớn nhất được chấp nhận (Hz). */
+#ifndef DRIVER_ADC_RATE_MAX
+#define DRIVER_ADC_RATE_MAX 100000
+#endif
+
+
+/** @brief Thống kê của luồng lấy mẫu ADC. */
+typedef struct {
+    uint32_t samples;                            /**< Số mẫu đã lấy kể từ Driver_ADC_Start(). */
+    uint32_t blocks;                             /**< Số khối đã được lấy ra bởi Driver_ADC_GetBlock(). */
+    uint32_t overruns;                           /**< Số khối bị ghi đè trước khi được lấy ra. */
+} driver_adc_stats_t;
+
+
+/**
+ * @brief Bắt đầu lấy mẫu ADC1 kênh 1 (PA1) theo xung TIM2, DMA vòng vào bộ đệm ping-pong.
+ * Mỗi khi DMA ghi đầy một nửa bộ đệm, nửa đó trở thành một khối chờ lấy ra; việc lấy mẫu
+ *      hoàn toàn do phần cứng nên không phụ thuộc vào thời gian của vòng lặp chính.
+ * @param[in] rate_hz Tần số lấy mẫu (Hz), tối đa DRIVER_ADC_RATE_MAX.
+ * @return Tần số thực tế sau bộ chia của TIM2, 0 nếu không đạt được.
+ */
+uint32_t Driver_ADC_Start(uint32_t rate_hz);
+
+
+/**
+ * @brief Dừng lấy mẫu ADC; các khối chưa lấy ra bị bỏ.
+ */
+void Driver_ADC_Stop(void);
+
+
+/**
+ * @brief Lấy khối ADC cũ nhất đã đầy.
+ * Khối vẫn nằm trong bộ đệm DMA và chỉ hợp lệ đến khi DMA quay lại nửa đó; người gọi phải
+ *      dùng xong và gọi Driver_ADC_ReleaseBlock() trong vòng một khối.
+ * @param[out] first_sample Số thứ tự của mẫu đầu tiên trong khối, tăng liên tục kể cả qua
+ *      các khối bị ghi đè, nên khoảng trống giữa hai khối cho biết số mẫu bị mất.
+ * @return Con trỏ đến DRIVER_ADC_BLOCK_SIZE mẫu 12 bit, NULL nếu chưa có khối nào đầy.
+ */
+const uint16_t* Driver_ADC_GetBlock(uint32_t* first_sample);
+
+
+/**
+ * @brief Trả lại khối vừa lấy bởi Driver_ADC_GetBlock().
+ */
+void Driver_ADC_ReleaseBlock(void);
+
+
+/**
+ * @brief Lấy thống kê của luồng lấy mẫu ADC.
+ */
+const driver_adc_stats_t* Driver_ADC_GetStats(void);
+
+
+/**
+ * @brief Xử lý ngắt half/full-complete của DMA2 Stream0, gọi từ DMA2_Stream0_IRQHandler().
+ */
+void Driver_ADC_IRQHandler(void);
+
+
+/**
+ * @brief Bắt đầu một loạt chuyển đổi injected của cảm biến nhiệt độ trong (ADC1 kênh 16).
+ * Khi luồng ADC đang chạy, mỗi chuyển đổi được kích bởi TIM2 CC1 ở giữa chu kỳ lấy mẫu nên
+ *      không chồng lên chuyển đổi regular; khi luồng dừng, các chuyển đổi nối tiếp nhau từ ngắt.
+ * Hàm trả về ngay, kết quả được lấy bằng Driver_TempSensor_Read().
+ * @param[in] samples Số chuyển đổi của loạt.
+ * @return 1 nếu đã bắt đầu, 0 nếu loạt trước chưa xong.
+ */
+uint8_t Driver_TempSensor_Start(uint16_t samples);
+
+
+/**
+ * @brief Lấy kết quả của loạt chuyển đổi vừa xong.
+ * @param[out] sum Tổng các giá trị 12 bit của loạt.
+ * @return Số chuyển đổi của loạt, 0 nếu chưa có loạt nào xong (mỗi loạt chỉ được trả về một lần).
+ */
+uint16_t Driver_TempSensor_Read(uint32_t* sum);
+
+
+/**
+ * @brief Giá trị hiệu chuẩn của cảm biến nhiệt độ ghi trong system memory lúc sản xuất.
+ * @param[out] cal30  Giá trị ADC ở 30 °C (TS_CAL1, VDDA = 3.3 V).
+ * @param[out] cal110 Giá trị ADC ở 110 °C (TS_CAL2, VDDA = 3.3 V).
+ * @return 1 nếu hai giá trị hợp lý, 0 nếu không (chip chưa được hiệu chuẩn).
+ */
+uint8_t Driver_TempSensor_GetCalibration(uint16_t* cal30, uint16_t* cal110);
+
+
+/**
+ * @brief Xử lý ngắt JEOC của ADC1, gọi từ ADC_IRQHandler().
+ */
+void Driver_TempSensor_IRQHandler(void);
+
+
+/** @brief Số cạnh trong hàng đợi của nút nhấn PA0, phải là lũy thừa của 2. */
+#ifndef DRIVER_BUTTON_QUEUE_SIZE
+#define DRIVER_BUTTON_QUEUE_SIZE 16
+#endif
+
+
+/** @brief Một cạnh của nút nhấn, được ghi trong ngắt EXTI. */
+typedef struct {
+    uint32_t cycles;                             /**< Driver_GetCycles() lúc vào ngắt. */
+    uint8_t  level;                              /**< Mức của chân ngay sau cạnh (GPIO_PinState). */
+} driver_button_edge_t;
+
+
+/**
+ * @brief Lấy cạnh cũ nhất ra khỏi hàng đợi của nút nhấn.
+ * Hàng đợi một ghi (ngắt EXTI0) một đọc (main context) nên không cần khóa ngắt.
+ * @param[out] edge Cạnh lấy ra.
+ * @return 1 nếu có cạnh, 0 nếu hàng đợi rỗng.
+ */
+uint8_t Driver_Button_Read(driver_button_edge_t* edge);
+
+
+/**
+ * @brief Mức hiện tại của chân nút nhấn (GPIO_PinState).
+ */
+uint8_t Driver_Button_GetLevel(void);
+
+
+/**
+ * @brief Số cạnh bị bỏ do hàng đợi đầy kể từ khi khởi động.
+ */
+uint32_t Driver_Button_GetDropped(void);
+
+
+/**
+ * @brief Bật clock cho bộ CRC phần cứng.
+ * Cần được gọi một lần trước khi dùng Driver_CRC32_Calculate().
+ */
+void Driver_CRC32_Init(void);
+
+
+/**
+ * @brief Tính CRC-32 bằng bộ CRC phần cứng.
+ * Đa thức 0x04C11DB7, khởi tạo 0xFFFFFFFF, không đảo bit. Dữ liệu được nạp
+ *      theo từng word 32 bit little-endian; phần lẻ cuối được đệm byte 0 cho đủ word.
+ * Chỉ được gọi từ main context vì bộ CRC chỉ có một thanh ghi dữ liệu.
+ * @param[in] data   Dữ liệu cần tính.
+ * @param[in] length Số byte.
+ * @return Giá trị CRC-32.
+ */
+uint32_t Driver_CRC32_Calculate(const uint8_t* data, size_t length);
+
+
+/** @brief Số sector flash dành cho nhật ký (FlashLog.h): sector 8-11 của STM32F407, từ 0x08080000. */
+#define DRIVER_FLASH_LOG_SECTORS 4
+
+
+/** @brief Kích thước một sector của nhật ký (byte). */
+#define DRIVER_FLASH_LOG_SECTOR_SIZE (128u * 1024u)
+
+
+/** @brief Trạng thái của bộ điều khiển flash. */
+typedef enum {
+    DRIVER_FLASH_IDLE  = 0,                      /**< Rảnh, có thể ghi hoặc xóa. */
+    DRIVER_FLASH_BUSY  = 1,                      /**< Đang xóa một sector (Driver_Flash_EraseStart()). */
+    DRIVER_FLASH_ERROR = 2,                      /**< Lần xóa gần nhất bị lỗi. */
+} driver_flash_state_t;
+
+
+/**
+ * @brief Địa chỉ đọc (ánh xạ bộ nhớ) của một sector nhật ký.
+ * @param[in] sector Sector nhật ký (0 .. DRIVER_FLASH_LOG_SECTORS - 1).
+ * @return Con trỏ đến đầu sector, NULL nếu sector không hợp lệ.
+ */
+const uint32_t* Driver_Flash_GetSector(uint8_t sector);
+
+
+/**
+ * @brief Ghi các word vào một sector nhật ký đã xóa.
+ * Mỗi word được ghi bằng HAL_FLASH_Program (x32, ~16 us); bit chỉ có thể chuyển từ 1 sang 0,
+ *      nên một word đã ghi có thể được ghi lại để xóa thêm bit.
+ * @param[in] sector Sector nhật ký.
+ * @param[in] offset Vị trí trong sector (byte), chia hết cho 4.
+ * @param[in] words  Các word cần ghi.
+ * @param[in] count  Số word.
+ * @return 1 nếu thành công, 0 nếu tham số sai, đang xóa hoặc lỗi ghi.
+ */
+uint8_t Driver_Flash_Program(uint8_t sector, uint32_t offset, const uint32_t* words, uint16_t count);
+
+
+/**
+ * @brief Bắt đầu xóa một sector nhật ký bằng ngắt; hàm trả về ngay.
+ * Trên STM32F407 chỉ có một bank nên CPU vẫn bị dừng ở lần đọc flash kế tiếp cho đến khi
+ *      xóa xong (1-2 s với 128 KB): vòng lặp chính và mọi ngắt (UART, DMA, ADC, EXTI, SysTick)
+ *      đều dừng, chỉ DMA đang chạy tiếp tục. HAL_GetTick() được bù khi xóa xong, nhưng người gọi
+ *      chỉ nên xóa khi không có luồng thời gian thực nào cần giữ.
+ * @param[in] sector Sector nhật ký.
+ * @return 1 nếu đã bắt đầu, 0 nếu sector không hợp lệ hoặc bộ điều khiển đang bận.
+ */
+uint8_t Driver_Flash_EraseStart(uint8_t sector);
+
+
+/**
+ * @brief Trạng thái hiện tại của bộ điều khiển flash (driver_flash_state_t).
+ */
+uint8_t Driver_Flash_GetState(void);
+
+
+/**
+ * @brief Xử lý ngắt của bộ điều khiển flash, gọi từ FLASH_IRQHandler().
+ */
+void Driver_Flash_IRQHandler(void);
+
 #endif /* INC_DRIVER_H_ */
 
 
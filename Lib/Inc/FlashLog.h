@@ -0,0 +1,187 @@
+/*
+ * FlashLog.h
+ *
+ *  Created on: May 16, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_FLASHLOG_H_
+#define INC_FLASHLOG_H_
+
+#include <Application.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Nhật ký flash tùy chọn: lưu các khung phát ra khi không có host để phát lại sau.
+ * Host báo có mặt bằng bất kỳ khung hợp lệ nào trên đường RX (Link.c), thường là
+ * FLASH_LOG_OP_PRESENT mỗi giây. Sau khi khởi động, host được coi là chưa rõ (không lưu)
+ * trong FLASH_LOG_HOST_TIMEOUT_MS. Quá FLASH_LOG_HOST_TIMEOUT_MS không nhận được gì, mọi khung
+ * của reserve_packet()/send_packet() (trừ khung có số thứ tự hoặc khung phát lại) được chép
+ * vào một hàng đợi RAM; flash_log_poll() ghi hàng đợi vào flash tối đa FLASH_LOG_WORDS_PER_POLL
+ * word mỗi lần nên việc lưu không chặn các luồng. Hàng đợi đầy thì khung bị bỏ và được đếm.
+ *
+ * Nhật ký là một vòng qua các sector DRIVER_FLASH_LOG_SECTORS (128 KB), dùng lần lượt theo
+ * thứ tự nên mỗi sector bị xóa số lần như nhau:
+ *
+ *      sector: [FLASH_LOG_MAGIC][generation] các bản ghi...
+ *      bản ghi: [độ dài (2)][trạng thái (2)][khung (tiêu đề và payload, không có checksum), đệm đến 4 byte]
+ *
+ * Word đầu của bản ghi được ghi trước với trạng thái 0xFFFF, rồi đến dữ liệu, rồi ghi lại
+ * với FLASH_LOG_STATE_COMMITTED; sau khi phát lại, FLASH_LOG_STATE_DUMPED. Mỗi bước chỉ đổi
+ * bit 1 thành 0 nên không cần xóa. Khi khởi động, sector có generation lớn nhất chứa con trỏ
+ * ghi: các bản ghi được duyệt theo độ dài đến word trống đầu tiên; bản ghi dở dang (mất điện
+ * giữa chừng) bị bỏ qua nhờ độ dài đã ghi trước, word đầu vô nghĩa đóng sector lại.
+ *
+ * Host gửi FLASH_LOG_OP_DUMP để lấy phần tồn đọng: thiết bị trả lời STATUS rồi phát lại từng
+ * bản ghi (Protocol.h, replay_packet()) ở mức ưu tiên bulk, chỉ khi bộ đệm truyền còn chỗ, và
+ * kết thúc bằng END. Khi vòng đầy, sector cũ nhất bị xóa (đếm là lost nếu còn bản ghi chưa phát).
+ *
+ * Xóa sector dùng ngắt nhưng STM32F407 chỉ có một bank: CPU và mọi ngắt dừng ở lần đọc flash
+ * kế tiếp trong 1-2 s. Vì vậy sector chỉ được xóa (kể cả xóa trước) khi host vắng mặt, lúc
+ * không có luồng trực tiếp nào để giữ; mẫu ADC bị mất khi đó được đếm trong overruns và
+ * HAL_GetTick() được bù lại (Driver.h). Khi host có mặt mà sector ghi đã đầy, phần còn lại
+ * của hàng đợi chờ đến lần host vắng mặt kế tiếp. Một lần xóa cho mỗi 128 KB được lưu.
+ */
+
+/**
+ * @brief Bật nhật ký flash.
+ * Mặc định tắt vì mỗi sector chỉ chịu khoảng 10000 lần xóa: ở 115200 baud, luồng đầy đủ
+ *      xóa một sector mỗi ~11 s khi không có host.
+ */
+#ifndef FLASH_LOG_ENABLED
+#define FLASH_LOG_ENABLED 0
+#endif
+
+
+/** @brief Thời gian không nhận được khung nào từ host trước khi bắt đầu lưu (ms). */
+#ifndef FLASH_LOG_HOST_TIMEOUT_MS
+#define FLASH_LOG_HOST_TIMEOUT_MS 3000
+#endif
+
+
+/** @brief Dung lượng hàng đợi RAM giữa commit_packet() và flash (byte), bội của 4. */
+#ifndef FLASH_LOG_QUEUE_SIZE
+#define FLASH_LOG_QUEUE_SIZE 4096
+#endif
+
+
+/** @brief Số word được ghi vào flash tối đa mỗi lần flash_log_poll() (~16 us mỗi word). */
+#ifndef FLASH_LOG_WORDS_PER_POLL
+#define FLASH_LOG_WORDS_PER_POLL 32
+#endif
+
+
+/** @brief Số bản ghi được phát lại tối đa mỗi lần flash_log_poll(). */
+#ifndef FLASH_LOG_DUMP_PER_POLL
+#define FLASH_LOG_DUMP_PER_POLL 8
+#endif
+
+
+/** @brief Word đầu tiên của một sector đang dùng ("FLOG"). */
+#define FLASH_LOG_MAGIC 0x474F4C46u
+
+
+/** @brief Trạng thái của bản ghi, nửa cao của word đầu. 0xFFFF: đang ghi. */
+#define FLASH_LOG_STATE_COMMITTED 0x5A5Au
+#define FLASH_LOG_STATE_DUMPED    0x0000u
+
+
+typedef enum {
+    FLASH_LOG_OP_PRESENT = 1,                    /**< Host báo có mặt. */
+    FLASH_LOG_OP_DUMP    = 2,                    /**< Host yêu cầu phát lại phần tồn đọng. */
+    FLASH_LOG_OP_STATUS  = 3,                    /**< Khi host xuất hiện hoặc trả lời DUMP: arg = số sector bị ghi đè,
+                                                      value = số byte tồn đọng. */
+    FLASH_LOG_OP_END     = 4,                    /**< Kết thúc phát lại: value = số bản ghi đã phát lại. */
+} flash_log_op_t;
+
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  data_id;
+    uint8_t  op;
+    uint16_t arg;
+    uint32_t value;
+} flash_log_control_data_t;
+#pragma pack(pop)
+
+
+typedef struct {
+    uint32_t appended;                           /**< Số khung đã đưa vào hàng đợi. */
+    uint32_t written;                            /**< Số bản ghi đã ghi xong vào flash. */
+    uint32_t dropped;                            /**< Số khung bị bỏ vì hàng đợi đầy. */
+    uint32_t dumped;                             /**< Số bản ghi đã phát lại. */
+    uint32_t erases;                             /**< Số lần xóa sector. */
+    uint32_t lost;                               /**< Số sector bị xóa khi còn bản ghi chưa phát lại. */
+    uint32_t errors;                             /**< Số lần ghi/xóa lỗi và bản ghi hỏng. */
+} flash_log_stats_t;
+
+
+#if FLASH_LOG_ENABLED
+
+/**
+ * @brief Khôi phục con trỏ ghi và con trỏ đọc từ nội dung flash.
+ * Chỉ đọc word đầu của các sector và word đầu của các bản ghi, trừ sector không có tiêu đề
+ *      hợp lệ được kiểm tra trống toàn bộ.
+ */
+void flash_log_init(void);
+
+
+/**
+ * @brief Khung mới có cần được lưu hay không (không có host).
+ */
+uint8_t flash_log_is_recording(void);
+
+
+/**
+ * @brief Chép một khung vào hàng đợi; không bao giờ chờ.
+ * @param[in]: frame  Tiêu đề và payload của khung, không có checksum.
+ * @param[in]: length Độ dài.
+ */
+void flash_log_append(const uint8_t* frame, uint16_t length);
+
+
+/**
+ * @brief Ghi nhận host có mặt, gọi cho mọi khung hợp lệ nhận từ host.
+ * @param[in]: now Thời gian hiện tại (ms).
+ */
+void flash_log_host_seen(uint32_t now);
+
+
+/**
+ * @brief Xử lý khung FLASH_LOG_DATA_ID nhận từ host.
+ * @param[in]: payload Payload của khung.
+ * @param[in]: size    Độ dài payload.
+ * @param[in]: now     Thời gian hiện tại (ms).
+ */
+void flash_log_handle(const uint8_t* payload, uint16_t size, uint32_t now);
+
+
+/**
+ * @brief Ghi hàng đợi vào flash, xóa sector kế tiếp và phát lại phần tồn đọng khi host yêu cầu.
+ * @param[in]: now Thời gian hiện tại (ms).
+ */
+void flash_log_poll(uint32_t now);
+
+
+/**
+ * @brief Thống kê của nhật ký kể từ khi khởi động.
+ */
+const flash_log_stats_t* flash_log_get_stats(void);
+
+
+/** @brief Bộ đệm đủ cho dòng của flash_log_format_stats(): cờ host, tám số 32 bit và '\0'. */
+#define FLASH_LOG_STATS_LINE_SIZE (sizeof("flashlog host= backlog= appended= written= dropped= dumped= erases= lost= errors=") + 1 + 8 * 10)
+
+
+/**
+ * @brief Ghi thống kê của nhật ký thành một dòng văn bản.
+ * @param[in]: buffer Bộ đệm nhận chuỗi.
+ * @param[in]: size   Kích thước bộ đệm.
+ * @return  Độ dài chuỗi (không kể '\0'), 0 nếu nhật ký trống và chưa từng được dùng.
+ */
+uint16_t flash_log_format_stats(char *buffer, size_t size);
+
+#endif /* FLASH_LOG_ENABLED */
+
+#endif /* INC_FLASHLOG_H_ */
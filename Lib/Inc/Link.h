@@ -0,0 +1,133 @@
+/*
+ * Link.h
+ *
+ *  Created on: May 02, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_LINK_H_
+#define INC_LINK_H_
+
+#include <Application.h>
+#include <stdint.h>
+
+/*
+ * Thỏa thuận tốc độ baud giữa thiết bị và host qua khung điều khiển LINK_DATA_ID.
+ * Host gửi khung DE AB (CRC16) trên đường RX, thiết bị trả lời bằng khung cùng loại:
+ *
+ *      host                              thiết bị
+ *      PROPOSE(b)          ------>       (tốc độ cũ)
+ *                          <------       ACCEPT(b) hoặc REJECT(b)
+ *      -- cả hai chuyển sang b, thiết bị chờ COMMIT trong LINK_TRIAL_TIMEOUT_MS --
+ *      PROBE(b)            ------>
+ *                          <------       PROBE_ACK(b) + mẫu thử LINK_PROBE_SIZE byte
+ *      COMMIT(b)           ------>
+ *                          <------       COMMIT_ACK(b)
+ *
+ * Nếu COMMIT không đến kịp, thiết bị quay về tốc độ cũ và gửi STATUS. Khi đã ở tốc độ
+ * khác mặc định, thiết bị quay về DRIVER_UART_BAUD_DEFAULT nếu không nhận được khung hợp lệ
+ * nào trong LINK_KEEPALIVE_TIMEOUT_MS, nếu host báo lỗi CRC liên tiếp qua KEEPALIVE,
+ * hoặc nếu chính đường nhận gặp lỗi liên tiếp.
+ *
+ * Khung COMMAND_DATA_ID trên cùng đường nhận được chuyển cho command_handle() (Command.h),
+ * khung RELIABLE_DATA_ID cho reliable_handle() (Reliable.h). Khi FLASH_LOG_ENABLED, mọi khung
+ * hợp lệ đều báo host có mặt và khung FLASH_LOG_DATA_ID được chuyển cho flash_log_handle() (FlashLog.h).
+ */
+
+/** @brief Thời gian chờ COMMIT sau khi chuyển sang tốc độ mới (ms). */
+#ifndef LINK_TRIAL_TIMEOUT_MS
+#define LINK_TRIAL_TIMEOUT_MS 500
+#endif
+
+
+/** @brief Thời gian tối đa không nhận được khung hợp lệ khi ở tốc độ khác mặc định (ms). */
+#ifndef LINK_KEEPALIVE_TIMEOUT_MS
+#define LINK_KEEPALIVE_TIMEOUT_MS 3000
+#endif
+
+
+/**
+ * @brief Tỉ lệ khung lỗi CRC phía host (phần nghìn) trong một chu kỳ KEEPALIVE được tính
+ *      là một lần vi phạm; dùng tỉ lệ thay cho số khung để ngưỡng không phụ thuộc lưu lượng.
+ */
+#ifndef LINK_FALLBACK_ERROR_PERMILLE
+#define LINK_FALLBACK_ERROR_PERMILLE 20
+#endif
+
+
+/** @brief Số chu kỳ KEEPALIVE vi phạm liên tiếp trước khi quay về tốc độ mặc định. */
+#ifndef LINK_FALLBACK_STRIKES
+#define LINK_FALLBACK_STRIKES 3
+#endif
+
+
+/** @brief Số lỗi nhận (UART hoặc CRC) liên tiếp trước khi quay về tốc độ mặc định. */
+#ifndef LINK_FALLBACK_RX_ERRORS
+#define LINK_FALLBACK_RX_ERRORS 8
+#endif
+
+
+/** @brief Số byte mẫu thử trong PROBE_ACK. */
+#define LINK_PROBE_SIZE 256
+
+
+/** @brief Byte thứ i của mẫu thử; 256 byte đầu chứa mỗi giá trị byte đúng một lần. */
+#define LINK_PROBE_BYTE(i) ((uint8_t)((i) * 0x4Bu + 0x1Du))
+
+
+/** @brief Payload lớn nhất của một khung nhận từ host. */
+#define LINK_RX_PAYLOAD_MAX 32
+
+
+typedef enum {
+    LINK_OP_PROPOSE    = 1,                      /**< Host đề xuất tốc độ baud. */
+    LINK_OP_ACCEPT     = 2,                      /**< Thiết bị chấp nhận, arg = oversampling. */
+    LINK_OP_REJECT     = 3,                      /**< Thiết bị không đạt được tốc độ này. */
+    LINK_OP_PROBE      = 4,                      /**< Host kiểm tra tốc độ mới. */
+    LINK_OP_PROBE_ACK  = 5,                      /**< Trả lời PROBE, kèm mẫu thử. */
+    LINK_OP_COMMIT     = 6,                      /**< Host xác nhận mẫu thử hợp lệ. */
+    LINK_OP_COMMIT_ACK = 7,                      /**< Thiết bị giữ tốc độ mới. */
+    LINK_OP_KEEPALIVE  = 8,                      /**< Host còn nghe, arg = tỉ lệ khung lỗi CRC (‰) từ lần trước. */
+    LINK_OP_STATUS     = 9,                      /**< Tốc độ hiện tại của thiết bị, arg = link_reason_t. */
+} link_op_t;
+
+
+typedef enum {
+    LINK_REASON_NONE              = 0,           /**< Trả lời KEEPALIVE. */
+    LINK_REASON_TRIAL_TIMEOUT     = 1,           /**< Không nhận được COMMIT. */
+    LINK_REASON_KEEPALIVE_TIMEOUT = 2,           /**< Host im lặng quá lâu. */
+    LINK_REASON_CRC_ERRORS        = 3,           /**< Host báo lỗi CRC liên tiếp. */
+    LINK_REASON_RX_ERRORS         = 4,           /**< Đường nhận của thiết bị lỗi liên tiếp. */
+} link_reason_t;
+
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  data_id;
+    uint8_t  op;
+    uint32_t baud;
+    uint16_t arg;
+} link_control_data_t;
+#pragma pack(pop)
+
+
+/**
+ * @brief Khởi tạo liên kết ở tốc độ hiện tại của USART2 và bắt đầu nhận.
+ */
+void link_init(void);
+
+
+/**
+ * @brief Xử lý các khung đã nhận và các mốc thời gian của liên kết.
+ * Gọi thường xuyên từ vòng lặp chính, không bao giờ chờ trừ lúc đổi tốc độ baud.
+ * @param[in]: now Thời gian hiện tại (ms).
+ */
+void link_poll(uint32_t now);
+
+
+/**
+ * @brief Số khung nhận được từ host sai CRC kể từ khi khởi động.
+ */
+uint32_t link_get_rx_crc_errors(void);
+
+#endif /* INC_LINK_H_ */
@@ -0,0 +1,126 @@
+/*
+ * Pool.h
+ *
+ *  Created on: Apr 16, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_POOL_H_
+#define INC_POOL_H_
+
+#include <Benchmark.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Pool bộ đệm khối cố định chia theo lớp kích thước. Mỗi lớp giữ một danh sách
+ * khối rỗi liên kết ngay trong khối, nên cấp phát và giải phóng đều O(1).
+ * Pool không khóa ngắt: chỉ gọi từ main context.
+ *
+ * Mỗi lớp được định cỡ theo người dùng của nó: khung gộp (Batch.c, BATCH_HEADER_SIZE +
+ * BATCH_DEFAULT_MAX_BYTES = 258 byte) lấy khối medium khi có bản ghi đầu tiên và trả lại khi
+ * phát, gói tin mẫu của Benchmark.c lấy khối jumbo trong lúc đo. Khối jumbo chỉ có khi
+ * BENCHMARK_ENABLED, nên mặc định pool chiếm 272 byte thay cho bộ đệm tĩnh 1024 byte trước đây.
+ * batch_configure() giới hạn max_bytes theo pool_block_max(): muốn gộp đến cả payload thì
+ * đặt POOL_JUMBO_BLOCK_COUNT=1. Lớp small chưa có người dùng nên mặc định không có khối nào.
+ */
+
+/** @brief Lớp kích thước của khối trong pool. */
+typedef enum {
+    POOL_CLASS_SMALL  = 0,                       /**< Bản ghi và lệnh ngắn. */
+    POOL_CLASS_MEDIUM = 1,                       /**< Khung gộp với cấu hình mặc định. */
+    POOL_CLASS_JUMBO  = 2,                       /**< Một gói tin đầy đủ (packet_t). */
+} pool_class_t;
+
+/** @brief Số lớp kích thước của pool. */
+#define POOL_CLASS_COUNT 3
+
+
+/** @brief Kích thước khối (byte, bội số của 4) và số khối của từng lớp. */
+#ifndef POOL_SMALL_BLOCK_SIZE
+#define POOL_SMALL_BLOCK_SIZE 32
+#endif
+
+#ifndef POOL_SMALL_BLOCK_COUNT
+#define POOL_SMALL_BLOCK_COUNT 0
+#endif
+
+#ifndef POOL_MEDIUM_BLOCK_SIZE
+#define POOL_MEDIUM_BLOCK_SIZE 272
+#endif
+
+#ifndef POOL_MEDIUM_BLOCK_COUNT
+#define POOL_MEDIUM_BLOCK_COUNT 1
+#endif
+
+// Khối jumbo vừa một packet_t (PACKET_OVERHEAD + MAX_PAYLOAD_SIZE + checksum)
+#ifndef POOL_JUMBO_BLOCK_SIZE
+#define POOL_JUMBO_BLOCK_SIZE 1032
+#endif
+
+#ifndef POOL_JUMBO_BLOCK_COUNT
+#if BENCHMARK_ENABLED
+#define POOL_JUMBO_BLOCK_COUNT 1
+#else
+#define POOL_JUMBO_BLOCK_COUNT 0
+#endif
+#endif
+
+
+typedef struct {
+    uint16_t block_size;                         /**< Kích thước một khối (byte). */
+    uint16_t block_count;                        /**< Tổng số khối của lớp. */
+    uint16_t in_use;                             /**< Số khối đang được cấp phát. */
+    uint16_t high_watermark;                     /**< Số khối được cấp phát đồng thời nhiều nhất. */
+    uint32_t allocs;                             /**< Số lần cấp phát thành công từ lớp này. */
+    uint32_t failures;                           /**< Số lần lớp này hết khối (kể cả khi lớp lớn hơn đáp ứng thay). */
+} pool_stats_t;
+
+
+/**
+ * @brief Khởi tạo pool, mọi khối trở về trạng thái rỗi.
+ */
+void pool_init(void);
+
+
+/**
+ * @brief Cấp phát một khối đủ chứa size byte.
+ * Lớp nhỏ nhất phù hợp được thử trước; nếu lớp đó hết khối thì dùng lớp lớn hơn.
+ * @param[in]: size Số byte cần dùng.
+ * @return  Con trỏ đến khối (căn 4 byte), NULL nếu không còn khối phù hợp.
+ */
+void* pool_alloc(size_t size);
+
+
+/**
+ * @brief Trả một khối về pool.
+ * @param[in]: block Con trỏ trả về bởi pool_alloc(), NULL được bỏ qua.
+ */
+void pool_release(void* block);
+
+
+/**
+ * @brief Kích thước khối lớn nhất mà pool có thể cấp phát.
+ * @return  Số byte, 0 nếu pool không có khối nào.
+ */
+size_t pool_block_max(void);
+
+
+/**
+ * @brief Lấy thống kê của một lớp kích thước.
+ * @param[in]: pool_class Lớp kích thước (pool_class_t).
+ * @return  Con trỏ đến thống kê, NULL nếu lớp không hợp lệ.
+ */
+const pool_stats_t* pool_get_stats(uint8_t pool_class);
+
+
+/**
+ * @brief Định dạng thống kê của một lớp thành một dòng chữ.
+ * @param[in]:  pool_class Lớp kích thước (pool_class_t).
+ * @param[out]: buffer     Bộ đệm nhận chuỗi.
+ * @param[in]:  size       Kích thước bộ đệm.
+ * @return  Độ dài chuỗi, 0 nếu lớp không hợp lệ hoặc không có khối.
+ */
+uint16_t pool_format_stats(uint8_t pool_class, char *buffer, size_t size);
+
+#endif /* INC_POOL_H_ */
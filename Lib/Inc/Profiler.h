@@ -0,0 +1,97 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: Apr 21, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_PROFILER_H_
+#define INC_PROFILER_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Bật bộ đo chu kỳ trên các đoạn mã nóng.
+ * Khi bằng 0 mọi macro PROFILE_* rỗng và Profiler.c không sinh mã nào.
+ */
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+
+
+/** @brief Các điểm đo trên đường phát khung. */
+typedef enum {
+    PROFILER_PROBE_PACK_PACKET = 0,              /**< pack_packet(). */
+    PROFILER_PROBE_CRC16       = 1,              /**< calculate_crc16(). */
+    PROFILER_PROBE_SEND_PACKET = 2,              /**< send_packet(). */
+    PROFILER_PROBE_COMMIT      = 3,              /**< commit_packet() (checksum và đưa vào hàng đợi). */
+    PROFILER_PROBE_UART_TX     = 4,              /**< Lời gọi HAL_UART_Transmit(_DMA). */
+} profiler_probe_t;
+
+/** @brief Số điểm đo. */
+#define PROFILER_PROBE_COUNT 5
+
+
+/**
+ * @brief Số ô của histogram; ô k đếm các lần đo có số chu kỳ trong [2^k, 2^(k+1)),
+ *      ô cuối cùng gom mọi lần đo lớn hơn.
+ */
+#define PROFILER_HISTOGRAM_BINS 16
+
+
+typedef struct {
+    uint32_t count;                              /**< Số lần đo. */
+    uint32_t min;                                /**< Số chu kỳ nhỏ nhất. */
+    uint32_t max;                                /**< Số chu kỳ lớn nhất. */
+    uint64_t sum;                                /**< Tổng số chu kỳ, dùng để tính trung bình. */
+    uint16_t histogram[PROFILER_HISTOGRAM_BINS]; /**< Phân bố theo log2 số chu kỳ (bão hòa ở 65535). */
+} profiler_stats_t;
+
+
+#if PROFILER_ENABLED
+
+#include <Utils.h>
+
+/** @brief Bắt đầu đo một đoạn mã, phải đi cặp với PROFILE_END() trong cùng khối. */
+#define PROFILE_BEGIN(probe)    uint32_t profile_start_##probe = Driver_GetCycles()
+
+/** @brief Kết thúc đo và ghi kết quả vào điểm đo. */
+#define PROFILE_END(probe)      profiler_record((probe), Driver_GetCycles() - profile_start_##probe)
+
+
+/**
+ * @brief Khởi tạo bộ đo: bật bộ đếm chu kỳ, đo chi phí của chính cặp macro và xóa thống kê.
+ */
+void profiler_init(void);
+
+
+/**
+ * @brief Ghi một lần đo vào điểm đo.
+ * @param[in]: probe  Điểm đo (profiler_probe_t).
+ * @param[in]: cycles Số chu kỳ đo được, chưa trừ chi phí đo.
+ */
+void profiler_record(uint8_t probe, uint32_t cycles);
+
+
+/**
+ * @brief Lấy thống kê của một điểm đo.
+ * @param[in]: probe Điểm đo (profiler_probe_t).
+ * @return  Con trỏ đến thống kê, NULL nếu điểm đo không hợp lệ.
+ */
+const profiler_stats_t* profiler_get_stats(uint8_t probe);
+
+
+/**
+ * @brief Gửi thống kê của mọi điểm đo trong một khung PROFILER_DATA_ID rồi xóa chúng.
+ * Mỗi báo cáo vì vậy chỉ chứa các lần đo kể từ báo cáo trước.
+ */
+void profiler_send_report(void);
+
+#else
+
+#define PROFILE_BEGIN(probe)    do { } while (0)
+#define PROFILE_END(probe)      do { } while (0)
+
+#endif /* PROFILER_ENABLED */
+
+#endif /* INC_PROFILER_H_ */
@@ -8,6 +8,7 @@
 #ifndef INC_PROTOCOL_H_
 #define INC_PROTOCOL_H_
 
+#include <Utils.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -27,6 +28,74 @@ static const uint8_t HEADER_BYTE2 = 0xAB;
 #define MAX_PAYLOAD_SIZE 1024
 
 
+/**
+ * @brief Byte thứ hai của tiêu đề khung mở rộng.
+ * Khung mở rộng có thêm một byte cờ ngay sau tiêu đề:
+ *      [DE AC][cờ (1)][timestamp][seq (2, nếu có FRAME_FLAG_SEQ)][payload_size][payload][checksum].
+ * Bộ giải mã cũ chỉ nhận DE AB nên bỏ qua các khung này thay vì giải mã sai.
+ */
+static const uint8_t HEADER_BYTE2_EXT = 0xAC;
+
+
+/** @brief Cờ khung mở rộng: checksum là CRC-32 4 byte tính bởi bộ CRC phần cứng. */
+#define FRAME_FLAG_CRC32 0x01
+
+
+/** @brief Cờ khung mở rộng: timestamp 32 bit tính bằng micro giây thay cho 16 bit mili giây. */
+#define FRAME_FLAG_TS32  0x02
+
+
+/** @brief Cờ khung mở rộng: số thứ tự 16 bit của chế độ truyền tin cậy (Reliable.h). */
+#define FRAME_FLAG_SEQ   0x04
+
+
+/** @brief Cờ khung mở rộng: khung được phát lại từ nhật ký flash (FlashLog.h), timestamp là lúc ghi. */
+#define FRAME_FLAG_LOG   0x08
+
+
+/**
+ * @brief Dùng bộ CRC phần cứng (CRC-32) cho checksum của các khung reserve_packet().
+ * 0: khung gốc DE AB với CRC16 tính bằng phần mềm.
+ */
+#ifndef PROTOCOL_CRC32_HW
+#define PROTOCOL_CRC32_HW 0
+#endif
+
+
+/**
+ * @brief Đóng khung bằng COBS (Cobs.h) trên đường truyền đến host.
+ * Mỗi khung (DE AB/DE AC như trên, kể cả checksum) được mã hóa để không còn byte 0 nào
+ *      và kết thúc bằng một byte 0, nên host tách khung ở byte 0 thay vì tìm tiêu đề và
+ *      đồng bộ lại sau đúng một khung khi có lỗi. Đường nhận từ host (Link.c) không đổi.
+ * 0: khung được phát nguyên dạng.
+ */
+#ifndef PROTOCOL_COBS
+#define PROTOCOL_COBS 0
+#endif
+
+
+/** @brief Các cờ cố định của khung được phát bởi reserve_packet(), 0 nghĩa là khung gốc. */
+#define PROTOCOL_FRAME_FLAGS ((PROTOCOL_CRC32_HW ? FRAME_FLAG_CRC32 : 0) | \
+                              (DRIVER_TIMESTAMP_US ? FRAME_FLAG_TS32 : 0))
+
+
+/** @brief Kích thước phần đầu (trước payload) của một khung có các cờ flags. */
+#define FRAME_HEADER_SIZE_OF(flags) (PACKET_OVERHEAD + ((flags) ? sizeof(uint8_t) : 0) + \
+                                     (((flags) & FRAME_FLAG_TS32) ? sizeof(uint16_t) : 0) + \
+                                     (((flags) & FRAME_FLAG_SEQ) ? sizeof(uint16_t) : 0))
+
+
+/**
+ * @brief Kích thước phần đầu (trước payload) của khung được phát bởi reserve_packet().
+ * Khi chế độ tin cậy đang bật, khung có thêm FRAME_FLAG_SEQ và dài hơn.
+ */
+#define FRAME_HEADER_SIZE FRAME_HEADER_SIZE_OF(PROTOCOL_FRAME_FLAGS)
+
+
+/** @brief Kích thước checksum của khung được phát bởi reserve_packet(). */
+#define FRAME_CHECKSUM_SIZE ((PROTOCOL_FRAME_FLAGS & FRAME_FLAG_CRC32) ? sizeof(uint32_t) : sizeof(uint16_t))
+
+
 #pragma pack(push, 1)
 typedef struct {
     uint16_t header;                             /**< Tiêu đề của gói tin. */
@@ -59,6 +128,36 @@ uint16_t calculate_crc16(uint8_t *data, uint16_t length);
 void pack_packet(packet_t *packet, uint8_t *payload, uint16_t payload_length);
 
 
+/**
+ * @brief Giữ chỗ một khung trong bộ đệm truyền và trả về vùng payload của nó.
+ * Người gọi ghi payload trực tiếp vào vùng này hoặc qua append_packet() rồi gọi commit_packet(),
+ * 			không cần dựng struct tạm hay packet_t trung gian.
+ * Chỉ được có một khung đang giữ chỗ tại một thời điểm.
+ * @param[in]: payload_length Độ dài payload, không vượt quá MAX_PAYLOAD_SIZE.
+ * @param[in]: priority       Mức ưu tiên truyền (driver_uart_priority_t) của khung.
+ * @return  Con trỏ đến vùng payload, NULL nếu độ dài không hợp lệ, bộ đệm truyền đầy
+ *          hoặc cửa sổ của chế độ tin cậy đầy.
+ */
+uint8_t* reserve_packet(uint16_t payload_length, uint8_t priority);
+
+
+/**
+ * @brief Chép dữ liệu nối tiếp vào payload của khung đang giữ chỗ.
+ * Dữ liệu được chép và tính CRC trong cùng một lượt. Các lần gọi ghi nối tiếp
+ * 			từ đầu payload; phần payload ghi trực tiếp phải nằm sau phần đã append.
+ * @param[in]: data   Dữ liệu cần ghi.
+ * @param[in]: length Số byte, phần vượt quá payload đã giữ chỗ bị cắt bỏ.
+ */
+void append_packet(const uint8_t* data, uint16_t length);
+
+
+/**
+ * @brief Hoàn tất khung đã giữ chỗ bởi reserve_packet() và phát nó đi.
+ * Tiêu đề đã được ghi khi giữ chỗ; hàm hoàn tất checksum quanh payload đã ghi.
+ */
+void commit_packet(void);
+
+
 /**
  * @brief Gửi gói tin qua giao thức truyền thông.
  * Hàm này chịu trách nhiệm gửi gói tin đã được đóng gói
@@ -67,5 +166,19 @@ void pack_packet(packet_t *packet, uint8_t *payload, uint16_t payload_length);
  */
 void send_packet(packet_t *packet);
 
+
+/**
+ * @brief Phát lại một khung đã lưu trong nhật ký flash.
+ * Khung mới là khung mở rộng có FRAME_FLAG_LOG, giữ nguyên timestamp (và FRAME_FLAG_TS32) của
+ *      khung đã lưu; checksum, COBS và số thứ tự của chế độ tin cậy theo cấu hình hiện tại.
+ * Hàm không chờ: khung chỉ được phát khi bộ đệm truyền của mức ưu tiên còn đủ chỗ.
+ * @param[in]: frame    Khung đã lưu (tiêu đề và payload, không có checksum).
+ * @param[in]: length   Độ dài khung đã lưu.
+ * @param[in]: priority Mức ưu tiên truyền (driver_uart_priority_t).
+ * @return  1 nếu đã phát, 0 nếu bộ đệm truyền hoặc cửa sổ của chế độ tin cậy đầy,
+ *          -1 nếu khung đã lưu không hợp lệ.
+ */
+int8_t replay_packet(const uint8_t* frame, uint16_t length, uint8_t priority);
+
 #endif /* INC_PROTOCOL_H_ */
 
@@ -0,0 +1,196 @@
+/*
+ * Reliable.h
+ *
+ *  Created on: May 12, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_RELIABLE_H_
+#define INC_RELIABLE_H_
+
+#include <Application.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Chế độ truyền tin cậy tùy chọn: cửa sổ trượt với gửi lại có chọn lọc.
+ * Host bật chế độ bằng khung RELIABLE_DATA_ID trên đường RX (DE AB + CRC16, như Link.c).
+ * Từ đó mọi khung của reserve_packet() là khung mở rộng có FRAME_FLAG_SEQ, số thứ tự tăng 1
+ * cho mỗi khung mới, và một bản sao của khung được giữ trong bộ đệm gửi lại đến khi host xác nhận:
+ *
+ *      ACK: seq   = số thứ tự host đang chờ (mọi khung trước nó đã nhận),
+ *           value = bitmap xác nhận chọn lọc, bit i là khung seq + 1 + i đã nhận.
+ *
+ * Khung còn thiếu đứng trước khung được xác nhận chọn lọc cao nhất được gửi lại ngay
+ * (không sớm hơn RELIABLE_HOLDOFF_MS kể từ lần gửi trước); khung không được xác nhận sau
+ * RELIABLE_TIMEOUT_MS được gửi lại khi hết hạn. Sau RELIABLE_MAX_RETRIES lần gửi lại khung
+ * bị bỏ và được đếm là mất. Khung gửi lại giống hệt bản gốc (cùng seq, timestamp, checksum).
+ *
+ * Khi số khung chưa xác nhận đạt kích thước cửa sổ hoặc bộ đệm gửi lại hết chỗ,
+ * reserve_packet() trả về NULL như khi bộ đệm truyền đầy và khung được đếm vào stalls.
+ * Nếu host im lặng quá RELIABLE_IDLE_TIMEOUT_MS trong khi còn khung chưa xác nhận,
+ * thiết bị tự tắt chế độ để luồng dữ liệu không bị chặn mãi.
+ */
+
+/**
+ * @brief Biên dịch chế độ tin cậy.
+ * Mặc định tắt vì bộ đệm gửi lại và bảng khung chiếm gần 9 KB RAM; khi tắt, khung
+ *      RELIABLE_DATA_ID từ host bị bỏ qua và py.py --reliable không nhận được STATUS.
+ */
+#ifndef RELIABLE_ENABLED
+#define RELIABLE_ENABLED 0
+#endif
+
+
+/** @brief Kích thước cửa sổ lớn nhất (số khung chưa xác nhận), lũy thừa của 2. */
+#define RELIABLE_WINDOW_MAX 64
+
+
+/** @brief Kích thước cửa sổ khi host không chỉ định. */
+#ifndef RELIABLE_WINDOW_DEFAULT
+#define RELIABLE_WINDOW_DEFAULT 32
+#endif
+
+
+/** @brief Dung lượng bộ đệm gửi lại (byte), chứa nguyên khung đã đóng gói. */
+#ifndef RELIABLE_BUFFER_SIZE
+#define RELIABLE_BUFFER_SIZE 8192
+#endif
+
+
+/** @brief Thời gian chờ xác nhận trước khi gửi lại, gồm cả thời gian nằm trong hàng đợi truyền (ms). */
+#ifndef RELIABLE_TIMEOUT_MS
+#define RELIABLE_TIMEOUT_MS 500
+#endif
+
+
+/** @brief Khoảng cách tối thiểu giữa hai lần gửi lại một khung do xác nhận chọn lọc (ms). */
+#ifndef RELIABLE_HOLDOFF_MS
+#define RELIABLE_HOLDOFF_MS 50
+#endif
+
+
+/** @brief Số lần gửi lại tối đa của một khung trước khi bỏ nó. */
+#ifndef RELIABLE_MAX_RETRIES
+#define RELIABLE_MAX_RETRIES 8
+#endif
+
+
+/** @brief Thời gian tối đa không nhận được ACK khi còn khung chưa xác nhận (ms). */
+#ifndef RELIABLE_IDLE_TIMEOUT_MS
+#define RELIABLE_IDLE_TIMEOUT_MS 5000
+#endif
+
+
+typedef enum {
+    RELIABLE_OP_ENABLE  = 1,                     /**< Host bật chế độ, value = kích thước cửa sổ (0 = mặc định). */
+    RELIABLE_OP_DISABLE = 2,                     /**< Host tắt chế độ. */
+    RELIABLE_OP_ACK     = 3,                     /**< Xác nhận tích lũy (seq) và chọn lọc (value). */
+    RELIABLE_OP_STATUS  = 4,                     /**< Trả lời ENABLE/DISABLE: seq = số thứ tự kế tiếp, value = cửa sổ (0 = tắt). */
+} reliable_op_t;
+
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  data_id;
+    uint8_t  op;
+    uint16_t seq;
+    uint32_t value;
+} reliable_control_data_t;
+#pragma pack(pop)
+
+
+typedef struct {
+    uint32_t sent;                               /**< Số khung mới đã được đánh số. */
+    uint32_t retransmits;                        /**< Số lần gửi lại (chọn lọc và hết hạn). */
+    uint32_t timeouts;                           /**< Số lần gửi lại do hết hạn. */
+    uint32_t lost;                               /**< Số khung bị bỏ khi chưa được xác nhận. */
+    uint32_t stalls;                             /**< Số khung bị từ chối vì cửa sổ hoặc bộ đệm đầy. */
+    uint32_t acks;                               /**< Số ACK hợp lệ đã nhận. */
+} reliable_stats_t;
+
+
+#if RELIABLE_ENABLED
+
+/**
+ * @brief Chế độ tin cậy có đang bật hay không.
+ */
+uint8_t reliable_is_enabled(void);
+
+
+/**
+ * @brief Kiểm tra cửa sổ và bộ đệm gửi lại cho một khung mới.
+ * Gọi bởi reserve_packet(); vùng đệm được chọn ở đây và chỉ được dùng khi reliable_commit().
+ * @param[in]:  frame_length Độ dài cả khung.
+ * @param[out]: seq          Số thứ tự của khung.
+ * @return  1 nếu khung được nhận, 0 nếu cửa sổ hoặc bộ đệm đầy.
+ */
+uint8_t reliable_reserve(uint16_t frame_length, uint16_t* seq);
+
+
+/**
+ * @brief Lưu bản sao của khung đã hoàn tất vào bộ đệm gửi lại.
+ * Gọi bởi commit_packet() ngay sau reliable_reserve() thành công.
+ * @param[in]: frame    Khung đã có checksum.
+ * @param[in]: length   Độ dài khung.
+ * @param[in]: priority Mức ưu tiên truyền, dùng lại khi gửi lại.
+ */
+void reliable_commit(const uint8_t* frame, uint16_t length, uint8_t priority);
+
+
+/**
+ * @brief Xử lý khung RELIABLE_DATA_ID nhận từ host.
+ * @param[in]: payload Payload của khung.
+ * @param[in]: size    Độ dài payload.
+ * @param[in]: now     Thời gian hiện tại (ms).
+ */
+void reliable_handle(const uint8_t* payload, uint16_t size, uint32_t now);
+
+
+/**
+ * @brief Gửi lại các khung hết hạn và tắt chế độ khi host im lặng quá lâu.
+ * @param[in]: now Thời gian hiện tại (ms).
+ */
+void reliable_poll(uint32_t now);
+
+
+/**
+ * @brief Thống kê của chế độ tin cậy kể từ khi khởi động.
+ */
+const reliable_stats_t* reliable_get_stats(void);
+
+
+/** @brief Bộ đệm đủ cho dòng của reliable_format_stats(): hai số 16 bit, năm số 32 bit và '\0'. */
+#define RELIABLE_STATS_LINE_SIZE (sizeof("reliable win= inflight= sent= retx= timeouts= lost= stalls=") + 2 * 5 + 5 * 10)
+
+
+/**
+ * @brief Ghi thống kê của chế độ tin cậy thành một dòng văn bản.
+ * @param[in]: buffer Bộ đệm nhận chuỗi.
+ * @param[in]: size   Kích thước bộ đệm.
+ * @return  Độ dài chuỗi (không kể '\0'), 0 nếu chế độ chưa từng được dùng.
+ */
+uint16_t reliable_format_stats(char *buffer, size_t size);
+
+#else
+
+static inline uint8_t reliable_is_enabled(void)
+{
+    return 0;
+}
+
+static inline void reliable_handle(const uint8_t* payload, uint16_t size, uint32_t now)
+{
+    (void)payload;
+    (void)size;
+    (void)now;
+}
+
+static inline void reliable_poll(uint32_t now)
+{
+    (void)now;
+}
+
+#endif /* RELIABLE_ENABLED */
+
+#endif /* INC_RELIABLE_H_ */
@@ -0,0 +1,126 @@
+/*
+ * Scheduler.h
+ *
+ *  Created on: Apr 14, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bộ lập lịch luồng tuần hoàn. Phần lõi không phụ thuộc HAL: thời gian hiện tại
+ * được truyền vào từ bên ngoài (tick thật trên board, tick mô phỏng trên máy host).
+ */
+
+/** @brief Tần số của đơn vị thời gian truyền vào scheduler (tick/giây). */
+#ifndef SCHEDULER_TICK_HZ
+#define SCHEDULER_TICK_HZ 1000u
+#endif
+
+
+/** @brief Số luồng tối đa, chỉ số luồng thường là data_id. */
+#ifndef SCHEDULER_MAX_STREAMS
+#define SCHEDULER_MAX_STREAMS 16
+#endif
+
+
+/** @brief Hàm tạo dữ liệu cho một luồng, được gọi tại mỗi deadline. */
+typedef void (*scheduler_producer_t)(void);
+
+
+typedef struct {
+    uint32_t runs;                               /**< Số lần producer đã được gọi. */
+    uint32_t missed;                             /**< Số deadline bị bỏ qua do trễ quá một chu kỳ. */
+    uint32_t jitter_max;                         /**< Độ trễ lớn nhất so với deadline (tick). */
+    uint32_t jitter_sum;                         /**< Tổng độ trễ so với deadline (tick). */
+} scheduler_stats_t;
+
+
+/**
+ * @brief Khởi tạo scheduler, xóa mọi luồng đã đăng ký.
+ */
+void scheduler_init(void);
+
+
+/**
+ * @brief Đăng ký producer cho một luồng với tần số cho trước.
+ * @param[in]: stream_id Chỉ số luồng (0..SCHEDULER_MAX_STREAMS-1).
+ * @param[in]: producer  Hàm tạo dữ liệu.
+ * @param[in]: rate_hz   Tần số (Hz), 0 để tạm tắt luồng.
+ * @param[in]: now       Thời gian hiện tại (tick).
+ */
+void scheduler_add(uint8_t stream_id, scheduler_producer_t producer, uint16_t rate_hz, uint32_t now);
+
+
+/**
+ * @brief Thay đổi tần số của một luồng khi đang chạy.
+ * Deadline đầu tiên với tần số mới là now + một chu kỳ; thống kê được giữ nguyên.
+ * @param[in]: stream_id Chỉ số luồng.
+ * @param[in]: rate_hz   Tần số mới (Hz), 0 để tắt luồng.
+ * @param[in]: now       Thời gian hiện tại (tick).
+ */
+void scheduler_set_rate(uint8_t stream_id, uint16_t rate_hz, uint32_t now);
+
+
+/**
+ * @brief Lấy tần số hiện tại của một luồng.
+ * @param[in]: stream_id Chỉ số luồng.
+ * @return  Tần số (Hz), 0 nếu luồng tắt hoặc chưa đăng ký.
+ */
+uint16_t scheduler_get_rate(uint8_t stream_id);
+
+
+/**
+ * @brief Kiểm tra một luồng đã được đăng ký hay chưa.
+ * @param[in]: stream_id Chỉ số luồng.
+ * @return  1 nếu đã đăng ký (kể cả khi đang tắt), 0 nếu không.
+ */
+uint8_t scheduler_has_stream(uint8_t stream_id);
+
+
+/**
+ * @brief Gọi producer của một luồng ngay lập tức, ngoài lịch.
+ * Deadline và thống kê của luồng không thay đổi.
+ * @param[in]: stream_id Chỉ số luồng.
+ * @return  1 nếu đã gọi, 0 nếu luồng chưa đăng ký.
+ */
+uint8_t scheduler_trigger(uint8_t stream_id);
+
+
+/**
+ * @brief Gọi producer của mọi luồng đã đến deadline.
+ * Deadline kế tiếp được tính từ deadline trước (không từ now) nên pha không bị trôi;
+ *      nếu trễ quá một chu kỳ, các deadline đã lỡ được đếm vào missed và bỏ qua.
+ * @param[in]: now Thời gian hiện tại (tick).
+ */
+void scheduler_run(uint32_t now);
+
+
+/**
+ * @brief Lấy thống kê của một luồng.
+ * @param[in]: stream_id Chỉ số luồng.
+ * @return  Con trỏ đến thống kê, NULL nếu chỉ số không hợp lệ.
+ */
+const scheduler_stats_t* scheduler_get_stats(uint8_t stream_id);
+
+
+/**
+ * @brief Xóa thống kê của mọi luồng.
+ */
+void scheduler_reset_stats(void);
+
+
+/**
+ * @brief Định dạng thống kê của một luồng thành chuỗi để gửi đi.
+ * @param[in]:  stream_id Chỉ số luồng.
+ * @param[out]: buffer    Bộ đệm nhận chuỗi.
+ * @param[in]:  size      Kích thước bộ đệm.
+ * @return  Độ dài chuỗi, 0 nếu luồng chưa đăng ký.
+ */
+uint16_t scheduler_format_stats(uint8_t stream_id, char *buffer, size_t size);
+
+#endif /* INC_SCHEDULER_H_ */
@@ -0,0 +1,39 @@
+/*
+ * Stats.h
+ *
+ *  Created on: May 20, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_STATS_H_
+#define INC_STATS_H_
+
+#include <Button.h>
+#include <FlashLog.h>
+#include <Reliable.h>
+#include <stdint.h>
+
+/*
+ * Báo cáo thống kê dạng chuỗi: mỗi module ghi dòng của mình bằng *_format_stats()
+ * (format_line() trong Utils.h) và các dòng được gửi lần lượt bằng send_string_data().
+ * Dùng chung cho main.c và Host/protocol_bench.c.
+ */
+
+/** @brief Bộ đệm đủ cho dòng dài nhất: nhật ký flash, rồi chế độ tin cậy, rồi nút nhấn. */
+#if FLASH_LOG_ENABLED
+#define STATS_LINE_SIZE FLASH_LOG_STATS_LINE_SIZE
+#elif RELIABLE_ENABLED
+#define STATS_LINE_SIZE RELIABLE_STATS_LINE_SIZE
+#else
+#define STATS_LINE_SIZE BUTTON_STATS_LINE_SIZE
+#endif
+
+
+/**
+ * @brief Gửi mọi dòng thống kê; gọi định kỳ và khi host yêu cầu (COMMAND_STREAM_STATS).
+ * Lịch phát của từng luồng, độ trễ của từng mức ưu tiên truyền (rồi đặt lại), từng lớp
+ *      khối của pool, rồi ADC, nút nhấn, chế độ tin cậy và nhật ký flash nếu được bật.
+ */
+void stats_report_all(void);
+
+#endif /* INC_STATS_H_ */
@@ -0,0 +1,63 @@
+/*
+ * Temperature.h
+ *
+ *  Created on: May 08, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#ifndef INC_TEMPERATURE_H_
+#define INC_TEMPERATURE_H_
+
+#include <stdint.h>
+
+/*
+ * Nhiệt độ MCU từ cảm biến trong (ADC1 kênh 16). Mỗi TEMPERATURE_PERIOD_MS một loạt
+ * TEMPERATURE_OVERSAMPLE chuyển đổi injected chạy nền (Driver_TempSensor_*), kết quả trung
+ * bình được lọc thông thấp rồi đổi sang phần trăm độ C bằng giá trị hiệu chuẩn của nhà sản
+ * xuất. Vòng lặp chính không bao giờ chờ ADC.
+ */
+
+/** @brief Số chuyển đổi của một loạt (trung bình cộng). */
+#ifndef TEMPERATURE_OVERSAMPLE
+#define TEMPERATURE_OVERSAMPLE 64
+#endif
+
+/** @brief Chu kỳ bắt đầu một loạt mới (ms). */
+#ifndef TEMPERATURE_PERIOD_MS
+#define TEMPERATURE_PERIOD_MS 100
+#endif
+
+/** @brief Hệ số của bộ lọc: mỗi loạt đóng góp 1/2^TEMPERATURE_FILTER_SHIFT vào giá trị lọc. */
+#ifndef TEMPERATURE_FILTER_SHIFT
+#define TEMPERATURE_FILTER_SHIFT 3
+#endif
+
+/**
+ * @brief Giá trị hiệu chuẩn điển hình (VDDA = 3.3 V, V25 = 0.76 V, 2.5 mV/°C),
+ *      dùng khi system memory không chứa giá trị hợp lệ.
+ */
+#define TEMPERATURE_CAL30_TYPICAL  959
+#define TEMPERATURE_CAL110_TYPICAL 1207
+
+
+/**
+ * @brief Đọc giá trị hiệu chuẩn và bắt đầu loạt chuyển đổi đầu tiên.
+ */
+void temperature_init(void);
+
+
+/**
+ * @brief Lấy kết quả của loạt vừa xong và bắt đầu loạt mới khi đến hạn.
+ * @param[in]: now Thời gian hiện tại (ms).
+ */
+void temperature_poll(uint32_t now);
+
+
+/**
+ * @brief Lấy nhiệt độ đã lọc.
+ * @param[out]: centi_c Nhiệt độ theo đơn vị 0.01 °C.
+ * @return  1 nếu đã có giá trị, 0 nếu chưa có loạt nào xong.
+ */
+uint8_t temperature_get_centi(int16_t* centi_c);
+
+#endif /* INC_TEMPERATURE_H_ */
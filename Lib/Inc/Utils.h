@@ -8,8 +8,19 @@
 #ifndef INC_UTILS_H_
 #define INC_UTILS_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+/**
+ * @brief Chế độ timestamp của khung.
+ * 1: timestamp 32 bit tính bằng micro giây, lấy từ bộ đếm chu kỳ DWT (khung mở rộng).
+ * 0: timestamp 16 bit tính bằng mili giây, lấy từ HAL_GetTick() (khung gốc).
+ */
+#ifndef DRIVER_TIMESTAMP_US
+#define DRIVER_TIMESTAMP_US 0
+#endif
+
+
 /**
  * @brief Lấy thời gian hệ thống hiện tại tính bằng mili giây.
  * Hàm này trả về thời gian hiện tại của hệ thống tính bằng mili giây kể từ  khi hệ thống khởi động.
@@ -17,6 +28,59 @@
  */
 uint32_t Driver_GetTimeMs(void);
 
+
+/**
+ * @brief Bật bộ đếm chu kỳ DWT CYCCNT của Cortex-M4.
+ * Cần được gọi một lần trước khi dùng Driver_GetCycles(); gọi lại khi bộ đếm
+ *      đang chạy không làm thay đổi giá trị của nó.
+ */
+void Driver_CycleCounterInit(void);
+
+
+/**
+ * @brief Lấy giá trị hiện tại của bộ đếm chu kỳ DWT CYCCNT.
+ * Bộ đếm 32 bit chạy theo HCLK (168 MHz) nên tràn sau khoảng 25.5 giây.
+ * @return Số chu kỳ CPU kể từ khi bộ đếm được bật.
+ */
+uint32_t Driver_GetCycles(void);
+
+
+/**
+ * @brief Lấy bộ đếm chu kỳ đã được mở rộng thành 64 bit bằng phần mềm.
+ * Phải được gọi ít nhất một lần trong mỗi chu kỳ tràn của CYCCNT (~25.5 giây);
+ *      SysTick_Handler gọi hàm này mỗi mili giây nên điều kiện luôn được đảm bảo.
+ * An toàn khi gọi từ cả main context lẫn ngắt.
+ * @return Số chu kỳ CPU kể từ khi bộ đếm được bật.
+ */
+uint64_t Driver_GetCycles64(void);
+
+
+/**
+ * @brief Lấy thời gian hệ thống hiện tại tính bằng micro giây.
+ * Giá trị 32 bit tràn sau khoảng 71.6 phút.
+ * @return Thời gian hiện tại tính bằng micro giây.
+ */
+uint32_t Driver_GetTimeUs(void);
+
+
+/**
+ * @brief Đổi một khoảng chu kỳ CPU (hiệu của hai lần Driver_GetCycles()) ra micro giây.
+ * @param[in] cycles Số chu kỳ.
+ * @return Số micro giây tương ứng.
+ */
+uint32_t Driver_CyclesToUs(uint32_t cycles);
+
+
+/**
+ * @brief Ghi một dòng văn bản theo định dạng printf, dùng chung cho các hàm *_format_stats().
+ * Dòng dài hơn bộ đệm bị cắt và luôn kết thúc bằng '\0'.
+ * @param[in]: buffer Bộ đệm nhận chuỗi.
+ * @param[in]: size   Kích thước bộ đệm.
+ * @param[in]: format Chuỗi định dạng printf.
+ * @return Độ dài chuỗi đã ghi (không kể '\0'), 0 nếu bộ đệm rỗng hoặc định dạng lỗi.
+ */
+uint16_t format_line(char *buffer, size_t size, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
 #endif /* INC_UTILS_H_ */
 
 
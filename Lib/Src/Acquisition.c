@@ -0,0 +1,89 @@
+/*
+ * Acquisition.c
+ *
+ *  Created on: May 06, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Acquisition.h"
+#include "Application.h"
+#include "Driver.h"
+#include "Utils.h"
+
+
+static uint32_t acquisition_rate_hz = 0;        // Tần số thực tế, 0 = đang dừng
+
+
+/**
+ * @brief Bắt đầu (hoặc khởi động lại) luồng ADC.
+ * @param[in] rate_hz Tần số lấy mẫu (Hz).
+ * @return Tần số thực tế, 0 nếu không đạt được.
+ */
+uint32_t acquisition_start(uint32_t rate_hz)
+{
+    acquisition_rate_hz = Driver_ADC_Start(rate_hz);
+    if (acquisition_rate_hz == 0) {
+        Driver_ADC_Stop();
+    }
+
+    return acquisition_rate_hz;
+}
+
+
+/**
+ * @brief Dừng luồng ADC.
+ */
+void acquisition_stop(void)
+{
+    Driver_ADC_Stop();
+    acquisition_rate_hz = 0;
+}
+
+
+/**
+ * @brief Tần số lấy mẫu hiện tại (Hz), 0 nếu luồng đang dừng.
+ */
+uint32_t acquisition_get_rate(void)
+{
+    return acquisition_rate_hz;
+}
+
+
+/**
+ * @brief Gửi mọi khối ADC đã đầy.
+ */
+void acquisition_poll(void)
+{
+    const uint16_t *samples;
+    uint32_t first_sample;
+
+    if (acquisition_rate_hz == 0) {
+        return;
+    }
+
+    while ((samples = Driver_ADC_GetBlock(&first_sample)) != NULL) {
+        send_adc_block(first_sample, samples, DRIVER_ADC_BLOCK_SIZE);
+        Driver_ADC_ReleaseBlock();
+    }
+}
+
+
+/**
+ * @brief Ghi thống kê của luồng ADC thành một dòng văn bản.
+ * @param[in] buffer Bộ đệm nhận chuỗi.
+ * @param[in] size   Kích thước bộ đệm.
+ * @return Độ dài chuỗi (không kể '\0'), 0 nếu luồng chưa chạy.
+ */
+uint16_t acquisition_format_stats(char *buffer, size_t size)
+{
+    if (acquisition_rate_hz == 0) {
+        return 0;
+    }
+
+    const driver_adc_stats_t *stats = Driver_ADC_GetStats();
+
+    return format_line(buffer, size, "adc rate=%lu block=%u samples=%lu blocks=%lu overruns=%lu",
+                       (unsigned long)acquisition_rate_hz, DRIVER_ADC_BLOCK_SIZE,
+                       (unsigned long)stats->samples, (unsigned long)stats->blocks,
+                       (unsigned long)stats->overruns);
+}
@@ -5,16 +5,213 @@
  *      Author: MACH TRONG HAI
  */
 #include "Application.h"
+#include "Batch.h"
+#include "Driver.h"
 #include "Utils.h"
 #include <string.h>
 
-// Các biến packet toàn cục dùng để giữ trạng thái gói tin
-static packet_t global_date_packet       = {0};
-static packet_t global_time_packet       = {0};
-static packet_t global_adc_packet        = {0};
-static packet_t global_string_packet     = {0};
-static packet_t global_button_packet     = {0};
-static packet_t global_temperature_packet = {0};
+
+// Mức ưu tiên truyền của từng data_id: nút nhấn, điều khiển liên kết, lệnh > ADC > ngày/giờ/nhiệt độ > chuỗi
+static const uint8_t data_priority[] = {
+    [DATE_STREAM_DATA_ID]     = DRIVER_UART_PRIORITY_NORMAL,
+    [TIME_STREAM_DATA_ID]     = DRIVER_UART_PRIORITY_NORMAL,
+    [ADC_STREAM_DATA_ID]      = DRIVER_UART_PRIORITY_HIGH,
+    [HELLO_WORLD_DATA_ID]     = DRIVER_UART_PRIORITY_BULK,
+    [BUTTON_STATE_DATA_ID]    = DRIVER_UART_PRIORITY_URGENT,
+    [MCU_TEMPERATURE_DATA_ID] = DRIVER_UART_PRIORITY_NORMAL,
+    [BATCH_DATA_ID]           = DRIVER_UART_PRIORITY_HIGH,
+    [PROFILER_DATA_ID]        = DRIVER_UART_PRIORITY_BULK,
+    [LINK_DATA_ID]            = DRIVER_UART_PRIORITY_URGENT,
+    [ADC_BLOCK_DATA_ID]       = DRIVER_UART_PRIORITY_HIGH,
+    [COMMAND_DATA_ID]         = DRIVER_UART_PRIORITY_URGENT,
+    [RELIABLE_DATA_ID]        = DRIVER_UART_PRIORITY_URGENT,
+    [FLASH_LOG_DATA_ID]       = DRIVER_UART_PRIORITY_URGENT,
+};
+
+
+#if ADC_BLOCK_CODEC
+/** @brief Kích thước phần đầu của khung ADC_BLOCK_DATA_ID (data_id, encoding, first_sample, count). */
+#define ADC_BLOCK_HEADER_SIZE (sizeof(adc_block_data_t))
+
+// Độ dài lớn nhất của dữ liệu đã mã hóa: dạng đóng gói, cộng một varint có thể vượt quá trước khi bị bỏ
+#define ADC_BLOCK_SCRATCH_SIZE (ADC_BLOCK_MAX_SAMPLES * 3 / 2 + 2 + 3)
+
+static uint8_t adc_block_scratch[ADC_BLOCK_SCRATCH_SIZE];
+#endif
+
+
+// Luồng được gộp hay không chỉ được quyết định một lần khi giữ chỗ
+static uint8_t record_batched = 0;
+static uint8_t* record_cursor = NULL;           // Vị trí ghi tiếp theo của append_record() khi gộp
+
+
+/**
+ * @brief Giữ chỗ cho một bản ghi, trong khung gộp hoặc trong một khung riêng.
+ * @param[in] data_id Loại dữ liệu của bản ghi.
+ * @param[in] length  Độ dài bản ghi.
+ * @return Con trỏ để ghi bản ghi, NULL nếu không giữ chỗ được.
+ */
+static uint8_t* reserve_record(uint8_t data_id, uint16_t length)
+{
+    if (batch_is_stream_enabled(data_id)) {
+        uint8_t *record = batch_reserve(length);
+        if (record != NULL) {
+            record_batched = 1;
+            record_cursor = record;
+            return record;
+        }
+    }
+
+    record_batched = 0;
+    return reserve_packet(length, get_data_priority(data_id));
+}
+
+
+/**
+ * @brief Chép dữ liệu nối tiếp vào bản ghi đã giữ chỗ bởi reserve_record().
+ * Với khung riêng, dữ liệu được chép và tính CRC trong cùng một lượt.
+ * @param[in] data   Dữ liệu cần ghi.
+ * @param[in] length Số byte.
+ */
+static void append_record(const uint8_t* data, uint16_t length)
+{
+    if (record_batched) {
+        memcpy(record_cursor, data, length);
+        record_cursor += length;
+    } else {
+        append_packet(data, length);
+    }
+}
+
+
+/**
+ * @brief Xác nhận bản ghi đã giữ chỗ bởi reserve_record().
+ */
+static void commit_record(void)
+{
+    if (record_batched) {
+        batch_commit();
+    } else {
+        commit_packet();
+    }
+}
+
+
+#if ADC_BLOCK_CODEC
+/**
+ * @brief Số byte của count mẫu ở dạng ADC_BLOCK_PACKED12.
+ */
+static uint16_t adc_packed_size(uint16_t count)
+{
+    return (uint16_t)(count / 2 * 3 + (count & 1) * 2);
+}
+
+
+/**
+ * @brief Mã hóa mẫu dạng ADC_BLOCK_DELTA_VARINT, dừng ngay khi vượt quá limit byte.
+ * Tín hiệu chậm có hiệu hai mẫu liên tiếp trong khoảng ±63 nên phần lớn mẫu chỉ tốn 1 byte.
+ * @param[out] out     Bộ đệm kết quả, ít nhất limit + 3 byte.
+ * @param[in]  samples Các mẫu.
+ * @param[in]  count   Số mẫu (ít nhất 1).
+ * @param[in]  limit   Độ dài mà từ đó dạng đóng gói không còn kém hơn.
+ * @return Số byte đã ghi, 0 nếu vượt quá limit.
+ */
+static uint16_t adc_encode_delta(uint8_t* out, const uint16_t* samples, uint16_t count, uint16_t limit)
+{
+    uint16_t length = 0;
+
+    out[length++] = (uint8_t)samples[0];
+    out[length++] = (uint8_t)(samples[0] >> 8);
+
+    for (uint16_t i = 1; i < count; i++) {
+        int32_t delta = (int32_t)samples[i] - (int32_t)samples[i - 1];
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+        while (zigzag > 0x7F) {
+            out[length++] = (uint8_t)(zigzag | 0x80);
+            zigzag >>= 7;
+        }
+        out[length++] = (uint8_t)zigzag;
+
+        if (length >= limit) {
+            return 0;
+        }
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief Mã hóa mẫu dạng ADC_BLOCK_PACKED12 (chỉ giữ 12 bit thấp của mỗi mẫu).
+ * @param[out] out     Bộ đệm kết quả, ít nhất adc_packed_size(count) byte.
+ * @param[in]  samples Các mẫu.
+ * @param[in]  count   Số mẫu.
+ * @return Số byte đã ghi.
+ */
+static uint16_t adc_encode_packed(uint8_t* out, const uint16_t* samples, uint16_t count)
+{
+    uint16_t length = 0;
+    uint16_t i = 0;
+
+    for (; i + 1 < count; i += 2) {
+        uint16_t a = samples[i] & 0xFFF;
+        uint16_t b = samples[i + 1] & 0xFFF;
+        out[length++] = (uint8_t)a;
+        out[length++] = (uint8_t)((a >> 8) | (b << 4));
+        out[length++] = (uint8_t)(b >> 4);
+    }
+    if (i < count) {
+        out[length++] = (uint8_t)samples[i];
+        out[length++] = (uint8_t)((samples[i] >> 8) & 0x0F);
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief Gửi tối đa ADC_BLOCK_MAX_SAMPLES mẫu trong một khung ADC_BLOCK_DATA_ID.
+ * Dạng delta được thử trước và bị bỏ ngay khi không còn ngắn hơn dạng đóng gói,
+ *      nên mỗi mẫu chỉ được duyệt tối đa hai lần và khung không bao giờ dài hơn dạng đóng gói.
+ */
+static void send_adc_block_frame(uint32_t first_sample, const uint16_t* samples, uint16_t count)
+{
+    uint16_t packed_size = adc_packed_size(count);
+    uint8_t encoding = ADC_BLOCK_DELTA_VARINT;
+    uint16_t length = adc_encode_delta(adc_block_scratch, samples, count, packed_size);
+
+    if (length == 0) {
+        encoding = ADC_BLOCK_PACKED12;
+        length = adc_encode_packed(adc_block_scratch, samples, count);
+    }
+
+    if (reserve_packet(ADC_BLOCK_HEADER_SIZE + length, get_data_priority(ADC_BLOCK_DATA_ID)) == NULL) {
+        return;
+    }
+
+    const adc_block_data_t header = { ADC_BLOCK_DATA_ID, encoding, first_sample, count };
+    append_packet((const uint8_t*)&header, ADC_BLOCK_HEADER_SIZE);
+    append_packet(adc_block_scratch, length);
+
+    commit_packet();
+}
+#endif
+
+
+/**
+ * @brief Lấy mức ưu tiên truyền của một loại dữ liệu.
+ * @param[in] data_id Loại dữ liệu (data_id_t).
+ * @return Mức ưu tiên (driver_uart_priority_t), DRIVER_UART_PRIORITY_BULK nếu không biết.
+ */
+uint8_t get_data_priority(uint8_t data_id)
+{
+    if (data_id == 0 || data_id >= sizeof(data_priority)) {
+        return DRIVER_UART_PRIORITY_BULK;
+    }
+
+    return data_priority[data_id];
+}
 
 
 /**
@@ -43,13 +240,18 @@ void send_packet_data(packet_t* packet, void* data, uint16_t data_size)
  */
 void send_date_data(uint32_t days, uint32_t month, uint32_t year)
 {
-    date_stream_data_t date_data;
-    date_data.data_id =  DATE_STREAM_DATA_ID;
-    date_data.days = days;
-    date_data.month = month;
-    date_data.year = year;
+    date_stream_data_t *date_data =
+        (date_stream_data_t*)reserve_record(DATE_STREAM_DATA_ID, sizeof(date_stream_data_t));
+    if (date_data == NULL) {
+        return;
+    }
+
+    date_data->data_id =  DATE_STREAM_DATA_ID;
+    date_data->days = days;
+    date_data->month = month;
+    date_data->year = year;
 
-    send_packet_data(&global_date_packet, &date_data, sizeof(date_stream_data_t));
+    commit_record();
 }
 
 
@@ -61,13 +263,18 @@ void send_date_data(uint32_t days, uint32_t month, uint32_t year)
  */
 void send_time_data(uint8_t hour, uint16_t minute, uint16_t second)
 {
-    time_stream_data_t time_data;
-    time_data.data_id =  TIME_STREAM_DATA_ID;
-    time_data.hour = hour;
-    time_data.minute = minute;
-    time_data.second = second;
+    time_stream_data_t *time_data =
+        (time_stream_data_t*)reserve_record(TIME_STREAM_DATA_ID, sizeof(time_stream_data_t));
+    if (time_data == NULL) {
+        return;
+    }
+
+    time_data->data_id =  TIME_STREAM_DATA_ID;
+    time_data->hour = hour;
+    time_data->minute = minute;
+    time_data->second = second;
 
-    send_packet_data(&global_time_packet, &time_data, sizeof(time_stream_data_t));
+    commit_record();
 }
 
 
@@ -78,12 +285,47 @@ void send_time_data(uint8_t hour, uint16_t minute, uint16_t second)
  */
 void send_adc_data(uint32_t sample_count, uint16_t value)
 {
-    adc_stream_data_t adc_data;
-    adc_data.data_id = ADC_STREAM_DATA_ID;
-    adc_data.sample_count = sample_count;
-    adc_data.value = value;
+    adc_stream_data_t *adc_data =
+        (adc_stream_data_t*)reserve_record(ADC_STREAM_DATA_ID, sizeof(adc_stream_data_t));
+    if (adc_data == NULL) {
+        return;
+    }
 
-    send_packet_data(&global_adc_packet, &adc_data, sizeof(adc_stream_data_t));
+    adc_data->data_id = ADC_STREAM_DATA_ID;
+    adc_data->sample_count = sample_count;
+    adc_data->value = value;
+
+    commit_record();
+}
+
+
+/**
+ * @brief Gửi một khối mẫu ADC liên tiếp
+ * Với ADC_BLOCK_CODEC, khối được chia thành các khung ADC_BLOCK_DATA_ID nén; nếu không,
+ *      mỗi mẫu là một bản ghi ADC riêng (được gộp thành khung BATCH_DATA_ID theo mặc định).
+ * @param[in]: first_sample Số thứ tự của mẫu đầu tiên, mẫu thứ i có sample_count = first_sample + i
+ * @param[in]: samples Con trỏ đến các mẫu
+ * @param[in]: count Số mẫu
+ */
+void send_adc_block(uint32_t first_sample, const uint16_t *samples, uint16_t count)
+{
+    if (samples == NULL) {
+        return;
+    }
+
+#if ADC_BLOCK_CODEC
+    while (count > 0) {
+        uint16_t chunk = (count > ADC_BLOCK_MAX_SAMPLES) ? ADC_BLOCK_MAX_SAMPLES : count;
+        send_adc_block_frame(first_sample, samples, chunk);
+        first_sample += chunk;
+        samples += chunk;
+        count -= chunk;
+    }
+#else
+    for (uint16_t i = 0; i < count; i++) {
+        send_adc_data(first_sample + i, samples[i]);
+    }
+#endif
 }
 
 
@@ -98,17 +340,32 @@ void send_string_data(uint16_t string_len, uint8_t *string)
         return;
     }
 
-    if (string_len > 1024) {
-        string_len = 1024;
+    // Phần đầu (data_id, string_len) cũng nằm trong payload nên chuỗi tối đa ngắn hơn MAX_PAYLOAD_SIZE
+    if (string_len > MAX_STRING_LEN) {
+        string_len = MAX_STRING_LEN;
+    }
+
+#if STRING_SEGMENT_MAX
+    // Mỗi đoạn là một khung chuỗi độc lập, khung ưu tiên cao có thể chen vào giữa các đoạn
+    while (string_len > STRING_SEGMENT_MAX) {
+        send_string_data(STRING_SEGMENT_MAX, string);
+        string += STRING_SEGMENT_MAX;
+        string_len -= STRING_SEGMENT_MAX;
+    }
+#endif
+
+    if (reserve_record(HELLO_WORLD_DATA_ID, STRING_HEADER_SIZE + string_len) == NULL) {
+        return;
     }
 
-    hello_world_stream_data_t string_data;
-    string_data.data_id = HELLO_WORLD_DATA_ID;
-    string_data.string_len = string_len;
-    memcpy(string_data.string, string, string_len);
+    // Chuỗi của người gọi được chép thẳng vào khung, không qua struct tạm
+    const uint8_t header[STRING_HEADER_SIZE] = {
+        HELLO_WORLD_DATA_ID, (uint8_t)string_len, (uint8_t)(string_len >> 8)
+    };
+    append_record(header, sizeof(header));
+    append_record(string, string_len);
 
-    send_packet_data(&global_string_packet, &string_data,
-                     sizeof(string_data.data_id) + sizeof(string_data.string_len) + string_len);
+    commit_record();
 }
 
 
@@ -119,24 +376,34 @@ void send_string_data(uint16_t string_len, uint8_t *string)
  */
 void send_button_data(uint8_t button_id, uint16_t button_state)
 {
-    button_state_data_t button_data;
-    button_data.data_id = BUTTON_STATE_DATA_ID;
-    button_data.button_id = button_id;
-    button_data.button_state = button_state;
+    button_state_data_t *button_data =
+        (button_state_data_t*)reserve_record(BUTTON_STATE_DATA_ID, sizeof(button_state_data_t));
+    if (button_data == NULL) {
+        return;
+    }
+
+    button_data->data_id = BUTTON_STATE_DATA_ID;
+    button_data->button_id = button_id;
+    button_data->button_state = button_state;
 
-    send_packet_data(&global_button_packet, &button_data, sizeof(button_state_data_t));
+    commit_record();
 }
 
 
 /**
  * @brief Gửi nhiệt độ của MCU
- * @param[in]: mcu_temperature_in_c Nhiệt độ của MCU theo đơn vị °C
+ * @param[in]: mcu_temperature_centi_c Nhiệt độ của MCU theo đơn vị 0.01 °C
  */
-void send_temperature(uint16_t mcu_temperature_in_c)
+void send_temperature(int16_t mcu_temperature_centi_c)
 {
-    mcu_temperature_data_t temperature_data;
-    temperature_data.data_id  = MCU_TEMPERATURE_DATA_ID;
-    temperature_data.mcu_temperature_in_c = mcu_temperature_in_c;
+    mcu_temperature_data_t *temperature_data =
+        (mcu_temperature_data_t*)reserve_record(MCU_TEMPERATURE_DATA_ID, sizeof(mcu_temperature_data_t));
+    if (temperature_data == NULL) {
+        return;
+    }
+
+    temperature_data->data_id  = MCU_TEMPERATURE_DATA_ID;
+    temperature_data->mcu_temperature_centi_c = mcu_temperature_centi_c;
 
-    send_packet_data(&global_temperature_packet, &temperature_data, sizeof(mcu_temperature_data_t));
+    commit_record();
 }
@@ -0,0 +1,170 @@
+/*
+ * Batch.c
+ *
+ *  Created on: Apr 09, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Batch.h"
+#include "Pool.h"
+#include "Utils.h"
+
+
+// Khung gộp đang được tích lũy: [BATCH_DATA_ID][record_count][bản ghi ...]
+// Bộ đệm chỉ được lấy từ pool khi có bản ghi đầu tiên và trả lại khi khung được phát
+static uint8_t *batch_buffer = NULL;
+static uint16_t batch_length = BATCH_HEADER_SIZE;
+static uint16_t batch_pending_length = 0;
+static uint32_t batch_first_ms = 0;
+
+static uint8_t  batch_max_records = BATCH_DEFAULT_MAX_RECORDS;
+static uint16_t batch_max_bytes   = BATCH_DEFAULT_MAX_BYTES;
+static uint32_t batch_max_age_ms  = BATCH_DEFAULT_MAX_AGE_MS;
+static uint32_t batch_stream_mask = BATCH_DEFAULT_STREAM_MASK;
+
+
+/**
+ * @brief Cấu hình chính sách phát của khung gộp.
+ * @param[in] max_records Số bản ghi tối đa (1..255).
+ * @param[in] max_bytes   Số byte bản ghi tối đa (tối đa BATCH_CAPACITY).
+ * @param[in] max_age_ms  Thời gian giữ tối đa của bản ghi đầu tiên (ms).
+ */
+void batch_configure(uint8_t max_records, uint16_t max_bytes, uint32_t max_age_ms)
+{
+    batch_flush();
+
+    if (max_records != 0) {
+        batch_max_records = max_records;
+    }
+    if (max_bytes != 0) {
+        uint16_t capacity = BATCH_CAPACITY;
+        if (pool_block_max() < BATCH_HEADER_SIZE + capacity) {
+            capacity = (uint16_t)(pool_block_max() - BATCH_HEADER_SIZE);
+        }
+        batch_max_bytes = (max_bytes > capacity) ? capacity : max_bytes;
+    }
+    if (max_age_ms != 0) {
+        batch_max_age_ms = max_age_ms;
+    }
+}
+
+
+/**
+ * @brief Bật hoặc tắt việc gộp cho một data_id.
+ * @param[in] data_id Loại dữ liệu.
+ * @param[in] enable  1 để gộp, 0 để gửi từng khung riêng.
+ */
+void batch_set_stream(uint8_t data_id, uint8_t enable)
+{
+    if (data_id >= 32) {
+        return;
+    }
+
+    if (enable) {
+        batch_stream_mask |= (1u << data_id);
+    } else {
+        batch_stream_mask &= ~(1u << data_id);
+    }
+}
+
+
+/**
+ * @brief Kiểm tra một data_id có đang được gộp hay không.
+ * @param[in] data_id Loại dữ liệu.
+ * @return    1 nếu được gộp, 0 nếu không.
+ */
+uint8_t batch_is_stream_enabled(uint8_t data_id)
+{
+    return (data_id < 32) && (batch_stream_mask & (1u << data_id)) != 0;
+}
+
+
+/**
+ * @brief Giữ chỗ cho một bản ghi trong khung gộp hiện tại.
+ * @param[in] record_length Độ dài bản ghi (bao gồm data_id của bản ghi).
+ * @return    Con trỏ để ghi bản ghi, NULL nếu bản ghi lớn hơn max_bytes hoặc pool hết khối.
+ */
+uint8_t* batch_reserve(uint16_t record_length)
+{
+    if (record_length == 0 || record_length > batch_max_bytes) {
+        return NULL;
+    }
+
+    if (batch_length - BATCH_HEADER_SIZE + record_length > batch_max_bytes) {
+        batch_flush();
+    }
+
+    if (batch_buffer == NULL) {
+        batch_buffer = pool_alloc(BATCH_HEADER_SIZE + batch_max_bytes);
+        if (batch_buffer == NULL) {
+            return NULL;
+        }
+        batch_buffer[1] = 0;
+    }
+
+    if (batch_length == BATCH_HEADER_SIZE) {
+        batch_first_ms = Driver_GetTimeMs();
+    }
+
+    batch_pending_length = record_length;
+    return &batch_buffer[batch_length];
+}
+
+
+/**
+ * @brief Xác nhận bản ghi vừa ghi và phát khung nếu đạt ngưỡng số bản ghi/số byte.
+ */
+void batch_commit(void)
+{
+    if (batch_pending_length == 0) {
+        return;
+    }
+
+    batch_length += batch_pending_length;
+    batch_pending_length = 0;
+    batch_buffer[1]++;
+
+    if (batch_buffer[1] >= batch_max_records ||
+        batch_length - BATCH_HEADER_SIZE >= batch_max_bytes) {
+        batch_flush();
+    }
+}
+
+
+/**
+ * @brief Phát khung gộp nếu bản ghi cũ nhất đã quá max_age_ms.
+ */
+void batch_poll(void)
+{
+    if (batch_buffer != NULL && batch_buffer[1] != 0 &&
+        (Driver_GetTimeMs() - batch_first_ms) >= batch_max_age_ms) {
+        batch_flush();
+    }
+}
+
+
+/**
+ * @brief Phát ngay khung gộp hiện tại (nếu có bản ghi).
+ */
+void batch_flush(void)
+{
+    if (batch_buffer == NULL) {
+        return;
+    }
+
+    if (batch_buffer[1] == 0) {
+        pool_release(batch_buffer);
+        batch_buffer = NULL;
+        return;
+    }
+
+    if (reserve_packet(batch_length, get_data_priority(BATCH_DATA_ID)) != NULL) {
+        batch_buffer[0] = BATCH_DATA_ID;
+        append_packet(batch_buffer, batch_length);
+        commit_packet();
+    }
+
+    pool_release(batch_buffer);
+    batch_buffer = NULL;
+    batch_length = BATCH_HEADER_SIZE;
+}
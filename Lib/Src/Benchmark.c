@@ -0,0 +1,209 @@
+/*
+ * Benchmark.c
+ *
+ *  Created on: Apr 02, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Benchmark.h"
+
+#if BENCHMARK_ENABLED
+
+#include "Application.h"
+#include "Driver.h"
+#include "Pool.h"
+#include "Protocol.h"
+#include "Utils.h"
+
+#if !CRC16_ALL_ENGINES
+#error "BENCHMARK_ENABLED yêu cầu CRC16_ALL_ENGINES = 1"
+#endif
+
+typedef uint16_t (*crc16_kernel_t)(uint16_t crc, const uint8_t *data, size_t length);
+
+static const crc16_kernel_t crc16_kernels[CRC16_ENGINE_COUNT] = {
+    [CRC16_ENGINE_BITWISE] = crc16_bitwise,
+    [CRC16_ENGINE_TABLE]   = crc16_table,
+    [CRC16_ENGINE_SLICE4]  = crc16_slice4,
+    [CRC16_ENGINE_SLICE8]  = crc16_slice8,
+};
+
+static const char *const crc16_kernel_names[CRC16_ENGINE_COUNT] = {
+    "bit", "tbl", "s4", "s8"
+};
+
+// Các kích thước payload thực tế: nút nhấn, ADC, ngày, khung 64/256 byte và chuỗi tối đa
+static const uint16_t crc16_bench_sizes[BENCHMARK_CRC16_SIZE_COUNT] = {
+    3, 7, 13, 16, 64, 128, 256, 512, MAX_PAYLOAD_SIZE
+};
+
+// Payload của ADC, chuỗi trung bình và chuỗi tối đa
+static const uint16_t send_bench_sizes[] = { 7, 64, MAX_PAYLOAD_SIZE };
+
+static uint8_t bench_buffer[MAX_PAYLOAD_SIZE];
+
+
+/**
+ * @brief Đo số chu kỳ CPU của từng engine CRC16 trên các kích thước payload.
+ * @param[out] results Mảng BENCHMARK_CRC16_SIZE_COUNT phần tử nhận kết quả.
+ */
+void benchmark_crc16_run(crc16_bench_result_t *results)
+{
+    if (results == NULL) {
+        return;
+    }
+
+    uint32_t seed = 0x12345678;
+    for (uint16_t i = 0; i < MAX_PAYLOAD_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bench_buffer[i] = (uint8_t)(seed >> 16);
+    }
+
+    Driver_CycleCounterInit();
+
+    // Chi phí của chính phép đo (đọc CYCCNT hai lần) được trừ khỏi kết quả
+    uint32_t start = Driver_GetCycles();
+    uint32_t overhead = Driver_GetCycles() - start;
+
+    for (uint8_t s = 0; s < BENCHMARK_CRC16_SIZE_COUNT; s++) {
+        uint16_t length = crc16_bench_sizes[s];
+        uint16_t reference = crc16_bitwise(CRC16_INIT_VALUE, bench_buffer, length);
+
+        results[s].length = length;
+        results[s].match = 1;
+
+        for (uint8_t e = 0; e < CRC16_ENGINE_COUNT; e++) {
+            uint32_t total = 0;
+            uint16_t crc = 0;
+
+            for (uint8_t n = 0; n < BENCHMARK_ITERATIONS; n++) {
+                start = Driver_GetCycles();
+                crc = crc16_kernels[e](CRC16_INIT_VALUE, bench_buffer, length);
+                total += Driver_GetCycles() - start - overhead;
+            }
+
+            results[s].cycles[e] = total / BENCHMARK_ITERATIONS;
+            if (crc != reference) {
+                results[s].match = 0;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Chạy benchmark CRC16 và gửi kết quả dưới dạng gói tin chuỗi.
+ * Mỗi kích thước payload được gửi trên một dòng riêng.
+ */
+void benchmark_crc16_report(void)
+{
+    crc16_bench_result_t results[BENCHMARK_CRC16_SIZE_COUNT];
+    char line[96];
+
+    benchmark_crc16_run(results);
+
+    for (uint8_t s = 0; s < BENCHMARK_CRC16_SIZE_COUNT; s++) {
+        // format_line() cắt mỗi phần trong chỗ còn lại, nên len không vượt quá sizeof(line) - 1
+        uint16_t len = format_line(line, sizeof(line), "crc16 len=%u", results[s].length);
+        for (uint8_t e = 0; e < CRC16_ENGINE_COUNT; e++) {
+            len += format_line(line + len, sizeof(line) - len, " %s=%lu",
+                               crc16_kernel_names[e], (unsigned long)results[s].cycles[e]);
+        }
+        len += format_line(line + len, sizeof(line) - len, " %s", results[s].match ? "ok" : "MISMATCH");
+
+        send_string_data(len, (uint8_t*)line);
+    }
+}
+
+/**
+ * @brief Đo chi phí CPU để phát một khung: ba lần gọi Driver_UART_Send
+ *      so với một lần truyền gộp qua send_packet(), rồi gửi kết quả dưới dạng chuỗi.
+ */
+void benchmark_send_report(void)
+{
+    uint32_t split_cycles[sizeof(send_bench_sizes) / sizeof(send_bench_sizes[0])];
+    uint32_t gather_cycles[sizeof(send_bench_sizes) / sizeof(send_bench_sizes[0])];
+    char line[96];
+
+    // Gói tin mẫu chỉ cần trong lúc đo nên được mượn từ khối jumbo của pool
+    packet_t *bench_packet = pool_alloc(sizeof(packet_t));
+    if (bench_packet == NULL) {
+        static uint8_t no_block[] = "send error=no pool block";
+        send_string_data(sizeof(no_block) - 1, no_block);
+        return;
+    }
+
+    Driver_CycleCounterInit();
+    Driver_UART_Flush();
+
+    for (uint8_t s = 0; s < sizeof(send_bench_sizes) / sizeof(send_bench_sizes[0]); s++) {
+        uint16_t length = send_bench_sizes[s];
+        uint32_t split_total = 0;
+        uint32_t gather_total = 0;
+
+        pack_packet(bench_packet, bench_buffer, length);
+
+        // Mỗi phép đo bắt đầu với UART rảnh để chỉ tính chi phí của lời gọi
+        for (uint8_t n = 0; n < BENCHMARK_ITERATIONS; n++) {
+            uint32_t start = Driver_GetCycles();
+            Driver_UART_Send((uint8_t*)bench_packet, PACKET_OVERHEAD);
+            Driver_UART_Send(bench_packet->payload, length);
+            Driver_UART_Send((uint8_t*)&bench_packet->checksum, sizeof(bench_packet->checksum));
+            split_total += Driver_GetCycles() - start;
+            Driver_UART_Flush();
+
+            start = Driver_GetCycles();
+            send_packet(bench_packet);
+            gather_total += Driver_GetCycles() - start;
+            Driver_UART_Flush();
+        }
+
+        split_cycles[s] = split_total / BENCHMARK_ITERATIONS;
+        gather_cycles[s] = gather_total / BENCHMARK_ITERATIONS;
+    }
+
+    pool_release(bench_packet);
+
+    for (uint8_t s = 0; s < sizeof(send_bench_sizes) / sizeof(send_bench_sizes[0]); s++) {
+        uint16_t len = format_line(line, sizeof(line), "send len=%u split=%lu gather=%lu",
+                                   send_bench_sizes[s], (unsigned long)split_cycles[s],
+                                   (unsigned long)gather_cycles[s]);
+        send_string_data(len, (uint8_t*)line);
+    }
+}
+
+/**
+ * @brief Đo độ trễ xếp hàng của sự kiện nút nhấn khi UART đang bị chuỗi dài chiếm dụng.
+ * Phát BENCHMARK_PRIORITY_FLOOD chuỗi tối đa, mỗi chuỗi kèm một sự kiện nút nhấn, rồi gửi
+ *      độ trễ lớn nhất/trung bình. Biên dịch lại với DRIVER_UART_TX_PRIORITY = 0 để có số liệu FIFO.
+ */
+void benchmark_priority_report(void)
+{
+    char line[96];
+
+    for (uint16_t i = 0; i < MAX_STRING_LEN; i++) {
+        bench_buffer[i] = (uint8_t)('a' + i % 26);
+    }
+
+    Driver_CycleCounterInit();
+    Driver_UART_Flush();
+    Driver_UART_ResetTxStats();
+
+    // Sự kiện nút nhấn được commit ngay sau mỗi chuỗi, khi ring bulk đang đầy
+    for (uint8_t n = 0; n < BENCHMARK_PRIORITY_FLOOD; n++) {
+        send_string_data(MAX_STRING_LEN, bench_buffer);
+        send_button_data(0, n);
+    }
+    Driver_UART_Flush();
+
+    const driver_uart_tx_stats_t *button = Driver_UART_GetTxStats(get_data_priority(BUTTON_STATE_DATA_ID));
+    uint32_t latency_avg = button->frames ? button->latency_sum_us / button->frames : 0;
+
+    uint16_t len = format_line(line, sizeof(line), "prio mode=%s segment=%u button_max_us=%lu button_avg_us=%lu",
+                               DRIVER_UART_TX_PRIORITY ? "class" : "fifo", STRING_SEGMENT_MAX,
+                               (unsigned long)button->latency_max_us, (unsigned long)latency_avg);
+    Driver_UART_ResetTxStats();
+    send_string_data(len, (uint8_t*)line);
+}
+
+#endif /* BENCHMARK_ENABLED */
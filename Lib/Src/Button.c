@@ -0,0 +1,151 @@
+/*
+ * Button.c
+ *
+ *  Created on: May 09, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Button.h"
+#include "Application.h"
+#include "Driver.h"
+#include "Utils.h"
+#include <string.h>
+
+
+static uint8_t  button_level = 1;               // Trạng thái đã lọc (GPIO_PinState), 1 = nhả do pull-up
+static uint8_t  button_raw_level = 1;           // Mức của cạnh mới nhất
+static uint32_t button_raw_cycles = 0;          // Thời điểm của cạnh mới nhất
+static uint8_t  button_enabled = 1;             // 0: sự kiện chỉ được lọc, không gửi
+static uint8_t  button_locked = 0;              // 1: đang trong thời gian bỏ qua dội
+static uint32_t button_lock_start = 0;          // Driver_GetCycles() lúc bắt đầu bỏ qua dội
+static button_stats_t button_stats;
+
+
+/**
+ * @brief Gửi trạng thái mới và bắt đầu thời gian bỏ qua dội.
+ * @param[in] level  Trạng thái mới.
+ * @param[in] cycles Thời điểm của cạnh gây ra trạng thái mới.
+ */
+static void button_emit(uint8_t level, uint32_t cycles)
+{
+    button_level = level;
+    button_locked = 1;
+    button_lock_start = cycles;
+
+    if (!button_enabled) {
+        return;
+    }
+    send_button_data(BUTTON_ID, level);
+
+    uint32_t latency_us = Driver_CyclesToUs(Driver_GetCycles() - cycles);
+    button_stats.events++;
+    button_stats.latency_sum_us += latency_us;
+    if (latency_us > button_stats.latency_max_us) {
+        button_stats.latency_max_us = latency_us;
+    }
+}
+
+
+/**
+ * @brief Đọc trạng thái ban đầu của nút và bỏ các cạnh cũ trong hàng đợi.
+ */
+void button_init(void)
+{
+    driver_button_edge_t edge;
+
+    while (Driver_Button_Read(&edge)) {
+    }
+
+    button_level = Driver_Button_GetLevel();
+    button_raw_level = button_level;
+    button_locked = 0;
+    memset(&button_stats, 0, sizeof(button_stats));
+}
+
+
+/**
+ * @brief Lọc dội các cạnh đã ghi và gửi mỗi lần trạng thái đổi.
+ */
+void button_poll(void)
+{
+    driver_button_edge_t edge;
+
+    while (Driver_Button_Read(&edge)) {
+        button_raw_level = edge.level;
+        button_raw_cycles = edge.cycles;
+
+        if (button_locked && Driver_CyclesToUs(edge.cycles - button_lock_start) < BUTTON_DEBOUNCE_MS * 1000u) {
+            button_stats.bounces++;
+            continue;
+        }
+
+        button_locked = 0;
+        if (edge.level != button_level) {
+            button_emit(edge.level, edge.cycles);
+        }
+    }
+
+    // Hết thời gian bỏ qua dội: mức của cạnh cuối là trạng thái ổn định; độ trễ tính từ cạnh
+    // đó nên gồm cả phần còn lại của thời gian bỏ qua dội
+    if (button_locked &&
+        Driver_CyclesToUs(Driver_GetCycles() - button_lock_start) >= BUTTON_DEBOUNCE_MS * 1000u) {
+        button_locked = 0;
+        if (button_raw_level != button_level) {
+            button_emit(button_raw_level, button_raw_cycles);
+        }
+    }
+}
+
+
+/**
+ * @brief Bật hoặc tắt việc gửi sự kiện.
+ * @param[in] enabled 1 để gửi, 0 để không gửi.
+ */
+void button_set_enabled(uint8_t enabled)
+{
+    button_enabled = enabled ? 1 : 0;
+}
+
+
+/**
+ * @brief Việc gửi sự kiện đang bật hay không.
+ */
+uint8_t button_is_enabled(void)
+{
+    return button_enabled;
+}
+
+
+/**
+ * @brief Gửi ngay trạng thái đã lọc hiện tại của nút.
+ */
+void button_send_state(void)
+{
+    send_button_data(BUTTON_ID, button_level);
+}
+
+
+/**
+ * @brief Lấy thống kê của nút nhấn.
+ */
+const button_stats_t* button_get_stats(void)
+{
+    return &button_stats;
+}
+
+
+/**
+ * @brief Ghi thống kê của nút nhấn thành một dòng văn bản.
+ * @param[in] buffer Bộ đệm nhận chuỗi.
+ * @param[in] size   Kích thước bộ đệm.
+ * @return Độ dài chuỗi (không kể '\0').
+ */
+uint16_t button_format_stats(char *buffer, size_t size)
+{
+    uint32_t latency_avg = button_stats.events ? button_stats.latency_sum_us / button_stats.events : 0;
+
+    return format_line(buffer, size, "button events=%lu bounces=%lu dropped=%lu lat_max_us=%lu lat_avg_us=%lu",
+                       (unsigned long)button_stats.events, (unsigned long)button_stats.bounces,
+                       (unsigned long)Driver_Button_GetDropped(),
+                       (unsigned long)button_stats.latency_max_us, (unsigned long)latency_avg);
+}
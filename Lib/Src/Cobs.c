@@ -0,0 +1,128 @@
+/*
+ * Cobs.c
+ *
+ *  Created on: May 14, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Cobs.h"
+#include <string.h>
+
+
+/**
+ * @brief Ghi byte mã của nhóm đang mở và mở nhóm kế tiếp.
+ */
+static void cobs_close_group(cobs_encoder_t* encoder)
+{
+    *encoder->code = (uint8_t)(encoder->out - encoder->code);
+    encoder->code = encoder->out++;
+}
+
+
+/**
+ * @brief Bắt đầu mã hóa một khung vào vùng đích.
+ * @param[out] encoder Trạng thái bộ mã hóa.
+ * @param[in]  dst     Vùng đích, đủ chỗ cho COBS_ENCODED_MAX() của cả khung.
+ */
+void cobs_encode_begin(cobs_encoder_t* encoder, uint8_t* dst)
+{
+    encoder->start = dst;
+    encoder->code  = dst;
+    encoder->out   = dst + 1;
+}
+
+
+/**
+ * @brief Mã hóa tiếp một đoạn dữ liệu của khung.
+ *
+ * Mỗi đoạn liên tiếp không chứa byte 0 được chép một lần (cùng CRC nếu có);
+ * 		vị trí ghi luôn đứng trước vị trí đọc, nên nguồn và đích được phép chung bộ đệm.
+ *
+ * @param[in] encoder Trạng thái bộ mã hóa.
+ * @param[in] src     Dữ liệu nguồn.
+ * @param[in] length  Số byte.
+ * @param[in] crc     Phép tính CRC16 cần cập nhật, có thể NULL.
+ */
+void cobs_encode_update(cobs_encoder_t* encoder, const uint8_t* src, size_t length, crc16_ctx_t* crc)
+{
+    while (length > 0) {
+        size_t room = COBS_GROUP_MAX - (size_t)(encoder->out - encoder->code - 1);
+        size_t span = (length < room) ? length : room;
+        const uint8_t* zero = memchr(src, COBS_DELIMITER, span);
+        size_t run = (zero != NULL) ? (size_t)(zero - src) : span;
+
+        if (crc != NULL) {
+            crc16_update_copy(crc, encoder->out, src, run);
+        } else {
+            memmove(encoder->out, src, run);
+        }
+        encoder->out += run;
+        src          += run;
+        length       -= run;
+
+        if (zero != NULL) {
+            // Byte 0 chỉ còn là ranh giới nhóm; nó được đọc trước khi byte mã mới có thể ghi đè
+            if (crc != NULL) {
+                crc16_update(crc, src, 1);
+            }
+            src++;
+            length--;
+            cobs_close_group(encoder);
+        } else if (run == room) {
+            // Nhóm đầy (mã 0xFF) không kéo theo byte 0
+            cobs_close_group(encoder);
+        }
+    }
+}
+
+
+/**
+ * @brief Đóng nhóm cuối và ghi byte phân cách.
+ * @param[in] encoder Trạng thái bộ mã hóa.
+ * @return Độ dài khung đã mã hóa, kể cả byte phân cách.
+ */
+size_t cobs_encode_end(cobs_encoder_t* encoder)
+{
+    *encoder->code = (uint8_t)(encoder->out - encoder->code);
+    *encoder->out++ = COBS_DELIMITER;
+
+    return (size_t)(encoder->out - encoder->start);
+}
+
+
+/**
+ * @brief Giải mã một khung COBS (không kể byte phân cách).
+ * @param[out] dst      Vùng nhận dữ liệu gốc.
+ * @param[in]  capacity Kích thước vùng nhận.
+ * @param[in]  src      Khung đã mã hóa.
+ * @param[in]  length   Độ dài khung đã mã hóa.
+ * @return Độ dài dữ liệu gốc, 0 nếu khung không hợp lệ hoặc không vừa vùng nhận.
+ */
+size_t cobs_decode(uint8_t* dst, size_t capacity, const uint8_t* src, size_t length)
+{
+    size_t out = 0;
+
+    while (length > 0) {
+        uint8_t code = *src++;
+        size_t run = (size_t)code - 1;
+        length--;
+
+        if (code == COBS_DELIMITER || run > length || run > capacity - out) {
+            return 0;
+        }
+        memcpy(dst + out, src, run);
+        out    += run;
+        src    += run;
+        length -= run;
+
+        // Byte 0 ẩn sau mỗi nhóm chưa đầy, trừ nhóm cuối cùng
+        if (code != 0xFF && length > 0) {
+            if (out == capacity) {
+                return 0;
+            }
+            dst[out++] = 0;
+        }
+    }
+
+    return out;
+}
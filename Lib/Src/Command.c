@@ -0,0 +1,226 @@
+/*
+ * Command.c
+ *
+ *  Created on: May 10, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Command.h"
+#include "Acquisition.h"
+#include "Button.h"
+#include "Driver.h"
+#include "Scheduler.h"
+#include <string.h>
+
+
+static command_report_t command_report_stats = NULL;
+
+// Tần số trước lần DISABLE gần nhất, theo stream_id; ENABLE dùng lại giá trị này
+static uint32_t command_saved_rate[SCHEDULER_MAX_STREAMS];
+
+
+/**
+ * @brief Gửi trả lời cho một lệnh.
+ */
+static void command_reply(const command_data_t* request, uint8_t status, uint32_t value)
+{
+    command_data_t reply = { COMMAND_DATA_ID, (uint8_t)(request->op | COMMAND_OP_REPLY),
+                             request->stream_id, status, value };
+
+    if (reserve_packet(sizeof(reply), get_data_priority(COMMAND_DATA_ID)) == NULL) {
+        return;
+    }
+    append_packet((const uint8_t*)&reply, sizeof(reply));
+    commit_packet();
+}
+
+
+/**
+ * @brief Lệnh cho luồng ADC (TIM2/DMA, Acquisition.c).
+ * @param[out] value Tần số sau lệnh.
+ */
+static uint8_t command_adc(const command_data_t* cmd, uint32_t* value)
+{
+    uint32_t rate = acquisition_get_rate();
+    uint8_t status = COMMAND_STATUS_OK;
+
+    switch (cmd->op) {
+    case COMMAND_OP_SET_RATE:
+        if (cmd->value > DRIVER_ADC_RATE_MAX) {
+            status = COMMAND_STATUS_BAD_VALUE;
+        } else if (cmd->value == 0) {
+            acquisition_stop();
+        } else {
+            acquisition_start(cmd->value);
+        }
+        break;
+
+    case COMMAND_OP_ENABLE:
+        if (rate == 0) {
+            if (command_saved_rate[ADC_STREAM_DATA_ID] == 0) {
+                status = COMMAND_STATUS_BAD_VALUE;
+            } else {
+                acquisition_start(command_saved_rate[ADC_STREAM_DATA_ID]);
+            }
+        }
+        break;
+
+    case COMMAND_OP_DISABLE:
+        if (rate != 0) {
+            command_saved_rate[ADC_STREAM_DATA_ID] = rate;
+            acquisition_stop();
+        }
+        break;
+
+    case COMMAND_OP_GET:
+        break;
+
+    default:
+        status = COMMAND_STATUS_UNSUPPORTED;
+        break;
+    }
+
+    *value = acquisition_get_rate();
+    return status;
+}
+
+
+/**
+ * @brief Lệnh cho nút nhấn (gửi theo sự kiện, không có tần số).
+ * @param[out] value 1 nếu việc gửi sự kiện đang bật.
+ */
+static uint8_t command_button(const command_data_t* cmd, uint32_t* value)
+{
+    uint8_t status = COMMAND_STATUS_OK;
+
+    switch (cmd->op) {
+    case COMMAND_OP_ENABLE:
+        button_set_enabled(1);
+        break;
+
+    case COMMAND_OP_DISABLE:
+        button_set_enabled(0);
+        break;
+
+    case COMMAND_OP_SNAPSHOT:
+        button_send_state();
+        break;
+
+    case COMMAND_OP_GET:
+        break;
+
+    default:
+        status = COMMAND_STATUS_UNSUPPORTED;
+        break;
+    }
+
+    *value = button_is_enabled();
+    return status;
+}
+
+
+/**
+ * @brief Lệnh cho một luồng tuần hoàn của scheduler.
+ * @param[out] value Tần số sau lệnh.
+ */
+static uint8_t command_scheduled(const command_data_t* cmd, uint32_t now, uint32_t* value)
+{
+    uint8_t id = cmd->stream_id;
+    uint16_t rate = scheduler_get_rate(id);
+    uint8_t status = COMMAND_STATUS_OK;
+
+    switch (cmd->op) {
+    case COMMAND_OP_SET_RATE:
+        // Chu kỳ nhỏ hơn một tick sẽ bằng 0
+        if (cmd->value > SCHEDULER_TICK_HZ) {
+            status = COMMAND_STATUS_BAD_VALUE;
+        } else {
+            scheduler_set_rate(id, (uint16_t)cmd->value, now);
+        }
+        break;
+
+    case COMMAND_OP_ENABLE:
+        if (rate == 0) {
+            if (command_saved_rate[id] == 0) {
+                status = COMMAND_STATUS_BAD_VALUE;
+            } else {
+                scheduler_set_rate(id, (uint16_t)command_saved_rate[id], now);
+            }
+        }
+        break;
+
+    case COMMAND_OP_DISABLE:
+        if (rate != 0) {
+            command_saved_rate[id] = rate;
+            scheduler_set_rate(id, 0, now);
+        }
+        break;
+
+    case COMMAND_OP_SNAPSHOT:
+        scheduler_trigger(id);
+        break;
+
+    case COMMAND_OP_GET:
+        break;
+
+    default:
+        status = COMMAND_STATUS_UNSUPPORTED;
+        break;
+    }
+
+    *value = scheduler_get_rate(id);
+    return status;
+}
+
+
+/**
+ * @brief Khởi tạo bộ xử lý lệnh.
+ * @param[in] report_stats Hàm gửi báo cáo thống kê, có thể NULL.
+ */
+void command_init(command_report_t report_stats)
+{
+    command_report_stats = report_stats;
+    memset(command_saved_rate, 0, sizeof(command_saved_rate));
+}
+
+
+/**
+ * @brief Thực hiện một lệnh và gửi trả lời.
+ * @param[in] payload Payload của khung.
+ * @param[in] size    Độ dài payload.
+ * @param[in] now     Thời gian hiện tại (ms).
+ */
+void command_handle(const uint8_t* payload, uint16_t size, uint32_t now)
+{
+    command_data_t cmd;
+    uint32_t value = 0;
+    uint8_t status;
+
+    if (size < sizeof(cmd) || payload[0] != COMMAND_DATA_ID) {
+        return;
+    }
+    memcpy(&cmd, payload, sizeof(cmd));
+
+    // Không trả lời một khung trả lời bị vọng lại
+    if (cmd.op & COMMAND_OP_REPLY) {
+        return;
+    }
+
+    if (cmd.stream_id == ADC_STREAM_DATA_ID || cmd.stream_id == ADC_BLOCK_DATA_ID) {
+        status = command_adc(&cmd, &value);
+    } else if (cmd.stream_id == BUTTON_STATE_DATA_ID) {
+        status = command_button(&cmd, &value);
+    } else if (cmd.stream_id == COMMAND_STREAM_STATS) {
+        status = COMMAND_STATUS_UNSUPPORTED;
+        if (cmd.op == COMMAND_OP_SNAPSHOT && command_report_stats != NULL) {
+            command_report_stats();
+            status = COMMAND_STATUS_OK;
+        }
+    } else if (scheduler_has_stream(cmd.stream_id)) {
+        status = command_scheduled(&cmd, now, &value);
+    } else {
+        status = COMMAND_STATUS_BAD_STREAM;
+    }
+
+    command_reply(&cmd, status, value);
+}
@@ -7,21 +7,1334 @@
 
 
 #include "Driver.h"
+#include "Profiler.h"
+#include "Utils.h"
 #include "stm32f4xx_hal.h"
+#include <string.h>
 
 
 extern UART_HandleTypeDef huart2;
 
+// Thống kê độ trễ xếp hàng theo mức ưu tiên được yêu cầu
+static driver_uart_tx_stats_t tx_stats[DRIVER_UART_TX_CLASSES];
+
+// Ring nhận: DMA1 Stream5 ghi vòng, sự kiện nhận (idle, nửa, cuối bộ đệm) cập nhật rx_head,
+// main context đọc rx_tail; rx_head == rx_tail nghĩa là rỗng
+#define RX_MASK (DRIVER_UART_RX_SIZE - 1)
+static uint8_t rx_ring[DRIVER_UART_RX_SIZE];
+static volatile uint16_t rx_head = 0;
+static volatile uint16_t rx_tail = 0;
+static volatile uint8_t rx_resync = 0;          // 1: DMA đã ghi đè hoặc khởi động lại, bỏ phần chưa đọc
+static volatile uint32_t rx_errors = 0;
+
+// Bộ đệm ping-pong của ADC: DMA ghi vòng, mỗi nửa là một khối DRIVER_ADC_BLOCK_SIZE mẫu
+#define ADC_BLOCK_NONE 0xFF
+#define ADC_DMA_FLAGS  (DMA_LIFCR_CFEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CTEIF0 | \
+                        DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTCIF0)
+
+static uint16_t adc_buffer[2 * DRIVER_ADC_BLOCK_SIZE];
+static volatile uint32_t adc_block_first[2];    // Số thứ tự mẫu đầu tiên của từng nửa
+static volatile uint8_t adc_block_ready = 0;    // Bit n: nửa n đầy và chưa được lấy ra
+static volatile uint8_t adc_block_held = ADC_BLOCK_NONE;  // Nửa đang được main context dùng
+static driver_adc_stats_t adc_stats;
+
+// Các bit của CR2 thuộc nhóm regular (luồng ADC); nhóm injected dùng cho cảm biến nhiệt độ
+#define ADC_REGULAR_BITS (ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN | ADC_CR2_EXTSEL)
+
+// Giá trị hiệu chuẩn của cảm biến nhiệt độ (RM0090/datasheet: TS_CAL1 ở 30 °C, TS_CAL2 ở 110 °C)
+#define TEMP_CAL30_ADDR  ((const uint16_t*)0x1FFF7A2Cu)
+#define TEMP_CAL110_ADDR ((const uint16_t*)0x1FFF7A2Eu)
+
+// Loạt chuyển đổi injected của cảm biến nhiệt độ, do ngắt JEOC cộng dồn
+static volatile uint32_t temp_sum = 0;
+static volatile uint16_t temp_remaining = 0;    // Số chuyển đổi còn lại của loạt đang chạy
+static uint16_t temp_samples = 0;               // Số chuyển đổi của loạt đang chạy
+static volatile uint16_t temp_done = 0;         // Số chuyển đổi của loạt đã xong, 0 = chưa có
+static volatile uint8_t temp_software = 0;      // 1: loạt tự nối bằng JSWSTART, 0: theo TIM2 CC1
+
+// Hàng đợi cạnh của nút nhấn: chỉ ngắt EXTI0 ghi button_head, chỉ main context ghi button_tail
+static driver_button_edge_t button_queue[DRIVER_BUTTON_QUEUE_SIZE];
+static volatile uint8_t button_head = 0;
+static volatile uint8_t button_tail = 0;
+static volatile uint32_t button_dropped = 0;
+
+// Nhật ký flash: sector 8-11 (4 x 128 KB), trạng thái do ngắt của bộ điều khiển flash cập nhật
+#define FLASH_LOG_BASE         0x08080000u
+#define FLASH_LOG_FIRST_SECTOR FLASH_SECTOR_8
+static volatile uint8_t flash_state = DRIVER_FLASH_IDLE;
+static uint32_t flash_erase_cycles = 0;         // CYCCNT và HAL_GetTick() lúc bắt đầu xóa
+static uint32_t flash_erase_tick = 0;
+
+#if DRIVER_UART_TX_DMA
+
+/*
+ * Mỗi mức ưu tiên có một ring buffer riêng dạng bip-buffer: mỗi lần ghi luôn là
+ * một vùng liên tục, nên DMA có thể đọc thẳng từ ring mà không cần chép lại.
+ * - head: vị trí ghi tiếp theo (chỉ main context thay đổi).
+ * - tail: vị trí DMA đang/sẽ đọc (chỉ ngắt thay đổi).
+ * - wrap: điểm kết thúc dữ liệu ở nửa trên khi con trỏ ghi đã quay về 0.
+ * head == tail nghĩa là ring rỗng, nên head không bao giờ được đuổi kịp tail.
+ *
+ * Mỗi khung trong ring có phần đầu TX_ENTRY_HEADER byte:
+ *      [độ dài khung (2)][mức ưu tiên yêu cầu (1)][chu kỳ lúc commit (4)].
+ * DMA chỉ truyền một khung mỗi lần và khung kế tiếp luôn lấy từ ring ưu tiên
+ * cao nhất còn dữ liệu, nên khung khẩn cấp được chen lên ở ranh giới khung gần nhất.
+ */
+typedef struct {
+    uint8_t*          buffer;
+    uint16_t          size;
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    volatile uint16_t wrap;
+} tx_ring_t;
+
+#define TX_ENTRY_HEADER 7
+
+// Khung lớn nhất luôn tìm được chỗ trong ring rỗng, bất kể vị trí của head
+#define TX_RING_ENTRY_MAX(ring) ((ring)->size / 2 - 1)
+
+static uint8_t tx_ring_urgent[DRIVER_UART_TX_URGENT_SIZE];
+static uint8_t tx_ring_high[DRIVER_UART_TX_HIGH_SIZE];
+static uint8_t tx_ring_normal[DRIVER_UART_TX_NORMAL_SIZE];
+static uint8_t tx_ring_bulk[DRIVER_UART_TX_BULK_SIZE];
+
+static tx_ring_t tx_rings[DRIVER_UART_TX_CLASSES] = {
+    [DRIVER_UART_PRIORITY_URGENT] = { tx_ring_urgent, sizeof(tx_ring_urgent), 0, 0, sizeof(tx_ring_urgent) },
+    [DRIVER_UART_PRIORITY_HIGH]   = { tx_ring_high,   sizeof(tx_ring_high),   0, 0, sizeof(tx_ring_high) },
+    [DRIVER_UART_PRIORITY_NORMAL] = { tx_ring_normal, sizeof(tx_ring_normal), 0, 0, sizeof(tx_ring_normal) },
+    [DRIVER_UART_PRIORITY_BULK]   = { tx_ring_bulk,   sizeof(tx_ring_bulk),   0, 0, sizeof(tx_ring_bulk) },
+};
+
+static tx_ring_t* volatile tx_active = NULL;    // Ring của khung đang truyền, NULL = rảnh
+static volatile uint16_t tx_active_length = 0;  // Số byte (kể cả phần đầu) giải phóng khi truyền xong
+static tx_ring_t* tx_reserved = NULL;           // Ring của vùng đang được giữ chỗ
+static uint8_t tx_reserved_priority = 0;
+
+
+/**
+ * @brief Ghi nhận độ trễ từ lúc commit đến lúc khung bắt đầu được truyền.
+ * @param[in] entry Phần đầu của khung trong ring.
+ */
+static void uart_tx_account(const uint8_t* entry)
+{
+    uint32_t stamp = (uint32_t)entry[3] | ((uint32_t)entry[4] << 8) |
+                     ((uint32_t)entry[5] << 16) | ((uint32_t)entry[6] << 24);
+    uint32_t latency_us = (Driver_GetCycles() - stamp) / (SystemCoreClock / 1000000u);
+    driver_uart_tx_stats_t *stats = &tx_stats[entry[2]];
+
+    stats->frames++;
+    stats->latency_sum_us += latency_us;
+    if (latency_us > stats->latency_max_us) {
+        stats->latency_max_us = latency_us;
+    }
+}
+
+
+/**
+ * @brief Bắt đầu truyền DMA khung kế tiếp của ring ưu tiên cao nhất nếu UART đang rảnh.
+ * Phải được gọi khi ngắt đã bị khóa hoặc từ trong ngắt.
+ */
+static void uart_tx_kick(void)
+{
+    if (tx_active != NULL) {
+        return;
+    }
+
+    for (uint8_t c = 0; c < DRIVER_UART_TX_CLASSES; c++) {
+        tx_ring_t *ring = &tx_rings[c];
+
+        if (ring->tail == ring->wrap) {
+            ring->tail = 0;
+            ring->wrap = ring->size;
+        }
+
+        if (ring->head == ring->tail) {
+            continue;
+        }
+
+        uint8_t *entry = &ring->buffer[ring->tail];
+        uint16_t length = (uint16_t)(entry[0] | (entry[1] << 8));
+
+        tx_active = ring;
+        tx_active_length = TX_ENTRY_HEADER + length;
+
+        PROFILE_BEGIN(PROFILER_PROBE_UART_TX);
+        HAL_StatusTypeDef status = HAL_UART_Transmit_DMA(&huart2, entry + TX_ENTRY_HEADER, length);
+        PROFILE_END(PROFILER_PROBE_UART_TX);
+
+        if (status != HAL_OK) {
+            tx_active = NULL;
+            return;
+        }
+
+        uart_tx_account(entry);
+        return;
+    }
+}
+
+
+/**
+ * @brief Khởi động lại DMA từ main context nếu UART đang rảnh.
+ */
+static void uart_tx_poll(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uart_tx_kick();
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Tìm một vùng liên tục còn trống trong ring buffer.
+ * @param[in] ring Ring cần tìm.
+ * @param[in] size Số byte cần ghi.
+ * @return Vị trí bắt đầu vùng trống, hoặc -1 nếu chưa đủ chỗ.
+ */
+static int32_t uart_tx_find_space(const tx_ring_t* ring, uint16_t size)
+{
+    uint16_t head = ring->head;
+    uint16_t tail = ring->tail;
+
+    if (head >= tail) {
+        if ((uint32_t)head + size < ring->size) {
+            return head;
+        }
+        if (size < tail) {
+            return 0;
+        }
+    } else if ((uint32_t)head + size < tail) {
+        return head;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Giữ chỗ một vùng liên tục trong ring của mức ưu tiên cho trước.
+ * Hàm chờ (busy-wait) nếu ring chưa đủ chỗ trống. Khung quá lớn so với ring
+ *      của mức ưu tiên được chuyển sang ring bulk.
+ * @param[in] size     Số byte của khung, không vượt quá uart_tx_frame_max().
+ * @param[in] priority Mức ưu tiên của khung.
+ * @return Con trỏ đến vùng nhớ được giữ chỗ.
+ */
+static uint8_t* uart_tx_reserve(uint16_t size, uint8_t priority)
+{
+    if (priority >= DRIVER_UART_TX_CLASSES) {
+        priority = DRIVER_UART_PRIORITY_BULK;
+    }
+
+#if DRIVER_UART_TX_PRIORITY
+    tx_ring_t *ring = &tx_rings[priority];
+#else
+    tx_ring_t *ring = &tx_rings[DRIVER_UART_PRIORITY_BULK];
+#endif
+
+    uint16_t entry_size = TX_ENTRY_HEADER + size;
+    if (entry_size > TX_RING_ENTRY_MAX(ring)) {
+        ring = &tx_rings[DRIVER_UART_PRIORITY_BULK];
+    }
+
+    int32_t offset;
+    while ((offset = uart_tx_find_space(ring, entry_size)) < 0) {
+        uart_tx_poll();
+    }
+
+    tx_reserved = ring;
+    tx_reserved_priority = priority;
+    return &ring->buffer[offset + TX_ENTRY_HEADER];
+}
+
+
+/**
+ * @brief Xác nhận vùng đã giữ chỗ và khởi động DMA nếu UART đang rảnh.
+ * @param[in] region Con trỏ trả về bởi uart_tx_reserve().
+ * @param[in] size   Số byte đã ghi vào vùng giữ chỗ.
+ */
+static void uart_tx_commit(uint8_t* region, uint16_t size)
+{
+    tx_ring_t *ring = tx_reserved;
+    if (ring == NULL) {
+        return;
+    }
+
+    uint8_t *entry = region - TX_ENTRY_HEADER;
+    uint16_t offset = (uint16_t)(entry - ring->buffer);
+    uint32_t stamp = Driver_GetCycles();
+
+    entry[0] = (uint8_t)size;
+    entry[1] = (uint8_t)(size >> 8);
+    entry[2] = tx_reserved_priority;
+    entry[3] = (uint8_t)stamp;
+    entry[4] = (uint8_t)(stamp >> 8);
+    entry[5] = (uint8_t)(stamp >> 16);
+    entry[6] = (uint8_t)(stamp >> 24);
+    tx_reserved = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (offset == 0 && ring->head != 0) {
+        ring->wrap = ring->head;
+    }
+    ring->head = offset + TX_ENTRY_HEADER + size;
+    uart_tx_kick();
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Kích thước khung lớn nhất có thể gửi trong một lần truyền.
+ */
+static uint16_t uart_tx_frame_max(void)
+{
+    return TX_RING_ENTRY_MAX(&tx_rings[DRIVER_UART_PRIORITY_BULK]) - TX_ENTRY_HEADER;
+}
+
+
+/**
+ * @brief Callback của HAL khi một lần truyền DMA hoàn tất, nối tiếp khung kế tiếp.
+ * @param[in] huart Con trỏ đến UART vừa truyền xong.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != USART2 || tx_active == NULL) {
+        return;
+    }
+
+    tx_active->tail = tx_active->tail + tx_active_length;
+    tx_active = NULL;
+    uart_tx_kick();
+}
+
+
+/**
+ * @brief Gửi lại khung đang truyền sau khi UART gặp lỗi, gọi từ HAL_UART_ErrorCallback().
+ */
+static void uart_tx_recover(void)
+{
+    if (huart2.gState == HAL_UART_STATE_READY) {
+        tx_active = NULL;
+        uart_tx_kick();
+    }
+}
+
+#else
+
+// Ở chế độ truyền chặn, các đoạn của một khung được gom vào bộ đệm tạm trước khi truyền;
+// đủ cho khung lớn nhất (1039 byte) sau khi mã hóa COBS (Protocol.h, PROTOCOL_COBS)
+#define DRIVER_UART_TX_STAGE_SIZE 1048
+
+static uint8_t tx_stage[DRIVER_UART_TX_STAGE_SIZE];
+static uint8_t tx_stage_priority = 0;
+
+
+static uint8_t* uart_tx_reserve(uint16_t size, uint8_t priority)
+{
+    (void)size;
+    tx_stage_priority = (priority < DRIVER_UART_TX_CLASSES) ? priority : DRIVER_UART_PRIORITY_BULK;
+    return tx_stage;
+}
+
+
+static void uart_tx_commit(uint8_t* region, uint16_t size)
+{
+    tx_stats[tx_stage_priority].frames++;
+
+    PROFILE_BEGIN(PROFILER_PROBE_UART_TX);
+    HAL_UART_Transmit(&huart2, region, size, HAL_MAX_DELAY);
+    PROFILE_END(PROFILER_PROBE_UART_TX);
+}
+
+
+static uint16_t uart_tx_frame_max(void)
+{
+    return DRIVER_UART_TX_STAGE_SIZE;
+}
+
+#endif /* DRIVER_UART_TX_DMA */
+
+
 /**
  * @brief Gửi dữ liệu qua giao tiếp UART.
  *
  * Hàm này chịu trách nhiệm gửi một mảng dữ liệu qua giao tiếp UART.
+ * Ở chế độ DMA, hàm chỉ chép dữ liệu vào ring bulk rồi trả về.
  *
  * @param[in] data Con trỏ đến mảng dữ liệu cần gửi.
  * @param[in] size Kích thước của mảng dữ liệu (số byte).
  */
 void Driver_UART_Send(const uint8_t* data, size_t size)
 {
+#if DRIVER_UART_TX_DMA
+    if (data == NULL) {
+        return;
+    }
+
+    uint16_t chunk_max = uart_tx_frame_max();
+    while (size > 0) {
+        uint16_t chunk = (size > chunk_max) ? chunk_max : (uint16_t)size;
+        uint8_t* region = uart_tx_reserve(chunk, DRIVER_UART_PRIORITY_BULK);
+        memcpy(region, data, chunk);
+        uart_tx_commit(region, chunk);
+        data += chunk;
+        size -= chunk;
+    }
+#else
+    PROFILE_BEGIN(PROFILER_PROBE_UART_TX);
     HAL_UART_Transmit(&huart2, (uint8_t*)data, size, HAL_MAX_DELAY);
+    PROFILE_END(PROFILER_PROBE_UART_TX);
+#endif
+}
+
+
+/**
+ * @brief Giữ chỗ một vùng liên tục trong bộ đệm truyền để ghi dữ liệu trực tiếp.
+ *
+ * Mỗi lần giữ chỗ phải được kết thúc bằng Driver_UART_Commit() trước lần giữ chỗ
+ * hoặc lần gửi tiếp theo.
+ *
+ * @param[in] size     Số byte cần giữ chỗ.
+ * @param[in] priority Mức ưu tiên (driver_uart_priority_t) của khung.
+ * @return Con trỏ đến vùng nhớ được giữ chỗ, NULL nếu size quá lớn.
+ */
+uint8_t* Driver_UART_Reserve(size_t size, uint8_t priority)
+{
+    if (size == 0 || size > uart_tx_frame_max()) {
+        return NULL;
+    }
+
+    return uart_tx_reserve((uint16_t)size, priority);
+}
+
+
+/**
+ * @brief Xác nhận vùng đã giữ chỗ và bắt đầu truyền nó.
+ * @param[in] region Con trỏ trả về bởi Driver_UART_Reserve().
+ * @param[in] size   Số byte đã ghi, không lớn hơn số byte đã giữ chỗ.
+ */
+void Driver_UART_Commit(uint8_t* region, size_t size)
+{
+    if (region == NULL || size == 0) {
+        return;
+    }
+
+    uart_tx_commit(region, (uint16_t)size);
+}
+
+
+/**
+ * @brief Gửi nhiều đoạn dữ liệu như một lần truyền liên tục duy nhất.
+ *
+ * Các đoạn được ghép liền nhau trong bộ đệm truyền rồi mới khởi động phần cứng,
+ * nên cả khung chỉ tốn một lần thiết lập HAL/DMA thay vì một lần cho mỗi đoạn.
+ *
+ * @param[in] segments Mảng các đoạn dữ liệu theo đúng thứ tự truyền.
+ * @param[in] count    Số phần tử của mảng segments.
+ */
+void Driver_UART_SendV(const driver_uart_segment_t* segments, size_t count)
+{
+    if (segments == NULL) {
+        return;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += segments[i].size;
+    }
+
+    if (total == 0) {
+        return;
+    }
+
+    if (total > uart_tx_frame_max()) {
+        for (size_t i = 0; i < count; i++) {
+            Driver_UART_Send(segments[i].data, segments[i].size);
+        }
+        return;
+    }
+
+    uint8_t* region = uart_tx_reserve((uint16_t)total, DRIVER_UART_PRIORITY_BULK);
+    uint8_t* cursor = region;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(cursor, segments[i].data, segments[i].size);
+        cursor += segments[i].size;
+    }
+    uart_tx_commit(region, (uint16_t)total);
+}
+
+
+/**
+ * @brief Chờ cho đến khi toàn bộ dữ liệu trong các ring buffer đã được truyền xong.
+ */
+void Driver_UART_Flush(void)
+{
+#if DRIVER_UART_TX_DMA
+    while (Driver_UART_IsBusy()) {
+        uart_tx_poll();
+    }
+#endif
 }
 
+
+/**
+ * @brief Kiểm tra UART còn dữ liệu đang chờ hoặc đang truyền hay không.
+ * @return 1 nếu còn dữ liệu chưa truyền xong, 0 nếu đã rảnh.
+ */
+uint8_t Driver_UART_IsBusy(void)
+{
+#if DRIVER_UART_TX_DMA
+    if (tx_active != NULL) {
+        return 1;
+    }
+
+    for (uint8_t c = 0; c < DRIVER_UART_TX_CLASSES; c++) {
+        if (tx_rings[c].head != tx_rings[c].tail) {
+            return 1;
+        }
+    }
+#endif
+    return 0;
+}
+
+
+/**
+ * @brief Số byte lớn nhất có thể giữ chỗ ở một mức ưu tiên mà không phải chờ.
+ * Cùng điều kiện với uart_tx_find_space(); chỉ ring của mức ưu tiên được xét, khung lớn hơn
+ *      nửa ring đó (được uart_tx_reserve() chuyển sang ring bulk) không được tính.
+ * @param[in] priority Mức ưu tiên.
+ * @return Số byte.
+ */
+size_t Driver_UART_GetTxSpace(uint8_t priority)
+{
+#if DRIVER_UART_TX_DMA
+#if DRIVER_UART_TX_PRIORITY
+    const tx_ring_t *ring = &tx_rings[(priority < DRIVER_UART_TX_CLASSES) ? priority : DRIVER_UART_PRIORITY_BULK];
+#else
+    const tx_ring_t *ring = &tx_rings[DRIVER_UART_PRIORITY_BULK];
+    (void)priority;
+#endif
+    uint16_t head = ring->head;
+    uint16_t tail = ring->tail;
+    uint32_t space;
+
+    if (head >= tail) {
+        space = ring->size - head - 1u;
+        if (tail > 0 && tail - 1u > space) {
+            space = tail - 1u;
+        }
+    } else {
+        space = tail - head - 1u;
+    }
+
+    if (space > (uint32_t)TX_RING_ENTRY_MAX(ring)) {
+        space = TX_RING_ENTRY_MAX(ring);
+    }
+    return (space > TX_ENTRY_HEADER) ? space - TX_ENTRY_HEADER : 0;
+#else
+    (void)priority;
+    return uart_tx_frame_max();
+#endif
+}
+
+
+/**
+ * @brief Lấy thống kê độ trễ xếp hàng của một mức ưu tiên.
+ * @param[in] priority Mức ưu tiên.
+ * @return Con trỏ đến thống kê, NULL nếu mức ưu tiên không hợp lệ.
+ */
+const driver_uart_tx_stats_t* Driver_UART_GetTxStats(uint8_t priority)
+{
+    if (priority >= DRIVER_UART_TX_CLASSES) {
+        return NULL;
+    }
+
+    return &tx_stats[priority];
+}
+
+
+/**
+ * @brief Xóa thống kê độ trễ của mọi mức ưu tiên.
+ */
+void Driver_UART_ResetTxStats(void)
+{
+    memset(tx_stats, 0, sizeof(tx_stats));
+}
+
+
+/**
+ * @brief Callback của HAL khi đường nhận rảnh hoặc DMA ghi đến nửa/cuối ring nhận.
+ * Giữa hai sự kiện DMA ghi tối đa nửa ring, nên số byte mới luôn xác định được; nếu cùng với
+ *      phần chưa đọc chúng vượt quá ring thì DMA đã ghi đè dữ liệu chưa đọc.
+ * @param[in] huart Con trỏ đến UART vừa nhận.
+ * @param[in] Size  Vị trí ghi của DMA trong ring (DRIVER_UART_RX_SIZE ở cuối bộ đệm).
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart->Instance != USART2) {
+        return;
+    }
+
+    uint16_t head = Size & RX_MASK;
+    uint16_t received = (head - rx_head) & RX_MASK;
+    uint16_t pending = (rx_head - rx_tail) & RX_MASK;
+
+    if (pending + received >= DRIVER_UART_RX_SIZE) {
+        rx_errors++;
+        rx_resync = 1;
+    }
+    rx_head = head;
+}
+
+
+/**
+ * @brief Callback của HAL khi UART gặp lỗi.
+ * Lỗi nhận được đếm và việc nhận được khởi động lại nếu HAL đã dừng nó (overrun);
+ *      ở chế độ DMA, khung đang truyền sẽ được gửi lại.
+ * @param[in] huart Con trỏ đến UART gặp lỗi.
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != USART2) {
+        return;
+    }
+
+    if (huart->ErrorCode & (HAL_UART_ERROR_FE | HAL_UART_ERROR_NE | HAL_UART_ERROR_ORE)) {
+        rx_errors++;
+    }
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        Driver_UART_RxStart();
+    }
+
+#if DRIVER_UART_TX_DMA
+    uart_tx_recover();
+#endif
+}
+
+
+/**
+ * @brief Bắt đầu nhận dữ liệu từ USART2 vào ring nhận bằng DMA vòng.
+ * DMA ghi lại từ đầu ring nên phần chưa đọc bị bỏ ở lần đọc kế tiếp.
+ */
+void Driver_UART_RxStart(void)
+{
+    rx_head = 0;
+    rx_resync = 1;
+
+    if (HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_ring, DRIVER_UART_RX_SIZE) != HAL_OK) {
+        rx_errors++;
+    }
+}
+
+
+/**
+ * @brief Lấy dữ liệu đã nhận ra khỏi ring nhận.
+ * @param[out] data Bộ đệm nhận dữ liệu.
+ * @param[in]  size Kích thước bộ đệm.
+ * @return Số byte đã chép, 0 nếu chưa có dữ liệu.
+ */
+size_t Driver_UART_Read(uint8_t* data, size_t size)
+{
+    size_t count = 0;
+
+    if (rx_resync) {
+        rx_resync = 0;
+        rx_tail = rx_head;
+    }
+
+    uint16_t tail = rx_tail;
+    uint16_t head = rx_head;
+    while (count < size && tail != head) {
+        data[count++] = rx_ring[tail];
+        tail = (tail + 1) & RX_MASK;
+    }
+
+    rx_tail = tail;
+    return count;
+}
+
+
+/**
+ * @brief Số lỗi nhận kể từ khi khởi động.
+ */
+uint32_t Driver_UART_GetRxErrors(void)
+{
+    return rx_errors;
+}
+
+
+/**
+ * @brief Kiểm tra USART2 có đạt được một tốc độ baud trong dung sai hay không.
+ *
+ * Với cả hai chế độ oversampling, baud = PCLK1 / div với div = 16 * USARTDIV
+ *      (oversampling 16) hoặc 8 * USARTDIV (oversampling 8), tức là cùng một bộ chia
+ *      có 4 hoặc 3 bit phần lẻ; oversampling 8 cho phép div nhỏ đến 8 thay vì 16.
+ *
+ * @param[in]  baud         Tốc độ cần kiểm tra.
+ * @param[out] oversampling Oversampling sẽ dùng (8 hoặc 16), có thể NULL.
+ * @return Tốc độ thực tế sau bộ chia, 0 nếu không đạt được.
+ */
+uint32_t Driver_UART_CheckBaud(uint32_t baud, uint8_t* oversampling)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+
+    if (baud == 0) {
+        return 0;
+    }
+
+    uint32_t div = (pclk + baud / 2) / baud;
+    if (div < 8 || div > 0xFFFF) {
+        return 0;
+    }
+
+    uint32_t actual = pclk / div;
+    uint32_t error = (actual > baud) ? actual - baud : baud - actual;
+    if ((uint64_t)error * 1000u > (uint64_t)baud * DRIVER_UART_BAUD_TOLERANCE) {
+        return 0;
+    }
+
+    if (oversampling != NULL) {
+        *oversampling = (div >= 16) ? 16 : 8;
+    }
+    return actual;
+}
+
+
+/**
+ * @brief Đổi tốc độ baud của USART2.
+ *
+ * HAL_UART_Init() không gọi lại MspInit khi UART đã được khởi tạo, nên GPIO, DMA và
+ *      NVIC được giữ nguyên; chỉ BRR và bit OVER8 thay đổi.
+ *
+ * @param[in] baud Tốc độ mới.
+ * @return 1 nếu đã đổi, 0 nếu tốc độ không đạt được.
+ */
+uint8_t Driver_UART_SetBaud(uint32_t baud)
+{
+    uint8_t oversampling;
+    if (Driver_UART_CheckBaud(baud, &oversampling) == 0) {
+        return 0;
+    }
+
+    Driver_UART_Flush();
+    HAL_UART_AbortReceive(&huart2);
+
+    huart2.Init.BaudRate = baud;
+    huart2.Init.OverSampling = (oversampling == 8) ? UART_OVERSAMPLING_8 : UART_OVERSAMPLING_16;
+    if (HAL_UART_Init(&huart2) != HAL_OK) {
+        return 0;
+    }
+
+    Driver_UART_RxStart();
+    return 1;
+}
+
+
+/**
+ * @brief Tốc độ baud hiện tại của USART2.
+ */
+uint32_t Driver_UART_GetBaud(void)
+{
+    return huart2.Init.BaudRate;
+}
+
+
+/**
+ * @brief Ghi nhận một nửa bộ đệm ADC vừa được DMA ghi đầy.
+ * Nửa đó bị tính là ghi đè nếu khối trước của nó chưa được lấy ra hoặc vẫn đang được dùng.
+ * @param[in] half Nửa bộ đệm (0 hoặc 1).
+ */
+static void adc_block_done(uint8_t half)
+{
+    uint8_t bit = (uint8_t)(1u << half);
+
+    if ((adc_block_ready & bit) || adc_block_held == half) {
+        adc_stats.overruns++;
+    }
+
+    adc_block_first[half] = adc_stats.samples;
+    adc_stats.samples += DRIVER_ADC_BLOCK_SIZE;
+    adc_block_ready |= bit;
+}
+
+
+/**
+ * @brief Xử lý ngắt half/full-complete của DMA2 Stream0.
+ * Nếu ngắt đến trễ đến mức cả hai cờ cùng bật, vị trí hiện tại của DMA cho biết nửa nào
+ *      đầy trước để số thứ tự mẫu vẫn tăng theo đúng thứ tự thời gian.
+ */
+void Driver_ADC_IRQHandler(void)
+{
+    uint32_t flags = DMA2->LISR;
+    DMA2->LIFCR = flags & ADC_DMA_FLAGS;
+
+    uint8_t half_done = (flags & DMA_LISR_HTIF0) != 0;
+    uint8_t full_done = (flags & DMA_LISR_TCIF0) != 0;
+
+    if (half_done && full_done && DMA2_Stream0->NDTR <= DRIVER_ADC_BLOCK_SIZE) {
+        // DMA đang ghi nửa sau: nửa sau đầy ở vòng trước, nửa đầu vừa đầy
+        adc_block_done(1);
+        adc_block_done(0);
+        return;
+    }
+
+    if (half_done) {
+        adc_block_done(0);
+    }
+    if (full_done) {
+        adc_block_done(1);
+    }
+}
+
+
+/**
+ * @brief Cấp clock và bật ADC1 nếu chưa bật; cấu hình chung (bộ chia, độ phân giải) chỉ
+ *      được ghi một lần để luồng ADC và cảm biến nhiệt độ không xóa cấu hình của nhau.
+ */
+static void adc_power_on(void)
+{
+    __HAL_RCC_ADC1_CLK_ENABLE();
+
+    if (ADC1->CR2 & ADC_CR2_ADON) {
+        return;
+    }
+
+    ADC->CCR = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0;
+    ADC1->CR1 = 0;
+    ADC1->CR2 = ADC_CR2_ADON;
+}
+
+
+/**
+ * @brief Bắt đầu lấy mẫu ADC1 kênh 1 (PA1) theo xung TIM2, DMA vòng vào bộ đệm ping-pong.
+ *
+ * Module HAL ADC/TIM không được bật trong dự án nên ADC1, TIM2 và DMA2 Stream0 được cấu hình
+ *      trực tiếp bằng thanh ghi: TIM2 update -> TRGO kích một lần chuyển đổi, ADC1 yêu cầu DMA
+ *      sau mỗi mẫu, DMA2 Stream0 (kênh 0) ghi vòng vào adc_buffer và ngắt ở nửa và cuối bộ đệm.
+ * ADC chạy ở PCLK2/4 = 21 MHz với thời gian lấy mẫu 84 chu kỳ, tức ~4.6 us mỗi mẫu.
+ *
+ * @param[in] rate_hz Tần số lấy mẫu (Hz), tối đa DRIVER_ADC_RATE_MAX.
+ * @return Tần số thực tế sau bộ chia của TIM2, 0 nếu không đạt được.
+ */
+uint32_t Driver_ADC_Start(uint32_t rate_hz)
+{
+    if (rate_hz == 0 || rate_hz > DRIVER_ADC_RATE_MAX) {
+        return 0;
+    }
+
+    // Timer trên APB1 chạy ở 2 x PCLK1 khi bộ chia APB1 khác 1
+    uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+        timer_clock *= 2;
+    }
+    uint32_t period = (timer_clock + rate_hz / 2) / rate_hz;
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    adc_power_on();
+
+    Driver_ADC_Stop();
+    memset(&adc_stats, 0, sizeof(adc_stats));
+
+    GPIOA->MODER |= GPIO_MODER_MODER1;
+    GPIOA->PUPDR &= ~GPIO_PUPDR_PUPD1;
+
+    ADC1->SMPR2 = (ADC1->SMPR2 & ~ADC_SMPR2_SMP1) | (4u << ADC_SMPR2_SMP1_Pos);
+    ADC1->SQR1 = 0;
+    ADC1->SQR3 = 1u << ADC_SQR3_SQ1_Pos;
+
+    DMA2_Stream0->PAR = (uint32_t)&ADC1->DR;
+    DMA2_Stream0->M0AR = (uint32_t)adc_buffer;
+    DMA2_Stream0->NDTR = 2 * DRIVER_ADC_BLOCK_SIZE;
+    DMA2_Stream0->FCR = 0;
+    DMA2_Stream0->CR = (0u << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 |
+                       DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_CIRC |
+                       DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+    DMA2->LIFCR = ADC_DMA_FLAGS;
+    DMA2_Stream0->CR |= DMA_SxCR_EN;
+
+    // Dưới USART2 TX DMA (0) để việc nối tiếp khung truyền không bị trễ
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+
+    // Chuyển đổi theo sườn lên của TIM2 TRGO (EXTSEL = 0110), DMA chạy liên tục (DDS);
+    // các bit injected của cảm biến nhiệt độ được giữ nguyên
+    ADC1->CR2 = (ADC1->CR2 & ~ADC_REGULAR_BITS) | ADC_CR2_DMA | ADC_CR2_DDS |
+                ADC_CR2_EXTEN_0 | (6u << ADC_CR2_EXTSEL_Pos);
+
+    TIM2->PSC = 0;
+    TIM2->ARR = period - 1;
+    TIM2->CR2 = TIM_CR2_MMS_1;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CR1 = TIM_CR1_CEN;
+
+    return timer_clock / period;
+}
+
+
+/**
+ * @brief Dừng lấy mẫu ADC; các khối chưa lấy ra bị bỏ.
+ */
+void Driver_ADC_Stop(void)
+{
+    TIM2->CR1 &= ~TIM_CR1_CEN;
+    ADC1->CR2 &= ~ADC_REGULAR_BITS;
+
+    // Loạt nhiệt độ đang chờ TIM2 CC1 sẽ không còn xung kích: chuyển sang tự nối
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (temp_remaining > 0 && temp_software == 0) {
+        temp_software = 1;
+        ADC1->CR2 &= ~(ADC_CR2_JEXTEN | ADC_CR2_JEXTSEL);
+        ADC1->CR2 |= ADC_CR2_JSWSTART;
+    }
+    __set_PRIMASK(primask);
+
+    DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+    while (DMA2_Stream0->CR & DMA_SxCR_EN) {
+    }
+    DMA2->LIFCR = ADC_DMA_FLAGS;
+
+    adc_block_ready = 0;
+    adc_block_held = ADC_BLOCK_NONE;
+}
+
+
+/**
+ * @brief Lấy khối ADC cũ nhất đã đầy.
+ * @param[out] first_sample Số thứ tự của mẫu đầu tiên trong khối.
+ * @return Con trỏ đến DRIVER_ADC_BLOCK_SIZE mẫu, NULL nếu chưa có khối nào đầy.
+ */
+const uint16_t* Driver_ADC_GetBlock(uint32_t* first_sample)
+{
+    uint8_t half;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    switch (adc_block_ready) {
+    case 0:
+        __set_PRIMASK(primask);
+        return NULL;
+    case 1:
+        half = 0;
+        break;
+    case 2:
+        half = 1;
+        break;
+    default:
+        half = ((int32_t)(adc_block_first[1] - adc_block_first[0]) < 0) ? 1 : 0;
+        break;
+    }
+
+    *first_sample = adc_block_first[half];
+    adc_block_ready &= (uint8_t)~(1u << half);
+    adc_block_held = half;
+    adc_stats.blocks++;
+
+    __set_PRIMASK(primask);
+    return &adc_buffer[half * DRIVER_ADC_BLOCK_SIZE];
+}
+
+
+/**
+ * @brief Trả lại khối vừa lấy bởi Driver_ADC_GetBlock().
+ */
+void Driver_ADC_ReleaseBlock(void)
+{
+    adc_block_held = ADC_BLOCK_NONE;
+}
+
+
+/**
+ * @brief Lấy thống kê của luồng lấy mẫu ADC.
+ */
+const driver_adc_stats_t* Driver_ADC_GetStats(void)
+{
+    return &adc_stats;
+}
+
+
+/**
+ * @brief Bắt đầu một loạt chuyển đổi injected của cảm biến nhiệt độ trong (ADC1 kênh 16).
+ *
+ * Cảm biến cần thời gian lấy mẫu tối thiểu 10 us nên kênh 16 dùng 480 chu kỳ (~23 us ở 21 MHz).
+ * Khi luồng ADC đang chạy, TIM2 CC1 (PWM mode 2, CCR1 = ARR/2) kích một chuyển đổi injected
+ *      ở giữa mỗi chu kỳ lấy mẫu, nên chuyển đổi regular không bị ngắt ngang chừng nào nửa
+ *      chu kỳ còn dài hơn chuyển đổi injected (tần số lấy mẫu tới ~20 kHz). Ở tần số cao hơn
+ *      ADC tự xếp lượt hai nhóm, mẫu regular chỉ bị trễ chứ không mất.
+ * Khi luồng dừng, mỗi ngắt JEOC đặt JSWSTART cho chuyển đổi kế tiếp.
+ *
+ * @param[in] samples Số chuyển đổi của loạt.
+ * @return 1 nếu đã bắt đầu, 0 nếu loạt trước chưa xong.
+ */
+uint8_t Driver_TempSensor_Start(uint16_t samples)
+{
+    if (samples == 0 || temp_remaining > 0) {
+        return 0;
+    }
+
+    adc_power_on();
+
+    ADC->CCR |= ADC_CCR_TSVREFE;
+    ADC1->SMPR1 = (ADC1->SMPR1 & ~ADC_SMPR1_SMP16) | (7u << ADC_SMPR1_SMP16_Pos);
+    ADC1->JSQR = 16u << ADC_JSQR_JSQ4_Pos;
+
+    temp_sum = 0;
+    temp_done = 0;
+    temp_samples = samples;
+    temp_remaining = samples;
+
+    ADC1->SR = (uint32_t)~ADC_SR_JEOC;
+    ADC1->CR1 |= ADC_CR1_JEOCIE;
+    HAL_NVIC_SetPriority(ADC_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(ADC_IRQn);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (TIM2->CR1 & TIM_CR1_CEN) {
+        // OC1REF lên mức cao khi CNT đạt CCR1; chân PA0/PA5/PA15 không ở chế độ AF nên không bị ảnh hưởng
+        temp_software = 0;
+        TIM2->CCR1 = TIM2->ARR / 2;
+        TIM2->CCMR1 = (TIM2->CCMR1 & ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M)) | (7u << TIM_CCMR1_OC1M_Pos);
+        TIM2->CCER |= TIM_CCER_CC1E;
+        ADC1->CR2 = (ADC1->CR2 & ~(ADC_CR2_JEXTEN | ADC_CR2_JEXTSEL)) |
+                    ADC_CR2_JEXTEN_0 | (2u << ADC_CR2_JEXTSEL_Pos);
+    } else {
+        temp_software = 1;
+        ADC1->CR2 &= ~(ADC_CR2_JEXTEN | ADC_CR2_JEXTSEL);
+        ADC1->CR2 |= ADC_CR2_JSWSTART;
+    }
+    __set_PRIMASK(primask);
+
+    return 1;
+}
+
+
+/**
+ * @brief Lấy kết quả của loạt chuyển đổi vừa xong.
+ * @param[out] sum Tổng các giá trị 12 bit của loạt.
+ * @return Số chuyển đổi của loạt, 0 nếu chưa có loạt nào xong.
+ */
+uint16_t Driver_TempSensor_Read(uint32_t* sum)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t count = temp_done;
+    *sum = temp_sum;
+    temp_done = 0;
+
+    __set_PRIMASK(primask);
+    return count;
+}
+
+
+/**
+ * @brief Đọc giá trị hiệu chuẩn của cảm biến nhiệt độ trong system memory.
+ * @param[out] cal30  Giá trị ADC ở 30 °C.
+ * @param[out] cal110 Giá trị ADC ở 110 °C.
+ * @return 1 nếu hai giá trị hợp lý, 0 nếu không.
+ */
+uint8_t Driver_TempSensor_GetCalibration(uint16_t* cal30, uint16_t* cal110)
+{
+    *cal30 = *TEMP_CAL30_ADDR;
+    *cal110 = *TEMP_CAL110_ADDR;
+
+    return (*cal30 > 0 && *cal30 < *cal110 && *cal110 <= 0x0FFF) ? 1 : 0;
+}
+
+
+/**
+ * @brief Xử lý ngắt JEOC của ADC1: cộng dồn mẫu và nối hoặc kết thúc loạt.
+ */
+void Driver_TempSensor_IRQHandler(void)
+{
+    if ((ADC1->SR & ADC_SR_JEOC) == 0) {
+        return;
+    }
+    ADC1->SR = (uint32_t)~ADC_SR_JEOC;
+
+    if (temp_remaining == 0) {
+        return;
+    }
+
+    temp_sum += ADC1->JDR1;
+    temp_remaining--;
+
+    if (temp_remaining == 0) {
+        ADC1->CR2 &= ~(ADC_CR2_JEXTEN | ADC_CR2_JEXTSEL);
+        ADC1->CR1 &= ~ADC_CR1_JEOCIE;
+        temp_done = temp_samples;
+        return;
+    }
+
+    if (temp_software) {
+        ADC1->CR2 |= ADC_CR2_JSWSTART;
+    }
+}
+
+
+/**
+ * @brief Callback của HAL khi có cạnh trên chân EXTI: ghi thời điểm và mức của chân vào hàng đợi.
+ * Thời điểm được lấy trước mọi việc khác để độ trễ đo được gồm cả thời gian xếp hàng.
+ * @param[in] GPIO_Pin Chân gây ngắt.
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    uint32_t cycles = Driver_GetCycles();
+
+    if (GPIO_Pin != GPIO_PIN_0) {
+        return;
+    }
+
+    uint8_t next = (button_head + 1) & (DRIVER_BUTTON_QUEUE_SIZE - 1);
+    if (next == button_tail) {
+        button_dropped++;
+        return;
+    }
+
+    button_queue[button_head].cycles = cycles;
+    button_queue[button_head].level = (uint8_t)HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0);
+    __DMB();
+    button_head = next;
+}
+
+
+/**
+ * @brief Lấy cạnh cũ nhất ra khỏi hàng đợi của nút nhấn.
+ * @param[out] edge Cạnh lấy ra.
+ * @return 1 nếu có cạnh, 0 nếu hàng đợi rỗng.
+ */
+uint8_t Driver_Button_Read(driver_button_edge_t* edge)
+{
+    uint8_t tail = button_tail;
+
+    if (tail == button_head) {
+        return 0;
+    }
+
+    __DMB();
+    *edge = button_queue[tail];
+    button_tail = (tail + 1) & (DRIVER_BUTTON_QUEUE_SIZE - 1);
+    return 1;
+}
+
+
+/**
+ * @brief Mức hiện tại của chân nút nhấn.
+ */
+uint8_t Driver_Button_GetLevel(void)
+{
+    return (uint8_t)HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0);
+}
+
+
+/**
+ * @brief Số cạnh bị bỏ do hàng đợi đầy.
+ */
+uint32_t Driver_Button_GetDropped(void)
+{
+    return button_dropped;
+}
+
+
+/**
+ * @brief Bật clock cho bộ CRC phần cứng.
+ */
+void Driver_CRC32_Init(void)
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+}
+
+
+/**
+ * @brief Tính CRC-32 bằng bộ CRC phần cứng.
+ *
+ * Mỗi word chỉ tốn một lệnh ghi vào CRC->DR; bộ CRC xử lý một word trong 4 chu kỳ
+ *      AHB nên CPU không phải chờ giữa các lần ghi.
+ *
+ * @param[in] data   Dữ liệu cần tính.
+ * @param[in] length Số byte.
+ * @return Giá trị CRC-32.
+ */
+uint32_t Driver_CRC32_Calculate(const uint8_t* data, size_t length)
+{
+    CRC->CR = CRC_CR_RESET;
+
+    while (length >= sizeof(uint32_t)) {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        CRC->DR = word;
+        data += sizeof(word);
+        length -= sizeof(word);
+    }
+
+    if (length > 0) {
+        uint32_t word = 0;
+        memcpy(&word, data, length);
+        CRC->DR = word;
+    }
+
+    return CRC->DR;
+}
+
+
+/**
+ * @brief Địa chỉ đọc của một sector nhật ký.
+ * @param[in] sector Sector nhật ký.
+ * @return Con trỏ đến đầu sector, NULL nếu sector không hợp lệ.
+ */
+const uint32_t* Driver_Flash_GetSector(uint8_t sector)
+{
+    if (sector >= DRIVER_FLASH_LOG_SECTORS) {
+        return NULL;
+    }
+
+    return (const uint32_t*)(FLASH_LOG_BASE + sector * DRIVER_FLASH_LOG_SECTOR_SIZE);
+}
+
+
+/**
+ * @brief Ghi các word vào một sector nhật ký.
+ *
+ * Ghi theo word (x32) vì ghi double-word (x64) cần nguồn Vpp ngoài 8-9 V. HAL_FLASH_Program
+ *      chờ từng word xong (~16 us) nên người gọi giới hạn số word mỗi lần gọi. Bộ đệm dữ liệu
+ *      của ART được làm mới sau khi ghi để lần đọc kế tiếp không trả về giá trị cũ.
+ *
+ * @param[in] sector Sector nhật ký.
+ * @param[in] offset Vị trí trong sector (byte), chia hết cho 4.
+ * @param[in] words  Các word cần ghi.
+ * @param[in] count  Số word.
+ * @return 1 nếu thành công, 0 nếu tham số sai, đang xóa hoặc lỗi ghi.
+ */
+uint8_t Driver_Flash_Program(uint8_t sector, uint32_t offset, const uint32_t* words, uint16_t count)
+{
+    if (sector >= DRIVER_FLASH_LOG_SECTORS || words == NULL || (offset & 3u) != 0 ||
+        offset + (uint32_t)count * sizeof(uint32_t) > DRIVER_FLASH_LOG_SECTOR_SIZE ||
+        flash_state == DRIVER_FLASH_BUSY) {
+        return 0;
+    }
+
+    uint32_t address = FLASH_LOG_BASE + sector * DRIVER_FLASH_LOG_SECTOR_SIZE + offset;
+    HAL_StatusTypeDef status = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint16_t i = 0; i < count && status == HAL_OK; i++) {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + i * sizeof(uint32_t), words[i]);
+    }
+    HAL_FLASH_Lock();
+
+    if (FLASH->ACR & FLASH_ACR_DCEN) {
+        __HAL_FLASH_DATA_CACHE_DISABLE();
+        __HAL_FLASH_DATA_CACHE_RESET();
+        __HAL_FLASH_DATA_CACHE_ENABLE();
+    }
+
+    return (status == HAL_OK) ? 1 : 0;
+}
+
+
+/**
+ * @brief Bắt đầu xóa một sector nhật ký bằng HAL_FLASHEx_Erase_IT.
+ *
+ * Kết thúc được báo qua HAL_FLASH_EndOfOperationCallback()/HAL_FLASH_OperationErrorCallback()
+ *      từ ngắt FLASH, nên không có vòng chờ bận nào trong phần mềm.
+ *
+ * @param[in] sector Sector nhật ký.
+ * @return 1 nếu đã bắt đầu, 0 nếu sector không hợp lệ hoặc bộ điều khiển đang bận.
+ */
+uint8_t Driver_Flash_EraseStart(uint8_t sector)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase    = FLASH_TYPEERASE_SECTORS,
+        .Sector       = FLASH_LOG_FIRST_SECTOR + sector,
+        .NbSectors    = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+    };
+
+    if (sector >= DRIVER_FLASH_LOG_SECTORS || flash_state == DRIVER_FLASH_BUSY) {
+        return 0;
+    }
+
+    // Thấp nhất trong các ngắt của driver: chỉ báo kết thúc, không có yêu cầu thời gian
+    HAL_NVIC_SetPriority(FLASH_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(FLASH_IRQn);
+
+    flash_state = DRIVER_FLASH_BUSY;
+    flash_erase_cycles = Driver_GetCycles();
+    flash_erase_tick = HAL_GetTick();
+    HAL_FLASH_Unlock();
+    if (HAL_FLASHEx_Erase_IT(&erase) != HAL_OK) {
+        HAL_FLASH_Lock();
+        flash_state = DRIVER_FLASH_ERROR;
+        return 0;
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Trạng thái hiện tại của bộ điều khiển flash.
+ */
+uint8_t Driver_Flash_GetState(void)
+{
+    return flash_state;
+}
+
+
+/**
+ * @brief Bù các ngắt SysTick bị mất trong lúc CPU dừng vì xóa sector.
+ *
+ * SysTick vẫn đếm nhưng chỉ giữ được một ngắt chờ, nên HAL_GetTick() chậm đi gần bằng thời
+ *      gian xóa. CYCCNT chạy theo HCLK kể cả khi CPU chờ bus, nên phần thiếu được tính từ nó;
+ *      ngắt SysTick đang chờ (ưu tiên thấp hơn ngắt FLASH) sẽ tự cộng thêm một.
+ */
+static void flash_erase_fix_tick(void)
+{
+    uint32_t elapsed_ms = Driver_CyclesToUs(Driver_GetCycles() - flash_erase_cycles) / 1000u;
+    uint32_t counted = HAL_GetTick() - flash_erase_tick;
+
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        counted++;
+    }
+    if (elapsed_ms > counted) {
+        uwTick += elapsed_ms - counted;
+    }
+}
+
+
+/**
+ * @brief Callback của HAL khi một thao tác flash bằng ngắt kết thúc.
+ * @param[in] ReturnValue 0xFFFFFFFF khi sector cuối của lần xóa đã xong.
+ */
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+    if (ReturnValue == 0xFFFFFFFFu) {
+        HAL_FLASH_Lock();
+        flash_erase_fix_tick();
+        flash_state = DRIVER_FLASH_IDLE;
+    }
+}
+
+
+/**
+ * @brief Callback của HAL khi thao tác flash bằng ngắt gặp lỗi.
+ * @param[in] ReturnValue Sector hoặc địa chỉ bị lỗi.
+ */
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+    (void)ReturnValue;
+    HAL_FLASH_Lock();
+    flash_erase_fix_tick();
+    flash_state = DRIVER_FLASH_ERROR;
+}
+
+
+/**
+ * @brief Xử lý ngắt của bộ điều khiển flash.
+ */
+void Driver_Flash_IRQHandler(void)
+{
+    HAL_FLASH_IRQHandler();
+}
@@ -0,0 +1,584 @@
+/*
+ * FlashLog.c
+ *
+ *  Created on: May 16, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "FlashLog.h"
+
+#if FLASH_LOG_ENABLED
+
+#include "Driver.h"
+#include "Protocol.h"
+#include "Utils.h"
+#include <string.h>
+
+
+/** @brief Phần đầu của một sector: FLASH_LOG_MAGIC và generation. */
+#define FLASH_LOG_SECTOR_HEADER (2 * sizeof(uint32_t))
+
+#define FLASH_LOG_SECTOR_END    DRIVER_FLASH_LOG_SECTOR_SIZE
+#define FLASH_LOG_ERASED        0xFFFFFFFFu
+#define FLASH_LOG_STATE_WRITING 0xFFFFu
+#define FLASH_LOG_NO_SECTOR     0xFF
+
+// Khung lớn nhất được lưu: khung có số thứ tự không bao giờ được lưu
+#define FLASH_LOG_RECORD_MAX    (FRAME_HEADER_SIZE_OF(FRAME_FLAG_CRC32 | FRAME_FLAG_TS32) + MAX_PAYLOAD_SIZE)
+
+#define FLASH_LOG_WORDS(length) (((uint32_t)(length) + 3u) / sizeof(uint32_t))
+#define FLASH_LOG_QUEUE_WORDS   (FLASH_LOG_QUEUE_SIZE / sizeof(uint32_t))
+#define FLASH_LOG_BIT(sector)   ((uint8_t)(1u << (sector)))
+#define FLASH_LOG_NEXT(sector)  ((uint8_t)(((sector) + 1) % DRIVER_FLASH_LOG_SECTORS))
+
+
+// Hàng đợi RAM: mỗi bản ghi là word đầu (độ dài, trạng thái 0xFFFF) và dữ liệu đã đệm,
+// đúng như sẽ nằm trong flash; chỉ main context dùng nên không cần khóa ngắt
+static uint32_t flash_log_queue[FLASH_LOG_QUEUE_WORDS];
+static uint16_t queue_head = 0;
+static uint16_t queue_tail = 0;
+static uint16_t queue_used = 0;                 // Số word đang dùng
+
+// Con trỏ ghi: write_offset là cuối bản ghi đã ghi xong cuối cùng, bản ghi đang ghi dở
+// (record_done word đầu đã ghi) bắt đầu tại đó
+static uint8_t  write_sector = FLASH_LOG_NO_SECTOR;
+static uint32_t write_offset = 0;
+static uint32_t generation = 0;                 // Generation của sector ghi
+static uint16_t record_done = 0;
+
+// Con trỏ đọc: bản ghi kế tiếp cần phát lại, các sector từ read_sector đến write_sector còn tồn đọng
+static uint8_t  read_sector = FLASH_LOG_NO_SECTOR;
+static uint32_t read_offset = 0;
+
+static uint8_t  sectors_erased = 0;             // Bit n: sector n trống hoàn toàn
+static uint8_t  erasing = FLASH_LOG_NO_SECTOR;
+
+// Host chưa rõ sau khi khởi động: không lưu và không xóa cho đến khi hết FLASH_LOG_HOST_TIMEOUT_MS
+#define FLASH_LOG_HOST_UNKNOWN  0
+#define FLASH_LOG_HOST_ABSENT   1
+#define FLASH_LOG_HOST_PRESENT  2
+
+static uint8_t  host_state = FLASH_LOG_HOST_UNKNOWN;
+static uint32_t host_last_ms = 0;
+static uint8_t  write_waiting = 0;              // Bản ghi đầu hàng đợi chờ một sector được xóa
+static uint8_t  status_pending = 0;             // STATUS chờ gửi (host vừa xuất hiện hoặc DUMP)
+static uint8_t  dumping = 0;
+static uint32_t dump_count = 0;                 // Số bản ghi đã phát lại trong lần DUMP hiện tại
+static flash_log_stats_t flash_log_stats;
+
+
+/**
+ * @brief Đọc word đầu của bản ghi tại offset.
+ * @param[out] header Word đầu.
+ * @return Kích thước bản ghi trong flash (kể cả word đầu và phần đệm), 0 nếu không còn bản ghi
+ *      (word trống, word đầu vô nghĩa hoặc bản ghi vượt quá sector).
+ */
+static uint32_t flash_log_record_size(uint8_t sector, uint32_t offset, uint32_t* header)
+{
+    if (offset + sizeof(uint32_t) > FLASH_LOG_SECTOR_END) {
+        *header = 0;
+        return 0;
+    }
+
+    *header = Driver_Flash_GetSector(sector)[offset / sizeof(uint32_t)];
+    uint32_t length = *header & 0xFFFFu;
+    if (*header == FLASH_LOG_ERASED || length == 0 || length > FLASH_LOG_RECORD_MAX) {
+        return 0;
+    }
+
+    uint32_t size = (1u + FLASH_LOG_WORDS(length)) * sizeof(uint32_t);
+    return (offset + size <= FLASH_LOG_SECTOR_END) ? size : 0;
+}
+
+
+/**
+ * @brief Tiến con trỏ đọc đến bản ghi đã ghi xong và chưa phát lại đầu tiên, hoặc đến con trỏ ghi.
+ */
+static void flash_log_seek(void)
+{
+    uint32_t header;
+
+    while (read_sector != FLASH_LOG_NO_SECTOR) {
+        if (read_sector == write_sector && read_offset >= write_offset) {
+            read_offset = write_offset;
+            return;
+        }
+
+        uint32_t size = flash_log_record_size(read_sector, read_offset, &header);
+        if (size == 0) {
+            if (read_sector == write_sector) {
+                read_offset = write_offset;
+                return;
+            }
+            read_sector = FLASH_LOG_NEXT(read_sector);
+            read_offset = FLASH_LOG_SECTOR_HEADER;
+            continue;
+        }
+        if ((header >> 16) == FLASH_LOG_STATE_COMMITTED) {
+            return;
+        }
+        read_offset += size;
+    }
+}
+
+
+/**
+ * @brief Số byte từ con trỏ đọc đến con trỏ ghi, kể cả hàng đợi (cận trên của phần tồn đọng).
+ */
+static uint32_t flash_log_backlog(void)
+{
+    uint32_t bytes = (uint32_t)queue_used * sizeof(uint32_t);
+
+    if (read_sector == FLASH_LOG_NO_SECTOR) {
+        return bytes;
+    }
+
+    uint8_t  sector = read_sector;
+    uint32_t offset = read_offset;
+    while (sector != write_sector) {
+        bytes += FLASH_LOG_SECTOR_END - offset;
+        sector = FLASH_LOG_NEXT(sector);
+        offset = FLASH_LOG_SECTOR_HEADER;
+    }
+    return bytes + ((write_offset > offset) ? write_offset - offset : 0);
+}
+
+
+/**
+ * @brief Bắt đầu xóa một sector; con trỏ đọc nằm trong sector đó được chuyển sang sector kế tiếp.
+ */
+static void flash_log_erase(uint8_t sector)
+{
+    flash_log_seek();
+    if (read_sector == sector && sector != write_sector) {
+        // Sector cũ nhất còn bản ghi chưa phát lại: vòng đã đầy
+        flash_log_stats.lost++;
+        read_sector = FLASH_LOG_NEXT(sector);
+        read_offset = FLASH_LOG_SECTOR_HEADER;
+    }
+
+    // Xóa magic trước: sector bị mất điện giữa lần xóa không còn được coi là một phần của vòng
+    uint32_t invalid = 0;
+    sectors_erased &= (uint8_t)~FLASH_LOG_BIT(sector);
+    (void)Driver_Flash_Program(sector, 0, &invalid, 1);
+    if (Driver_Flash_EraseStart(sector)) {
+        erasing = sector;
+        flash_log_stats.erases++;
+    } else {
+        flash_log_stats.errors++;
+    }
+}
+
+
+/**
+ * @brief Bảo đảm sector ghi còn đủ chỗ cho một bản ghi, chuyển sang sector kế tiếp nếu cần.
+ * @param[in] words Số word của bản ghi.
+ * @return 1 nếu có chỗ, 0 nếu phải chờ sector kế tiếp được xóa.
+ */
+static uint8_t flash_log_reserve(uint32_t words)
+{
+    if (write_sector != FLASH_LOG_NO_SECTOR &&
+        write_offset + words * sizeof(uint32_t) <= FLASH_LOG_SECTOR_END) {
+        return 1;
+    }
+
+    uint8_t next = (write_sector == FLASH_LOG_NO_SECTOR) ? 0 : FLASH_LOG_NEXT(write_sector);
+    if (!(sectors_erased & FLASH_LOG_BIT(next))) {
+        // Xóa dừng CPU (Driver_Flash_EraseStart()), nên chỉ xóa khi không có luồng trực tiếp nào đến host
+        if (host_state == FLASH_LOG_HOST_ABSENT) {
+            flash_log_erase(next);
+        }
+        return 0;
+    }
+
+    // Generation được ghi trước: sector chỉ hợp lệ khi có FLASH_LOG_MAGIC, tức là generation đã ghi xong
+    uint32_t next_generation = generation + 1;
+    uint32_t magic = FLASH_LOG_MAGIC;
+    sectors_erased &= (uint8_t)~FLASH_LOG_BIT(next);
+    if (!Driver_Flash_Program(next, sizeof(uint32_t), &next_generation, 1) ||
+        !Driver_Flash_Program(next, 0, &magic, 1)) {
+        flash_log_stats.errors++;
+        return 0;
+    }
+
+    if (read_sector == FLASH_LOG_NO_SECTOR) {
+        read_sector = next;
+        read_offset = FLASH_LOG_SECTOR_HEADER;
+    }
+    write_sector = next;
+    write_offset = FLASH_LOG_SECTOR_HEADER;
+    generation = next_generation;
+    return 1;
+}
+
+
+/**
+ * @brief Ghi lỗi và bỏ phần còn lại của sector ghi; bản ghi đang ghi được ghi lại từ đầu ở sector kế tiếp.
+ */
+static void flash_log_abandon(void)
+{
+    flash_log_stats.errors++;
+    write_offset = FLASH_LOG_SECTOR_END;
+    record_done = 0;
+}
+
+
+/**
+ * @brief Ghi hàng đợi vào flash, tối đa FLASH_LOG_WORDS_PER_POLL word.
+ * Word đầu được ghi trước với trạng thái "đang ghi" và được ghi lại sau dữ liệu,
+ *      nên bản ghi chỉ được phát lại khi đã nằm trọn trong flash.
+ */
+static void flash_log_write(void)
+{
+    uint32_t budget = FLASH_LOG_WORDS_PER_POLL;
+
+    while (queue_used > 0 && budget > 0) {
+        uint32_t header = flash_log_queue[queue_tail];
+        uint32_t words = 1u + FLASH_LOG_WORDS(header & 0xFFFFu);
+
+        if (record_done == 0) {
+            write_waiting = !flash_log_reserve(words);
+            if (write_waiting) {
+                return;
+            }
+            if (!Driver_Flash_Program(write_sector, write_offset, &header, 1)) {
+                flash_log_abandon();
+                return;
+            }
+            record_done = 1;
+            budget--;
+        } else if (record_done < words) {
+            // Phần dữ liệu liên tục trong hàng đợi, không vượt quá điểm quay vòng
+            uint32_t index = (queue_tail + record_done) % FLASH_LOG_QUEUE_WORDS;
+            uint32_t count = words - record_done;
+            if (count > budget) {
+                count = budget;
+            }
+            if (count > FLASH_LOG_QUEUE_WORDS - index) {
+                count = FLASH_LOG_QUEUE_WORDS - index;
+            }
+            if (!Driver_Flash_Program(write_sector, write_offset + record_done * sizeof(uint32_t),
+                                      &flash_log_queue[index], (uint16_t)count)) {
+                flash_log_abandon();
+                return;
+            }
+            record_done += (uint16_t)count;
+            budget -= count;
+        } else {
+            uint32_t committed = (header & 0xFFFFu) | (FLASH_LOG_STATE_COMMITTED << 16);
+            if (!Driver_Flash_Program(write_sector, write_offset, &committed, 1)) {
+                flash_log_abandon();
+                return;
+            }
+            budget--;
+            record_done = 0;
+            write_offset += words * sizeof(uint32_t);
+            queue_tail = (uint16_t)((queue_tail + words) % FLASH_LOG_QUEUE_WORDS);
+            queue_used -= (uint16_t)words;
+            flash_log_stats.written++;
+        }
+    }
+}
+
+
+/**
+ * @brief Gửi một khung điều khiển cho host.
+ * @return 1 nếu đã gửi, 0 nếu cửa sổ của chế độ tin cậy đầy.
+ */
+static uint8_t flash_log_send(uint8_t op, uint16_t arg, uint32_t value, uint8_t priority)
+{
+    const flash_log_control_data_t msg = { FLASH_LOG_DATA_ID, op, arg, value };
+
+    if (reserve_packet(sizeof(msg), priority) == NULL) {
+        return 0;
+    }
+    append_packet((const uint8_t*)&msg, sizeof(msg));
+    commit_packet();
+    return 1;
+}
+
+
+/**
+ * @brief Phát lại tối đa FLASH_LOG_DUMP_PER_POLL bản ghi, chỉ khi bộ đệm truyền bulk còn chỗ.
+ * Mỗi bản ghi được đánh dấu đã phát lại ngay sau khi vào hàng đợi truyền, nên lần DUMP sau
+ *      (kể cả sau khi khởi động lại) tiếp tục từ đó.
+ */
+static void flash_log_dump(void)
+{
+    uint32_t header;
+
+    for (uint8_t n = 0; n < FLASH_LOG_DUMP_PER_POLL; n++) {
+        flash_log_seek();
+        if (read_sector == FLASH_LOG_NO_SECTOR ||
+            (read_sector == write_sector && read_offset == write_offset)) {
+            // Hàng đợi RAM còn bản ghi thì chờ chúng được ghi vào flash, trừ khi phải chờ xóa sector:
+            // chúng được phát lại ở lần DUMP sau
+            if ((queue_used == 0 || write_waiting) && flash_log_send(FLASH_LOG_OP_END, 0, dump_count, DRIVER_UART_PRIORITY_BULK)) {
+                dumping = 0;
+            }
+            return;
+        }
+
+        flash_log_record_size(read_sector, read_offset, &header);
+        const uint8_t* frame = (const uint8_t*)&Driver_Flash_GetSector(read_sector)[read_offset / sizeof(uint32_t) + 1];
+        int8_t result = replay_packet(frame, (uint16_t)(header & 0xFFFFu), DRIVER_UART_PRIORITY_BULK);
+        if (result == 0) {
+            return;
+        }
+        if (result > 0) {
+            flash_log_stats.dumped++;
+            dump_count++;
+        } else {
+            flash_log_stats.errors++;
+        }
+
+        uint32_t dumped = (header & 0xFFFFu) | (FLASH_LOG_STATE_DUMPED << 16);
+        if (!Driver_Flash_Program(read_sector, read_offset, &dumped, 1)) {
+            flash_log_stats.errors++;
+        }
+        read_offset += flash_log_record_size(read_sector, read_offset, &header);
+    }
+}
+
+
+/**
+ * @brief Kiểm tra một sector có trống hoàn toàn hay không.
+ */
+static uint8_t flash_log_is_blank(uint8_t sector)
+{
+    const uint32_t* base = Driver_Flash_GetSector(sector);
+
+    for (uint32_t i = 0; i < FLASH_LOG_SECTOR_END / sizeof(uint32_t); i++) {
+        if (base[i] != FLASH_LOG_ERASED) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Khôi phục con trỏ ghi và con trỏ đọc từ nội dung flash.
+ *
+ * Sector ghi là sector hợp lệ có generation lớn nhất; các sector tồn đọng là chuỗi sector
+ * 		liền trước nó có generation giảm dần từng 1. Sector hợp lệ ngoài chuỗi được xóa khi
+ * 		vòng đi đến chúng.
+ */
+void flash_log_init(void)
+{
+    uint32_t generations[DRIVER_FLASH_LOG_SECTORS];
+    uint8_t  valid = 0;
+    uint32_t header;
+
+    host_state = FLASH_LOG_HOST_UNKNOWN;
+    host_last_ms = Driver_GetTimeMs();
+    write_sector = FLASH_LOG_NO_SECTOR;
+    read_sector = FLASH_LOG_NO_SECTOR;
+    generation = 0;
+    sectors_erased = 0;
+
+    for (uint8_t sector = 0; sector < DRIVER_FLASH_LOG_SECTORS; sector++) {
+        const uint32_t* base = Driver_Flash_GetSector(sector);
+
+        if (base[0] == FLASH_LOG_MAGIC && base[1] != FLASH_LOG_ERASED) {
+            valid |= FLASH_LOG_BIT(sector);
+            generations[sector] = base[1];
+            if (write_sector == FLASH_LOG_NO_SECTOR || base[1] > generation) {
+                write_sector = sector;
+                generation = base[1];
+            }
+        } else if (flash_log_is_blank(sector)) {
+            sectors_erased |= FLASH_LOG_BIT(sector);
+        }
+    }
+
+    if (write_sector == FLASH_LOG_NO_SECTOR) {
+        return;
+    }
+
+    // Con trỏ ghi: word trống sau bản ghi cuối; word đầu vô nghĩa đóng sector lại
+    uint32_t offset = FLASH_LOG_SECTOR_HEADER;
+    uint32_t size;
+    while ((size = flash_log_record_size(write_sector, offset, &header)) > 0) {
+        offset += size;
+    }
+    write_offset = (header == FLASH_LOG_ERASED) ? offset : FLASH_LOG_SECTOR_END;
+
+    read_sector = write_sector;
+    for (uint8_t i = 1; i < DRIVER_FLASH_LOG_SECTORS; i++) {
+        uint8_t sector = (uint8_t)((write_sector + DRIVER_FLASH_LOG_SECTORS - i) % DRIVER_FLASH_LOG_SECTORS);
+        if (!(valid & FLASH_LOG_BIT(sector)) || generations[sector] != generation - i) {
+            break;
+        }
+        read_sector = sector;
+    }
+    read_offset = FLASH_LOG_SECTOR_HEADER;
+    flash_log_seek();
+}
+
+
+/**
+ * @brief Khung mới có cần được lưu hay không.
+ */
+uint8_t flash_log_is_recording(void)
+{
+    return host_state == FLASH_LOG_HOST_ABSENT;
+}
+
+
+/**
+ * @brief Chép một khung vào hàng đợi, dưới dạng bản ghi sẵn sàng để ghi vào flash.
+ * @param[in] frame  Tiêu đề và payload của khung, không có checksum.
+ * @param[in] length Độ dài.
+ */
+void flash_log_append(const uint8_t* frame, uint16_t length)
+{
+    uint32_t words = 1u + FLASH_LOG_WORDS(length);
+
+    if (frame == NULL || length == 0 || length > FLASH_LOG_RECORD_MAX ||
+        words > FLASH_LOG_QUEUE_WORDS - queue_used) {
+        flash_log_stats.dropped++;
+        return;
+    }
+
+    uint32_t data = (queue_head + 1u) % FLASH_LOG_QUEUE_WORDS;
+    flash_log_queue[queue_head] = length | (FLASH_LOG_STATE_WRITING << 16);
+    flash_log_queue[(data + words - 2u) % FLASH_LOG_QUEUE_WORDS] = FLASH_LOG_ERASED;
+
+    // Dữ liệu có thể quay vòng ở cuối hàng đợi, luôn tại ranh giới word
+    uint32_t first = (FLASH_LOG_QUEUE_WORDS - data) * sizeof(uint32_t);
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&flash_log_queue[data], frame, first);
+    memcpy(flash_log_queue, frame + first, length - first);
+
+    queue_head = (uint16_t)((queue_head + words) % FLASH_LOG_QUEUE_WORDS);
+    queue_used += (uint16_t)words;
+    flash_log_stats.appended++;
+}
+
+
+/**
+ * @brief Ghi nhận host có mặt; lần đầu sau khi vắng mặt, host được báo phần tồn đọng.
+ * @param[in] now Thời gian hiện tại (ms).
+ */
+void flash_log_host_seen(uint32_t now)
+{
+    if (host_state != FLASH_LOG_HOST_PRESENT) {
+        host_state = FLASH_LOG_HOST_PRESENT;
+        status_pending = 1;
+    }
+    host_last_ms = now;
+}
+
+
+/**
+ * @brief Xử lý khung FLASH_LOG_DATA_ID nhận từ host.
+ * @param[in] payload Payload của khung.
+ * @param[in] size    Độ dài payload.
+ * @param[in] now     Thời gian hiện tại (ms).
+ */
+void flash_log_handle(const uint8_t* payload, uint16_t size, uint32_t now)
+{
+    flash_log_control_data_t msg;
+
+    if (size < sizeof(msg)) {
+        return;
+    }
+    memcpy(&msg, payload, sizeof(msg));
+    flash_log_host_seen(now);
+
+    // PRESENT chỉ làm mới thời điểm host có mặt; DUMP lặp lại trong lúc đang phát lại được bỏ qua
+    if (msg.op == FLASH_LOG_OP_DUMP && !dumping) {
+        dumping = 1;
+        dump_count = 0;
+        status_pending = 1;
+    }
+}
+
+
+/**
+ * @brief Ghi hàng đợi vào flash, xóa trước sector kế tiếp và phát lại phần tồn đọng.
+ * @param[in] now Thời gian hiện tại (ms).
+ */
+void flash_log_poll(uint32_t now)
+{
+    if (host_state != FLASH_LOG_HOST_ABSENT && (int32_t)(now - host_last_ms) >= FLASH_LOG_HOST_TIMEOUT_MS) {
+        host_state = FLASH_LOG_HOST_ABSENT;
+        status_pending = 0;
+        dumping = 0;
+    }
+
+    if (erasing != FLASH_LOG_NO_SECTOR) {
+        uint8_t state = Driver_Flash_GetState();
+        if (state == DRIVER_FLASH_BUSY) {
+            return;
+        }
+        if (state == DRIVER_FLASH_IDLE) {
+            sectors_erased |= FLASH_LOG_BIT(erasing);
+        } else {
+            flash_log_stats.errors++;
+        }
+        erasing = FLASH_LOG_NO_SECTOR;
+    }
+
+    if (status_pending) {
+        uint32_t lost = flash_log_stats.lost;
+        flash_log_seek();
+        if (flash_log_send(FLASH_LOG_OP_STATUS, (lost > UINT16_MAX) ? UINT16_MAX : (uint16_t)lost,
+                           flash_log_backlog(), get_data_priority(FLASH_LOG_DATA_ID))) {
+            status_pending = 0;
+        }
+    }
+
+    flash_log_write();
+    if (dumping && !status_pending && erasing == FLASH_LOG_NO_SECTOR) {
+        flash_log_dump();
+    }
+
+    // Sector kế tiếp được xóa trước khi cần nếu nó không còn bản ghi chưa phát lại, chỉ khi không có host
+    if (host_state == FLASH_LOG_HOST_ABSENT && erasing == FLASH_LOG_NO_SECTOR &&
+        write_sector != FLASH_LOG_NO_SECTOR) {
+        uint8_t next = FLASH_LOG_NEXT(write_sector);
+        flash_log_seek();
+        if (!(sectors_erased & FLASH_LOG_BIT(next)) && read_sector != next) {
+            flash_log_erase(next);
+        }
+    }
+}
+
+
+/**
+ * @brief Thống kê của nhật ký kể từ khi khởi động.
+ */
+const flash_log_stats_t* flash_log_get_stats(void)
+{
+    return &flash_log_stats;
+}
+
+
+/**
+ * @brief Ghi thống kê của nhật ký thành một dòng văn bản.
+ * @param[in] buffer Bộ đệm nhận chuỗi.
+ * @param[in] size   Kích thước bộ đệm.
+ * @return Độ dài chuỗi (không kể '\0'), 0 nếu nhật ký trống và chưa từng được dùng.
+ */
+uint16_t flash_log_format_stats(char *buffer, size_t size)
+{
+    uint32_t backlog = flash_log_backlog();
+
+    if (flash_log_stats.appended == 0 && flash_log_stats.dumped == 0 && backlog == 0) {
+        return 0;
+    }
+
+    return format_line(buffer, size, "flashlog host=%u backlog=%lu appended=%lu written=%lu dropped=%lu "
+                       "dumped=%lu erases=%lu lost=%lu errors=%lu",
+                       host_state == FLASH_LOG_HOST_PRESENT, (unsigned long)backlog,
+                       (unsigned long)flash_log_stats.appended, (unsigned long)flash_log_stats.written,
+                       (unsigned long)flash_log_stats.dropped, (unsigned long)flash_log_stats.dumped,
+                       (unsigned long)flash_log_stats.erases, (unsigned long)flash_log_stats.lost,
+                       (unsigned long)flash_log_stats.errors);
+}
+
+#endif /* FLASH_LOG_ENABLED */
@@ -0,0 +1,304 @@
+/*
+ * Link.c
+ *
+ *  Created on: May 02, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Link.h"
+#include "Command.h"
+#include "Driver.h"
+#include "FlashLog.h"
+#include "Protocol.h"
+#include "Reliable.h"
+#include "Utils.h"
+#include <string.h>
+
+
+/** @brief Kích thước phần đầu của khung nhận: tiêu đề, timestamp và payload_size. */
+#define LINK_RX_HEADER_SIZE (sizeof(uint16_t) * 3)
+
+#define LINK_RX_FRAME_MAX (LINK_RX_HEADER_SIZE + LINK_RX_PAYLOAD_MAX + sizeof(uint16_t))
+
+
+typedef enum {
+    LINK_STATE_IDLE  = 0,                        /**< Tốc độ hiện tại đã được xác nhận. */
+    LINK_STATE_TRIAL = 1,                        /**< Đã chuyển tốc độ, đang chờ COMMIT. */
+} link_state_t;
+
+
+// Khung đang nhận dở: luôn bắt đầu bằng HEADER_BYTE1 hoặc rỗng
+static uint8_t  rx_frame[LINK_RX_FRAME_MAX];
+static uint16_t rx_length = 0;
+static uint32_t rx_crc_errors = 0;
+
+static link_state_t link_state = LINK_STATE_IDLE;
+static uint32_t link_previous_baud = DRIVER_UART_BAUD_DEFAULT;
+static uint32_t link_trial_start_ms = 0;
+static uint32_t link_last_rx_ms = 0;            // Lần cuối nhận được khung hợp lệ
+static uint32_t link_uart_errors = 0;           // Driver_UART_GetRxErrors() lần kiểm tra trước
+static uint8_t  link_error_run = 0;             // Số lỗi nhận liên tiếp kể từ khung hợp lệ cuối
+static uint8_t  link_strikes = 0;               // Số KEEPALIVE báo lỗi CRC liên tiếp
+
+
+/**
+ * @brief Gửi một khung điều khiển, có thể kèm mẫu thử.
+ * @param[in] op           Thao tác (link_op_t).
+ * @param[in] baud         Tốc độ baud liên quan.
+ * @param[in] arg          Tham số phụ của thao tác.
+ * @param[in] probe_length Số byte mẫu thử nối sau khung, 0 nếu không có.
+ * @return 1 nếu khung đã được đưa vào hàng đợi truyền, 0 nếu không giữ chỗ được.
+ */
+static uint8_t link_send(uint8_t op, uint32_t baud, uint16_t arg, uint16_t probe_length)
+{
+    const link_control_data_t msg = { LINK_DATA_ID, op, baud, arg };
+    uint8_t chunk[32];
+
+    if (reserve_packet(sizeof(msg) + probe_length, get_data_priority(LINK_DATA_ID)) == NULL) {
+        return 0;
+    }
+
+    append_packet((const uint8_t*)&msg, sizeof(msg));
+    for (uint16_t i = 0; i < probe_length; i++) {
+        chunk[i % sizeof(chunk)] = LINK_PROBE_BYTE(i);
+        if ((i + 1) % sizeof(chunk) == 0 || i + 1 == probe_length) {
+            append_packet(chunk, (uint16_t)(i % sizeof(chunk) + 1));
+        }
+    }
+    commit_packet();
+    return 1;
+}
+
+
+/**
+ * @brief Quay về một tốc độ đã biết và báo lý do cho host.
+ * @param[in] baud   Tốc độ quay về.
+ * @param[in] reason Lý do (link_reason_t).
+ */
+static void link_fallback(uint32_t baud, uint8_t reason)
+{
+    Driver_UART_SetBaud(baud);
+
+    link_state = LINK_STATE_IDLE;
+    link_strikes = 0;
+    link_error_run = 0;
+    link_uart_errors = Driver_UART_GetRxErrors();
+    link_last_rx_ms = Driver_GetTimeMs();
+
+    link_send(LINK_OP_STATUS, Driver_UART_GetBaud(), reason, 0);
+}
+
+
+/**
+ * @brief Xử lý đề xuất tốc độ của host.
+ * ACCEPT được truyền hết ở tốc độ cũ trước khi đổi (Driver_UART_SetBaud() chờ hàng đợi rỗng).
+ * Nếu ACCEPT không được đưa vào hàng đợi, thiết bị giữ tốc độ cũ; host không nhận được
+ *      trả lời nên cũng không đổi tốc độ và có thể đề xuất lại.
+ * @param[in] baud Tốc độ được đề xuất.
+ * @return 1 nếu đã chuyển sang tốc độ thử, 0 nếu từ chối hoặc không gửi được ACCEPT.
+ */
+static uint8_t link_propose(uint32_t baud)
+{
+    uint8_t oversampling;
+
+    if (link_state != LINK_STATE_IDLE || Driver_UART_CheckBaud(baud, &oversampling) == 0) {
+        link_send(LINK_OP_REJECT, baud, 0, 0);
+        return 0;
+    }
+
+    if (link_send(LINK_OP_ACCEPT, baud, oversampling, 0) == 0) {
+        return 0;
+    }
+    link_previous_baud = Driver_UART_GetBaud();
+    Driver_UART_SetBaud(baud);
+
+    link_state = LINK_STATE_TRIAL;
+    link_trial_start_ms = Driver_GetTimeMs();
+    link_uart_errors = Driver_UART_GetRxErrors();
+    return 1;
+}
+
+
+/**
+ * @brief Xử lý một khung hợp lệ nhận từ host: điều khiển liên kết, lệnh (Command.c)
+ *      hoặc chế độ truyền tin cậy (Reliable.c).
+ * @param[in] payload Payload của khung.
+ * @param[in] size    Độ dài payload.
+ * @param[in] now     Thời gian hiện tại (ms).
+ */
+static void link_handle(const uint8_t* payload, uint16_t size, uint32_t now)
+{
+    link_control_data_t msg;
+
+    link_last_rx_ms = now;
+    link_error_run = 0;
+#if FLASH_LOG_ENABLED
+    flash_log_host_seen(now);
+    if (size > 0 && payload[0] == FLASH_LOG_DATA_ID) {
+        flash_log_handle(payload, size, now);
+        return;
+    }
+#endif
+
+    if (size > 0 && payload[0] == COMMAND_DATA_ID) {
+        command_handle(payload, size, now);
+        return;
+    }
+    if (size > 0 && payload[0] == RELIABLE_DATA_ID) {
+        reliable_handle(payload, size, now);
+        return;
+    }
+    if (size < sizeof(msg) || payload[0] != LINK_DATA_ID) {
+        return;
+    }
+    memcpy(&msg, payload, sizeof(msg));
+
+    switch (msg.op) {
+    case LINK_OP_PROPOSE:
+        link_propose(msg.baud);
+        break;
+
+    case LINK_OP_PROBE:
+        if (msg.baud == Driver_UART_GetBaud()) {
+            link_send(LINK_OP_PROBE_ACK, msg.baud, 0, LINK_PROBE_SIZE);
+        }
+        break;
+
+    case LINK_OP_COMMIT:
+        // COMMIT lặp lại (do COMMIT_ACK bị mất) vẫn được trả lời
+        if (msg.baud == Driver_UART_GetBaud()) {
+            link_state = LINK_STATE_IDLE;
+            link_strikes = 0;
+            link_send(LINK_OP_COMMIT_ACK, msg.baud, 0, 0);
+        }
+        break;
+
+    case LINK_OP_KEEPALIVE:
+        link_strikes = (msg.arg >= LINK_FALLBACK_ERROR_PERMILLE) ? link_strikes + 1 : 0;
+        if (link_strikes >= LINK_FALLBACK_STRIKES && Driver_UART_GetBaud() != DRIVER_UART_BAUD_DEFAULT) {
+            link_fallback(DRIVER_UART_BAUD_DEFAULT, LINK_REASON_CRC_ERRORS);
+        } else {
+            link_send(LINK_OP_STATUS, Driver_UART_GetBaud(), LINK_REASON_NONE, 0);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+/**
+ * @brief Bỏ n byte đầu của khung đang nhận và tìm tiêu đề kế tiếp trong phần còn lại.
+ */
+static void link_rx_drop(uint16_t n)
+{
+    rx_length -= n;
+    memmove(rx_frame, rx_frame + n, rx_length);
+}
+
+
+/**
+ * @brief Đưa một byte nhận được vào bộ giải mã khung DE AB.
+ * Khi tiêu đề, độ dài hoặc CRC sai, chỉ một byte bị bỏ để khung thật nằm ngay sau
+ *      một tiêu đề giả không bị mất.
+ */
+static void link_rx_byte(uint8_t byte, uint32_t now)
+{
+    rx_frame[rx_length++] = byte;
+
+    while (rx_length > 0) {
+        uint16_t payload_size = (rx_length >= LINK_RX_HEADER_SIZE) ?
+                                (uint16_t)(rx_frame[4] | (rx_frame[5] << 8)) : 0;
+
+        if (rx_frame[0] != HEADER_BYTE1 ||
+            (rx_length >= 2 && rx_frame[1] != HEADER_BYTE2) ||
+            payload_size > LINK_RX_PAYLOAD_MAX) {
+            link_rx_drop(1);
+            continue;
+        }
+
+        uint16_t crc_length = LINK_RX_HEADER_SIZE + payload_size;
+        if (rx_length < LINK_RX_HEADER_SIZE || rx_length < crc_length + sizeof(uint16_t)) {
+            return;
+        }
+
+        uint16_t checksum = (uint16_t)(rx_frame[crc_length] | (rx_frame[crc_length + 1] << 8));
+        if (checksum == calculate_crc16(rx_frame, crc_length)) {
+            rx_length = 0;
+            link_handle(rx_frame + LINK_RX_HEADER_SIZE, payload_size, now);
+            return;
+        }
+
+        rx_crc_errors++;
+        if (link_error_run < UINT8_MAX) {
+            link_error_run++;
+        }
+        link_rx_drop(1);
+    }
+}
+
+
+/**
+ * @brief Khởi tạo liên kết ở tốc độ hiện tại của USART2 và bắt đầu nhận.
+ */
+void link_init(void)
+{
+    rx_length = 0;
+    link_state = LINK_STATE_IDLE;
+    link_last_rx_ms = Driver_GetTimeMs();
+    link_uart_errors = Driver_UART_GetRxErrors();
+
+    Driver_UART_RxStart();
+}
+
+
+/**
+ * @brief Xử lý các khung đã nhận và các mốc thời gian của liên kết.
+ * @param[in] now Thời gian hiện tại (ms).
+ */
+void link_poll(uint32_t now)
+{
+    uint8_t chunk[32];
+    size_t length;
+
+    while ((length = Driver_UART_Read(chunk, sizeof(chunk))) > 0) {
+        for (size_t i = 0; i < length; i++) {
+            link_rx_byte(chunk[i], now);
+        }
+    }
+
+    uint32_t uart_errors = Driver_UART_GetRxErrors();
+    if (uart_errors != link_uart_errors) {
+        uint32_t run = link_error_run + (uart_errors - link_uart_errors);
+        link_error_run = (run > UINT8_MAX) ? UINT8_MAX : (uint8_t)run;
+        link_uart_errors = uart_errors;
+    }
+
+    // Các mốc có thể được đặt sau now (trong lúc đổi baud), nên so sánh có dấu
+    if (link_state == LINK_STATE_TRIAL) {
+        if ((int32_t)(now - link_trial_start_ms) >= LINK_TRIAL_TIMEOUT_MS) {
+            link_fallback(link_previous_baud, LINK_REASON_TRIAL_TIMEOUT);
+        }
+        return;
+    }
+
+    if (Driver_UART_GetBaud() == DRIVER_UART_BAUD_DEFAULT) {
+        return;
+    }
+
+    if ((int32_t)(now - link_last_rx_ms) >= LINK_KEEPALIVE_TIMEOUT_MS) {
+        link_fallback(DRIVER_UART_BAUD_DEFAULT, LINK_REASON_KEEPALIVE_TIMEOUT);
+    } else if (link_error_run >= LINK_FALLBACK_RX_ERRORS) {
+        link_fallback(DRIVER_UART_BAUD_DEFAULT, LINK_REASON_RX_ERRORS);
+    }
+}
+
+
+/**
+ * @brief Số khung nhận được từ host sai CRC kể từ khi khởi động.
+ */
+uint32_t link_get_rx_crc_errors(void)
+{
+    return rx_crc_errors;
+}
@@ -0,0 +1,203 @@
+/*
+ * Pool.c
+ *
+ *  Created on: Apr 16, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Pool.h"
+#include "Utils.h"
+
+
+#if (POOL_SMALL_BLOCK_SIZE % 4) || (POOL_MEDIUM_BLOCK_SIZE % 4) || (POOL_JUMBO_BLOCK_SIZE % 4)
+#error "Kích thước khối của pool phải là bội số của 4"
+#endif
+
+#define POOL_WORDS(size, count) (((size) / 4) * (count))
+
+// Vùng nhớ khai báo kiểu uint32_t để mọi khối đều căn 4 byte; lớp không có khối thì không có vùng nhớ
+#if POOL_SMALL_BLOCK_COUNT > 0
+static uint32_t pool_small[POOL_WORDS(POOL_SMALL_BLOCK_SIZE, POOL_SMALL_BLOCK_COUNT)];
+#define POOL_SMALL_BASE ((uint8_t*)pool_small)
+#else
+#define POOL_SMALL_BASE NULL
+#endif
+
+#if POOL_MEDIUM_BLOCK_COUNT > 0
+static uint32_t pool_medium[POOL_WORDS(POOL_MEDIUM_BLOCK_SIZE, POOL_MEDIUM_BLOCK_COUNT)];
+#define POOL_MEDIUM_BASE ((uint8_t*)pool_medium)
+#else
+#define POOL_MEDIUM_BASE NULL
+#endif
+
+#if POOL_JUMBO_BLOCK_COUNT > 0
+static uint32_t pool_jumbo[POOL_WORDS(POOL_JUMBO_BLOCK_SIZE, POOL_JUMBO_BLOCK_COUNT)];
+#define POOL_JUMBO_BASE ((uint8_t*)pool_jumbo)
+#else
+#define POOL_JUMBO_BASE NULL
+#endif
+
+typedef struct {
+    uint8_t*     base;
+    void*        free_list;                      // Khối rỗi đầu tiên, 4 byte đầu mỗi khối rỗi trỏ đến khối kế
+    pool_stats_t stats;
+} pool_class_state_t;
+
+static pool_class_state_t pool_classes[POOL_CLASS_COUNT] = {
+    [POOL_CLASS_SMALL]  = { POOL_SMALL_BASE,  NULL, { POOL_SMALL_BLOCK_SIZE,  POOL_SMALL_BLOCK_COUNT,  0, 0, 0, 0 } },
+    [POOL_CLASS_MEDIUM] = { POOL_MEDIUM_BASE, NULL, { POOL_MEDIUM_BLOCK_SIZE, POOL_MEDIUM_BLOCK_COUNT, 0, 0, 0, 0 } },
+    [POOL_CLASS_JUMBO]  = { POOL_JUMBO_BASE,  NULL, { POOL_JUMBO_BLOCK_SIZE,  POOL_JUMBO_BLOCK_COUNT,  0, 0, 0, 0 } },
+};
+
+static uint8_t pool_ready = 0;
+
+
+/**
+ * @brief Khởi tạo pool, mọi khối trở về trạng thái rỗi.
+ */
+void pool_init(void)
+{
+    for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+        pool_class_state_t *pc = &pool_classes[c];
+        uint16_t size = pc->stats.block_size;
+
+        pc->free_list = NULL;
+        for (uint16_t i = pc->stats.block_count; i > 0; i--) {
+            void **block = (void**)&pc->base[(uint32_t)(i - 1) * size];
+            *block = pc->free_list;
+            pc->free_list = block;
+        }
+
+        pc->stats.in_use = 0;
+        pc->stats.high_watermark = 0;
+        pc->stats.allocs = 0;
+        pc->stats.failures = 0;
+    }
+
+    pool_ready = 1;
+}
+
+
+/**
+ * @brief Cấp phát một khối đủ chứa size byte.
+ * @param[in] size Số byte cần dùng.
+ * @return Con trỏ đến khối (căn 4 byte), NULL nếu không còn khối phù hợp.
+ */
+void* pool_alloc(size_t size)
+{
+    if (!pool_ready) {
+        pool_init();
+    }
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+        pool_class_state_t *pc = &pool_classes[c];
+
+        if (size > pc->stats.block_size || pc->stats.block_count == 0) {
+            continue;
+        }
+
+        void **block = (void**)pc->free_list;
+        if (block == NULL) {
+            pc->stats.failures++;
+            continue;
+        }
+
+        pc->free_list = *block;
+        pc->stats.allocs++;
+        pc->stats.in_use++;
+        if (pc->stats.in_use > pc->stats.high_watermark) {
+            pc->stats.high_watermark = pc->stats.in_use;
+        }
+        return block;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Trả một khối về pool.
+ * @param[in] block Con trỏ trả về bởi pool_alloc(), NULL được bỏ qua.
+ */
+void pool_release(void* block)
+{
+    if (block == NULL) {
+        return;
+    }
+
+    for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+        pool_class_state_t *pc = &pool_classes[c];
+        uint32_t span = (uint32_t)pc->stats.block_size * pc->stats.block_count;
+
+        if (span == 0 || (uint8_t*)block < pc->base || (uint8_t*)block >= pc->base + span) {
+            continue;
+        }
+
+        // Con trỏ không trỏ đúng đầu khối thì bỏ qua thay vì làm hỏng danh sách rỗi
+        if (((uint8_t*)block - pc->base) % pc->stats.block_size != 0 || pc->stats.in_use == 0) {
+            return;
+        }
+
+        *(void**)block = pc->free_list;
+        pc->free_list = block;
+        pc->stats.in_use--;
+        return;
+    }
+}
+
+
+/**
+ * @brief Kích thước khối lớn nhất mà pool có thể cấp phát.
+ * @return Số byte, 0 nếu pool không có khối nào.
+ */
+size_t pool_block_max(void)
+{
+    for (uint8_t c = POOL_CLASS_COUNT; c > 0; c--) {
+        if (pool_classes[c - 1].stats.block_count != 0) {
+            return pool_classes[c - 1].stats.block_size;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Lấy thống kê của một lớp kích thước.
+ * @param[in] pool_class Lớp kích thước (pool_class_t).
+ * @return Con trỏ đến thống kê, NULL nếu lớp không hợp lệ.
+ */
+const pool_stats_t* pool_get_stats(uint8_t pool_class)
+{
+    if (pool_class >= POOL_CLASS_COUNT) {
+        return NULL;
+    }
+
+    return &pool_classes[pool_class].stats;
+}
+
+
+/**
+ * @brief Định dạng thống kê của một lớp thành một dòng chữ.
+ * @param[in]  pool_class Lớp kích thước (pool_class_t).
+ * @param[out] buffer     Bộ đệm nhận chuỗi.
+ * @param[in]  size       Kích thước bộ đệm.
+ * @return Độ dài chuỗi, 0 nếu lớp không hợp lệ hoặc không có khối.
+ */
+uint16_t pool_format_stats(uint8_t pool_class, char *buffer, size_t size)
+{
+    if (pool_class >= POOL_CLASS_COUNT || pool_classes[pool_class].stats.block_count == 0) {
+        return 0;
+    }
+
+    const pool_stats_t *stats = &pool_classes[pool_class].stats;
+
+    return format_line(buffer, size, "pool class=%u block=%u count=%u used=%u high=%u allocs=%lu fail=%lu",
+                       pool_class, stats->block_size, stats->block_count,
+                       stats->in_use, stats->high_watermark,
+                       (unsigned long)stats->allocs, (unsigned long)stats->failures);
+}
@@ -0,0 +1,158 @@
+/*
+ * Profiler.c
+ *
+ *  Created on: Apr 21, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+#include "Application.h"
+#include "Protocol.h"
+#include "Utils.h"
+#include "stm32f4xx_hal.h"
+#include <string.h>
+
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  probe;                              /**< Điểm đo (profiler_probe_t). */
+    uint32_t count;                              /**< Số lần đo trong chu kỳ báo cáo. */
+    uint32_t min;                                /**< Số chu kỳ nhỏ nhất. */
+    uint32_t max;                                /**< Số chu kỳ lớn nhất. */
+    uint32_t mean;                               /**< Số chu kỳ trung bình. */
+    uint16_t histogram[PROFILER_HISTOGRAM_BINS]; /**< Phân bố theo log2 số chu kỳ. */
+} profiler_record_t;
+#pragma pack(pop)
+
+
+/** @brief Phần đầu của khung báo cáo: [data_id][số điểm đo][tần số lõi MHz]. */
+#define PROFILER_REPORT_HEADER 3
+
+
+static profiler_stats_t probe_stats[PROFILER_PROBE_COUNT];
+
+// Số chu kỳ của một cặp PROFILE_BEGIN/PROFILE_END rỗng, được trừ khỏi mỗi lần đo
+static uint32_t probe_overhead = 0;
+
+
+static void stats_reset(profiler_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min = UINT32_MAX;
+}
+
+
+/**
+ * @brief Khởi tạo bộ đo: bật bộ đếm chu kỳ, đo chi phí của chính cặp macro và xóa thống kê.
+ */
+void profiler_init(void)
+{
+    Driver_CycleCounterInit();
+
+    uint32_t start = Driver_GetCycles();
+    probe_overhead = Driver_GetCycles() - start;
+
+    for (uint8_t p = 0; p < PROFILER_PROBE_COUNT; p++) {
+        stats_reset(&probe_stats[p]);
+    }
+}
+
+
+/**
+ * @brief Ghi một lần đo vào điểm đo.
+ * Được gọi từ cả main context lẫn ngắt; mỗi điểm đo chỉ được ghi từ một mức ngắt.
+ * @param[in] probe  Điểm đo (profiler_probe_t).
+ * @param[in] cycles Số chu kỳ đo được, chưa trừ chi phí đo.
+ */
+void profiler_record(uint8_t probe, uint32_t cycles)
+{
+    if (probe >= PROFILER_PROBE_COUNT) {
+        return;
+    }
+
+    profiler_stats_t *stats = &probe_stats[probe];
+    cycles = (cycles > probe_overhead) ? cycles - probe_overhead : 0;
+
+    stats->count++;
+    stats->sum += cycles;
+    if (cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+
+    uint8_t bin = (cycles == 0) ? 0 : (uint8_t)(31 - __builtin_clz(cycles));
+    if (bin >= PROFILER_HISTOGRAM_BINS) {
+        bin = PROFILER_HISTOGRAM_BINS - 1;
+    }
+    if (stats->histogram[bin] != UINT16_MAX) {
+        stats->histogram[bin]++;
+    }
+}
+
+
+/**
+ * @brief Lấy thống kê của một điểm đo.
+ * @param[in] probe Điểm đo (profiler_probe_t).
+ * @return    Con trỏ đến thống kê, NULL nếu điểm đo không hợp lệ.
+ */
+const profiler_stats_t* profiler_get_stats(uint8_t probe)
+{
+    if (probe >= PROFILER_PROBE_COUNT) {
+        return NULL;
+    }
+
+    return &probe_stats[probe];
+}
+
+
+/**
+ * @brief Gửi thống kê của mọi điểm đo trong một khung PROFILER_DATA_ID rồi xóa chúng.
+ *
+ * Thống kê được chụp lại và xóa trong vùng tắt ngắt để không mất lần đo nào của
+ * 		ngắt; việc phát khung nằm ngoài vùng đó và được tính vào báo cáo sau.
+ */
+void profiler_send_report(void)
+{
+    profiler_stats_t snapshot[PROFILER_PROBE_COUNT];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(snapshot, probe_stats, sizeof(snapshot));
+    for (uint8_t p = 0; p < PROFILER_PROBE_COUNT; p++) {
+        stats_reset(&probe_stats[p]);
+    }
+    __set_PRIMASK(primask);
+
+    uint16_t length = PROFILER_REPORT_HEADER + PROFILER_PROBE_COUNT * sizeof(profiler_record_t);
+    if (reserve_packet(length, get_data_priority(PROFILER_DATA_ID)) == NULL) {
+        return;
+    }
+
+    const uint8_t header[PROFILER_REPORT_HEADER] = {
+        PROFILER_DATA_ID, PROFILER_PROBE_COUNT, (uint8_t)(SystemCoreClock / 1000000u)
+    };
+    append_packet(header, sizeof(header));
+
+    for (uint8_t p = 0; p < PROFILER_PROBE_COUNT; p++) {
+        const profiler_stats_t *stats = &snapshot[p];
+        profiler_record_t record;
+
+        record.probe = p;
+        record.count = stats->count;
+        record.min   = stats->count ? stats->min : 0;
+        record.max   = stats->max;
+        record.mean  = stats->count ? (uint32_t)(stats->sum / stats->count) : 0;
+        memcpy(record.histogram, stats->histogram, sizeof(record.histogram));
+
+        append_packet((const uint8_t*)&record, sizeof(record));
+    }
+
+    commit_packet();
+}
+
+#endif /* PROFILER_ENABLED */
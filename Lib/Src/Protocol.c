@@ -7,30 +7,59 @@
 
 #include "Protocol.h"
 #include <string.h>
+#include "Cobs.h"
+#include "Crc16.h"
 #include "Driver.h"
+#include "FlashLog.h"
+#include "Profiler.h"
+#include "Reliable.h"
 #include "Utils.h"
 
 
+// CRC được tính trong một lượt ở commit_packet() thay vì tăng dần khi ghi khung
+#define PROTOCOL_CRC_DEFERRED (PROTOCOL_CRC32_HW || PROTOCOL_COBS)
+
+
+// Khung đang được giữ chỗ trong bộ đệm truyền (reserve_packet/commit_packet)
+static uint8_t* reserved_region = NULL;         // Vùng trả về bởi Driver_UART_Reserve()
+static uint8_t* reserved_frame = NULL;          // Khung chưa mã hóa, ở cuối vùng khi PROTOCOL_COBS
+static uint8_t  reserved_flags = 0;
+static uint8_t  reserved_priority = 0;
+static uint16_t reserved_header_size = 0;
+static uint16_t reserved_payload_length = 0;
+static uint16_t reserved_cursor = 0;            // Số byte payload đã ghi qua append_packet()
+static crc16_ctx_t reserved_crc;                // CRC của tiêu đề và phần payload đã append
+
+
+/**
+ * @brief Ghi một giá trị 16 bit theo thứ tự little-endian vào vị trí bất kỳ.
+ */
+static void put_u16(uint8_t* dst, uint16_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+
 /**
  * @brief Tính toán giá trị CRC16 cho một mảng dữ liệu.
  * Hàm này sử dụng thuật toán CRC16 để tính toán giá trị kiểm tra
  * 				cho một mảng dữ liệu đầu vào.
+ * Engine tính toán được chọn bởi CRC16_ENGINE trong Crc16.h.
  * @param[in] data   Con trỏ đến mảng dữ liệu cần tính CRC.
  * @param[in] length Độ dài của mảng dữ liệu.
  * @return    Giá trị CRC16 của dữ liệu.
  */
 uint16_t calculate_crc16(uint8_t *data, uint16_t length)
 {
-    uint16_t crc = 0xFFFF;
-    for (uint16_t i = 0; i < length; i++) {
-        crc ^= data[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 1)
-                crc = (crc >> 1) ^ 0xA001;
-            else
-                crc >>= 1;
-        }
-    }
+    PROFILE_BEGIN(PROFILER_PROBE_CRC16);
+    crc16_ctx_t ctx;
+
+    crc16_init(&ctx);
+    crc16_update(&ctx, data, length);
+    uint16_t crc = crc16_final(&ctx);
+    PROFILE_END(PROFILER_PROBE_CRC16);
+
     return crc;
 }
 
@@ -50,17 +79,24 @@ void pack_packet(packet_t *packet, uint8_t *payload, uint16_t payload_length)
         return;
     }
 
+    PROFILE_BEGIN(PROFILER_PROBE_PACK_PACKET);
+    crc16_ctx_t crc;
+    crc16_init(&crc);
+
+    // Mỗi trường được đưa vào CRC ngay khi được tạo ra
     packet->header = ((uint16_t)HEADER_BYTE2 << 8) | HEADER_BYTE1;
+    crc16_update(&crc, &packet->header, sizeof(packet->header));
 
     packet->timestamp = (uint16_t)Driver_GetTimeMs();
+    crc16_update(&crc, &packet->timestamp, sizeof(packet->timestamp));
 
     packet->payload_size = payload_length;
+    crc16_update(&crc, &packet->payload_size, sizeof(packet->payload_size));
 
-    memcpy(packet->payload, payload, payload_length);
-
-    uint16_t crc_length = sizeof(packet->header) + sizeof(packet->timestamp) + sizeof(packet->payload_size) + payload_length;
-
-    packet->checksum = calculate_crc16((uint8_t*)packet, crc_length);
+    // Payload được chép và tính CRC trong cùng một lượt
+    crc16_update_copy(&crc, packet->payload, payload, payload_length);
+    packet->checksum = crc16_final(&crc);
+    PROFILE_END(PROFILER_PROBE_PACK_PACKET);
 }
 
 /**
@@ -76,21 +112,286 @@ void send_packet(packet_t *packet)
         return;
     }
 
+    PROFILE_BEGIN(PROFILER_PROBE_SEND_PACKET);
     uint16_t overhead_size = sizeof(packet->header) +
                              sizeof(packet->timestamp) +
                              sizeof(packet->payload_size);
 
-    Driver_UART_Send((uint8_t*)packet, overhead_size);
+#if FLASH_LOG_ENABLED
+    // Tiêu đề và payload của packet_t nằm liền nhau
+    if (flash_log_is_recording()) {
+        flash_log_append((const uint8_t*)packet, overhead_size + packet->payload_size);
+    }
+#endif
 
-    Driver_UART_Send(packet->payload, packet->payload_size);
+    // Header, payload và checksum được phát trong một lần truyền duy nhất
+    const driver_uart_segment_t segments[] = {
+        { (uint8_t*)packet,              overhead_size },
+        { packet->payload,               packet->payload_size },
+        { (uint8_t*)&(packet->checksum), sizeof(packet->checksum) },
+    };
 
-    Driver_UART_Send((uint8_t*)&(packet->checksum), sizeof(packet->checksum));
+#if PROTOCOL_COBS
+    // Các đoạn được mã hóa thẳng vào bộ đệm truyền, checksum đã có sẵn trong gói tin
+    uint16_t length = overhead_size + packet->payload_size + sizeof(packet->checksum);
+    uint8_t* region = Driver_UART_Reserve(COBS_ENCODED_MAX(length), DRIVER_UART_PRIORITY_BULK);
+    if (region != NULL) {
+        cobs_encoder_t cobs;
+        cobs_encode_begin(&cobs, region);
+        for (size_t i = 0; i < sizeof(segments) / sizeof(segments[0]); i++) {
+            cobs_encode_update(&cobs, segments[i].data, segments[i].size, NULL);
+        }
+        Driver_UART_Commit(region, cobs_encode_end(&cobs));
+    }
+#else
+    Driver_UART_SendV(segments, sizeof(segments) / sizeof(segments[0]));
+#endif
+    PROFILE_END(PROFILER_PROBE_SEND_PACKET);
 }
 
 
+/**
+ * @brief Giữ chỗ một khung với các cờ và timestamp cho trước.
+ * @param[in] payload_length Độ dài payload, không vượt quá MAX_PAYLOAD_SIZE.
+ * @param[in] priority       Mức ưu tiên truyền của khung.
+ * @param[in] flags          Cờ khung mở rộng, FRAME_FLAG_SEQ được thêm khi chế độ tin cậy đang bật.
+ * @param[in] timestamp      Timestamp, 32 bit với FRAME_FLAG_TS32, ngược lại 16 bit thấp.
+ * @param[in] wait           0: trả về NULL thay vì chờ khi bộ đệm truyền chưa đủ chỗ.
+ * @return    Con trỏ đến vùng payload, NULL nếu không giữ chỗ được.
+ */
+static uint8_t* reserve_frame(uint16_t payload_length, uint8_t priority, uint8_t flags,
+                              uint32_t timestamp, uint8_t wait)
+{
+    uint16_t seq = 0;
 
+    if (payload_length == 0 || payload_length > MAX_PAYLOAD_SIZE) {
+        return NULL;
+    }
+
+    if (reliable_is_enabled()) {
+        flags |= FRAME_FLAG_SEQ;
+    }
+    uint16_t header_size = FRAME_HEADER_SIZE_OF(flags);
+    uint16_t frame_length = header_size + payload_length + FRAME_CHECKSUM_SIZE;
+#if PROTOCOL_COBS
+    uint16_t region_length = COBS_ENCODED_MAX(frame_length);
+#else
+    uint16_t region_length = frame_length;
+#endif
+
+    if (!wait && Driver_UART_GetTxSpace(priority) < region_length) {
+        return NULL;
+    }
+
+#if RELIABLE_ENABLED
+    // Cửa sổ được kiểm tra trước vì một vùng đã giữ chỗ trong bộ đệm truyền phải được commit
+    if ((flags & FRAME_FLAG_SEQ) && reliable_reserve(region_length, &seq) == 0) {
+        return NULL;
+    }
+#endif
+
+    reserved_region = Driver_UART_Reserve(region_length, priority);
+    if (reserved_region == NULL) {
+        return NULL;
+    }
+    // Khung được dựng ở cuối vùng để commit_packet() mã hóa COBS tiến tại chỗ
+    reserved_frame = reserved_region + (region_length - frame_length);
+
+    // Tiêu đề đã biết ngay từ lúc giữ chỗ nên được ghi và đưa vào CRC trước
+    uint8_t* field = reserved_frame;
+    *field++ = HEADER_BYTE1;
+    if (flags) {
+        *field++ = HEADER_BYTE2_EXT;
+        *field++ = flags;
+    } else {
+        *field++ = HEADER_BYTE2;
+    }
+    put_u16(field, (uint16_t)timestamp);
+    field += sizeof(uint16_t);
+    if (flags & FRAME_FLAG_TS32) {
+        put_u16(field, (uint16_t)(timestamp >> 16));
+        field += sizeof(uint16_t);
+    }
+    if (flags & FRAME_FLAG_SEQ) {
+        put_u16(field, seq);
+        field += sizeof(uint16_t);
+    }
+    put_u16(field, payload_length);
 
+    reserved_flags = flags;
+    reserved_priority = priority;
+    reserved_header_size = header_size;
+    reserved_payload_length = payload_length;
+    reserved_cursor = 0;
+    crc16_init(&reserved_crc);
+#if !PROTOCOL_CRC_DEFERRED
+    crc16_update(&reserved_crc, reserved_frame, header_size);
+#endif
+    return reserved_frame + header_size;
+}
 
 
+/**
+ * @brief Giữ chỗ một khung trong bộ đệm truyền và trả về vùng payload của nó.
+ *
+ * Người gọi ghi trực tiếp payload vào vùng này rồi gọi commit_packet(),
+ * 		không cần dựng struct tạm hay packet_t trung gian.
+ *
+ * @param[in] payload_length Độ dài payload, không vượt quá MAX_PAYLOAD_SIZE.
+ * @param[in] priority       Mức ưu tiên truyền (driver_uart_priority_t) của khung.
+ * @return    Con trỏ đến vùng payload, NULL nếu độ dài không hợp lệ, bộ đệm truyền đầy
+ *            hoặc cửa sổ của chế độ tin cậy đầy.
+ */
+uint8_t* reserve_packet(uint16_t payload_length, uint8_t priority)
+{
+#if DRIVER_TIMESTAMP_US
+    uint32_t timestamp = Driver_GetTimeUs();
+#else
+    uint32_t timestamp = Driver_GetTimeMs();
+#endif
 
+    return reserve_frame(payload_length, priority, PROTOCOL_FRAME_FLAGS, timestamp, 1);
+}
 
+
+/**
+ * @brief Chép dữ liệu nối tiếp vào payload của khung đang giữ chỗ.
+ *
+ * Dữ liệu được chép thẳng từ bộ đệm của người gọi vào bộ đệm truyền và được
+ * 		đưa vào CRC trong cùng lượt, nên commit_packet() không phải đọc lại nó.
+ *
+ * @param[in] data   Dữ liệu cần ghi.
+ * @param[in] length Số byte, phần vượt quá payload đã giữ chỗ bị cắt bỏ.
+ */
+void append_packet(const uint8_t* data, uint16_t length)
+{
+    if (reserved_frame == NULL || data == NULL) {
+        return;
+    }
+
+    if (length > reserved_payload_length - reserved_cursor) {
+        length = reserved_payload_length - reserved_cursor;
+    }
+
+#if PROTOCOL_CRC_DEFERRED
+    memcpy(reserved_frame + reserved_header_size + reserved_cursor, data, length);
+#else
+    crc16_update_copy(&reserved_crc, reserved_frame + reserved_header_size + reserved_cursor, data, length);
+#endif
+    reserved_cursor += length;
+}
+
+
+/**
+ * @brief Hoàn tất khung đã giữ chỗ bởi reserve_packet() và phát nó đi.
+ *
+ * Checksum được điền ngay sau payload trong bộ đệm truyền nên payload không bị
+ * 		sao chép thêm lần nào; CRC chỉ còn phải đọc phần payload ghi trực tiếp
+ * 		(phần sau dữ liệu đã append_packet()).
+ * Với PROTOCOL_COBS, CRC16 và mã hóa COBS được làm trong cùng một lượt qua khung,
+ * 		ghi tiến từ đầu vùng giữ chỗ.
+ */
+void commit_packet(void)
+{
+    if (reserved_frame == NULL) {
+        return;
+    }
+
+    PROFILE_BEGIN(PROFILER_PROBE_COMMIT);
+    uint8_t* frame = reserved_frame;
+    uint16_t crc_length = reserved_header_size + reserved_payload_length;
+    uint16_t length = crc_length + FRAME_CHECKSUM_SIZE;
+
+#if FLASH_LOG_ENABLED
+    // Khung được lưu trước khi checksum và COBS ghi đè lên nó; khung có số thứ tự đã được
+    // host xác nhận hoặc gửi lại, khung phát lại đã nằm trong nhật ký
+    if (!(reserved_flags & (FRAME_FLAG_SEQ | FRAME_FLAG_LOG)) && flash_log_is_recording()) {
+        flash_log_append(frame, crc_length);
+    }
+#endif
+
+#if PROTOCOL_CRC32_HW
+    // Bộ CRC phần cứng đọc cả khung theo word, CPU chỉ còn một lệnh ghi cho mỗi 4 byte
+    uint32_t crc = Driver_CRC32_Calculate(frame, crc_length);
+    put_u16(&frame[crc_length], (uint16_t)crc);
+    put_u16(&frame[crc_length + 2], (uint16_t)(crc >> 16));
+#elif !PROTOCOL_COBS
+    crc16_update(&reserved_crc, frame + reserved_header_size + reserved_cursor,
+                 reserved_payload_length - reserved_cursor);
+    put_u16(&frame[crc_length], crc16_final(&reserved_crc));
+#endif
+
+#if PROTOCOL_COBS
+    cobs_encoder_t cobs;
+    cobs_encode_begin(&cobs, reserved_region);
+#if PROTOCOL_CRC32_HW
+    cobs_encode_update(&cobs, frame, length, NULL);
+#else
+    // Vị trí ghi luôn đứng trước vị trí đọc, nên checksum vẫn được điền vào chỗ chưa bị ghi đè
+    cobs_encode_update(&cobs, frame, crc_length, &reserved_crc);
+    put_u16(&frame[crc_length], crc16_final(&reserved_crc));
+    cobs_encode_update(&cobs, &frame[crc_length], sizeof(uint16_t), NULL);
+#endif
+    length = (uint16_t)cobs_encode_end(&cobs);
+    frame = reserved_region;
+#endif
+
+#if RELIABLE_ENABLED
+    // Bản sao cho việc gửi lại được chép trước khi khung được giao cho DMA
+    if (reserved_flags & FRAME_FLAG_SEQ) {
+        reliable_commit(frame, length, reserved_priority);
+    }
+#endif
+
+    reserved_frame = NULL;
+    Driver_UART_Commit(reserved_region, length);
+    PROFILE_END(PROFILER_PROBE_COMMIT);
+}
+
+
+/**
+ * @brief Phát lại một khung đã lưu trong nhật ký flash.
+ *
+ * Tiêu đề của khung đã lưu chỉ được dùng để lấy timestamp và payload; khung mới được dựng
+ * 		như reserve_packet() nên checksum, COBS và số thứ tự luôn khớp với cấu hình đang chạy.
+ *
+ * @param[in] frame    Khung đã lưu (tiêu đề và payload, không có checksum).
+ * @param[in] length   Độ dài khung đã lưu.
+ * @param[in] priority Mức ưu tiên truyền (driver_uart_priority_t).
+ * @return    1 nếu đã phát, 0 nếu bộ đệm truyền hoặc cửa sổ đầy, -1 nếu khung không hợp lệ.
+ */
+int8_t replay_packet(const uint8_t* frame, uint16_t length, uint8_t priority)
+{
+    uint8_t flags = 0;
+
+    if (frame == NULL || length < PACKET_OVERHEAD || frame[0] != HEADER_BYTE1) {
+        return -1;
+    }
+    if (frame[1] == HEADER_BYTE2_EXT) {
+        flags = frame[2];
+    } else if (frame[1] != HEADER_BYTE2) {
+        return -1;
+    }
+
+    uint16_t header_size = FRAME_HEADER_SIZE_OF(flags);
+    if (length < header_size) {
+        return -1;
+    }
+    const uint8_t* field = frame + (flags ? 3 : 2);
+    uint32_t timestamp = (uint32_t)(field[0] | (field[1] << 8));
+    if (flags & FRAME_FLAG_TS32) {
+        timestamp |= (uint32_t)(field[2] | (field[3] << 8)) << 16;
+    }
+    uint16_t payload_length = (uint16_t)(frame[header_size - 2] | (frame[header_size - 1] << 8));
+    if (payload_length == 0 || payload_length > MAX_PAYLOAD_SIZE || header_size + payload_length != length) {
+        return -1;
+    }
+
+    uint8_t replay_flags = (flags & FRAME_FLAG_TS32) | (PROTOCOL_FRAME_FLAGS & FRAME_FLAG_CRC32) | FRAME_FLAG_LOG;
+    if (reserve_frame(payload_length, priority, replay_flags, timestamp, 0) == NULL) {
+        return 0;
+    }
+    append_packet(frame + header_size, payload_length);
+    commit_packet();
+    return 1;
+}
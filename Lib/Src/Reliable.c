@@ -0,0 +1,366 @@
+/*
+ * Reliable.c
+ *
+ *  Created on: May 12, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Reliable.h"
+
+#if RELIABLE_ENABLED
+
+#include "Driver.h"
+#include "Protocol.h"
+#include "Utils.h"
+#include <string.h>
+
+
+/** @brief Số bit của bitmap xác nhận chọn lọc trong ACK. */
+#define RELIABLE_SACK_BITS 32
+
+#define RELIABLE_SLOT(seq) (&reliable_slots[(uint16_t)(seq) & (RELIABLE_WINDOW_MAX - 1)])
+
+
+typedef struct {
+    uint16_t offset;                             // Vị trí của khung trong reliable_buffer
+    uint16_t length;
+    uint32_t sent_ms;                            // Lần gửi gần nhất
+    uint8_t  priority;
+    uint8_t  retries;
+    uint8_t  acked;                              // Đã được xác nhận hoặc đã bị bỏ
+} reliable_slot_t;
+
+
+// Các khung từ reliable_base đến trước reliable_next nằm liên tiếp trong bộ đệm vòng,
+// nên vùng đệm chỉ được giải phóng theo thứ tự dù khung được xác nhận không theo thứ tự
+static uint8_t  reliable_buffer[RELIABLE_BUFFER_SIZE];
+static reliable_slot_t reliable_slots[RELIABLE_WINDOW_MAX];
+static uint8_t  reliable_enabled = 0;
+static uint8_t  reliable_window = RELIABLE_WINDOW_DEFAULT;
+static uint16_t reliable_base = 0;               // Khung cũ nhất chưa được giải phóng
+static uint16_t reliable_next = 0;               // Số thứ tự của khung mới kế tiếp
+static uint16_t reliable_head = 0;               // Vị trí ghi kế tiếp trong reliable_buffer
+static uint16_t reliable_pending = 0;            // Vị trí đã chọn bởi reliable_reserve()
+static uint32_t reliable_last_ack_ms = 0;        // Lần cuối nhận ACK hoặc bắt đầu chờ ACK
+static reliable_stats_t reliable_stats;
+
+
+/**
+ * @brief Chọn vùng đệm liên tiếp cho một khung mới.
+ * @return Vị trí trong reliable_buffer, RELIABLE_BUFFER_SIZE nếu hết chỗ.
+ */
+static uint16_t reliable_alloc(uint16_t length)
+{
+    if (reliable_base == reliable_next) {
+        return (length <= RELIABLE_BUFFER_SIZE) ? 0 : RELIABLE_BUFFER_SIZE;
+    }
+
+    // head không bao giờ đuổi kịp tail khi còn khung, nên head == tail chỉ có nghĩa là rỗng
+    uint16_t tail = RELIABLE_SLOT(reliable_base)->offset;
+    if (reliable_head >= tail) {
+        if (RELIABLE_BUFFER_SIZE - reliable_head >= length) {
+            return reliable_head;
+        }
+        return (length < tail) ? 0 : RELIABLE_BUFFER_SIZE;
+    }
+    return (tail - reliable_head > length) ? reliable_head : RELIABLE_BUFFER_SIZE;
+}
+
+
+/**
+ * @brief Giải phóng các khung đầu cửa sổ đã được xác nhận hoặc đã bị bỏ.
+ */
+static void reliable_release(void)
+{
+    while (reliable_base != reliable_next && RELIABLE_SLOT(reliable_base)->acked) {
+        reliable_base++;
+    }
+}
+
+
+/**
+ * @brief Gửi lại nguyên bản một khung còn trong bộ đệm.
+ * @return 1 nếu đã đưa vào hàng đợi truyền, 0 nếu hàng đợi đầy.
+ */
+static uint8_t reliable_resend(reliable_slot_t* slot, uint32_t now)
+{
+    // Driver_UART_Reserve() chờ đến khi đủ chỗ, nên phải kiểm tra trước để reliable_poll() không bị chặn
+    if (Driver_UART_GetTxSpace(slot->priority) < slot->length) {
+        return 0;
+    }
+
+    uint8_t* region = Driver_UART_Reserve(slot->length, slot->priority);
+    if (region == NULL) {
+        return 0;
+    }
+
+    memcpy(region, &reliable_buffer[slot->offset], slot->length);
+    Driver_UART_Commit(region, slot->length);
+
+    slot->sent_ms = now;
+    slot->retries++;
+    reliable_stats.retransmits++;
+    return 1;
+}
+
+
+/**
+ * @brief Báo trạng thái hiện tại cho host (trả lời ENABLE/DISABLE hoặc khi tự tắt).
+ */
+static void reliable_send_status(void)
+{
+    const reliable_control_data_t msg = { RELIABLE_DATA_ID, RELIABLE_OP_STATUS, reliable_next,
+                                          reliable_enabled ? reliable_window : 0 };
+
+    if (reserve_packet(sizeof(msg), get_data_priority(RELIABLE_DATA_ID)) == NULL) {
+        return;
+    }
+    append_packet((const uint8_t*)&msg, sizeof(msg));
+    commit_packet();
+}
+
+
+/**
+ * @brief Tắt chế độ, các khung chưa được xác nhận được đếm là mất.
+ */
+static void reliable_stop(void)
+{
+    for (uint16_t seq = reliable_base; seq != reliable_next; seq++) {
+        if (!RELIABLE_SLOT(seq)->acked) {
+            reliable_stats.lost++;
+        }
+    }
+
+    reliable_base = reliable_next;
+    reliable_head = 0;
+    reliable_enabled = 0;
+}
+
+
+/**
+ * @brief Áp dụng một ACK và gửi lại các khung còn thiếu trước khung được xác nhận chọn lọc cao nhất.
+ * @param[in] cumulative Số thứ tự host đang chờ.
+ * @param[in] selective  Bitmap xác nhận chọn lọc từ cumulative + 1.
+ * @param[in] now        Thời gian hiện tại (ms).
+ */
+static void reliable_ack(uint16_t cumulative, uint32_t selective, uint32_t now)
+{
+    uint16_t inflight = (uint16_t)(reliable_next - reliable_base);
+    int16_t  ahead = (int16_t)(cumulative - reliable_base);
+
+    // cumulative sau khung mới nhất: ACK không hợp lệ. cumulative trước reliable_base
+    // (khung đó đã bị bỏ): phần tích lũy không còn ý nghĩa nhưng phần chọn lọc vẫn dùng được
+    if (ahead > (int16_t)inflight) {
+        return;
+    }
+    for (int16_t i = 0; i < ahead; i++) {
+        RELIABLE_SLOT(reliable_base + i)->acked = 1;
+    }
+
+    uint16_t highest = reliable_base;
+    uint8_t  sacked = 0;
+    for (uint8_t i = 0; i < RELIABLE_SACK_BITS; i++) {
+        uint16_t seq = (uint16_t)(cumulative + 1 + i);
+        if ((selective & (1UL << i)) == 0 || (int16_t)(seq - reliable_base) < 0) {
+            continue;
+        }
+        if ((uint16_t)(seq - reliable_base) >= inflight) {
+            break;
+        }
+        RELIABLE_SLOT(seq)->acked = 1;
+        highest = seq;
+        sacked = 1;
+    }
+
+    if (sacked) {
+        for (uint16_t seq = (ahead > 0) ? cumulative : reliable_base; seq != highest; seq++) {
+            reliable_slot_t* slot = RELIABLE_SLOT(seq);
+            if (!slot->acked && (int32_t)(now - slot->sent_ms) >= RELIABLE_HOLDOFF_MS &&
+                reliable_resend(slot, now) == 0) {
+                break;
+            }
+        }
+    }
+
+    reliable_stats.acks++;
+    reliable_last_ack_ms = now;
+    reliable_release();
+}
+
+
+/**
+ * @brief Chế độ tin cậy có đang bật hay không.
+ */
+uint8_t reliable_is_enabled(void)
+{
+    return reliable_enabled;
+}
+
+
+/**
+ * @brief Kiểm tra cửa sổ và bộ đệm gửi lại cho một khung mới.
+ * @param[in]  frame_length Độ dài cả khung.
+ * @param[out] seq          Số thứ tự của khung.
+ * @return 1 nếu khung được nhận, 0 nếu cửa sổ hoặc bộ đệm đầy.
+ */
+uint8_t reliable_reserve(uint16_t frame_length, uint16_t* seq)
+{
+    uint16_t offset = RELIABLE_BUFFER_SIZE;
+
+    if ((uint16_t)(reliable_next - reliable_base) < reliable_window) {
+        offset = reliable_alloc(frame_length);
+    }
+    if (offset == RELIABLE_BUFFER_SIZE) {
+        reliable_stats.stalls++;
+        return 0;
+    }
+
+    reliable_pending = offset;
+    *seq = reliable_next;
+    return 1;
+}
+
+
+/**
+ * @brief Lưu bản sao của khung đã hoàn tất vào bộ đệm gửi lại.
+ * @param[in] frame    Khung đã có checksum.
+ * @param[in] length   Độ dài khung.
+ * @param[in] priority Mức ưu tiên truyền, dùng lại khi gửi lại.
+ */
+void reliable_commit(const uint8_t* frame, uint16_t length, uint8_t priority)
+{
+    reliable_slot_t* slot = RELIABLE_SLOT(reliable_next);
+    uint32_t now = Driver_GetTimeMs();
+
+    // Đồng hồ chờ ACK bắt đầu từ khung đầu tiên sau một khoảng không có gì để xác nhận
+    if (reliable_base == reliable_next) {
+        reliable_last_ack_ms = now;
+    }
+
+    memcpy(&reliable_buffer[reliable_pending], frame, length);
+    slot->offset   = reliable_pending;
+    slot->length   = length;
+    slot->sent_ms  = now;
+    slot->priority = priority;
+    slot->retries  = 0;
+    slot->acked    = 0;
+
+    reliable_head = reliable_pending + length;
+    reliable_next++;
+    reliable_stats.sent++;
+}
+
+
+/**
+ * @brief Xử lý khung RELIABLE_DATA_ID nhận từ host.
+ * ENABLE lặp lại (do STATUS bị mất) chỉ cập nhật cửa sổ; các khung cũ còn trong cửa sổ
+ *      được giải phóng bởi ACK đầu tiên của host vì chúng đứng trước seq của STATUS.
+ * @param[in] payload Payload của khung.
+ * @param[in] size    Độ dài payload.
+ * @param[in] now     Thời gian hiện tại (ms).
+ */
+void reliable_handle(const uint8_t* payload, uint16_t size, uint32_t now)
+{
+    reliable_control_data_t msg;
+
+    if (size < sizeof(msg)) {
+        return;
+    }
+    memcpy(&msg, payload, sizeof(msg));
+
+    switch (msg.op) {
+    case RELIABLE_OP_ENABLE:
+        if (msg.value == 0) {
+            reliable_window = RELIABLE_WINDOW_DEFAULT;
+        } else {
+            reliable_window = (msg.value > RELIABLE_WINDOW_MAX) ? RELIABLE_WINDOW_MAX : (uint8_t)msg.value;
+        }
+        reliable_enabled = 1;
+        reliable_last_ack_ms = now;
+        reliable_send_status();
+        break;
+
+    case RELIABLE_OP_DISABLE:
+        if (reliable_enabled) {
+            reliable_stop();
+        }
+        reliable_send_status();
+        break;
+
+    case RELIABLE_OP_ACK:
+        if (reliable_enabled) {
+            reliable_ack(msg.seq, msg.value, now);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+/**
+ * @brief Gửi lại các khung hết hạn và tắt chế độ khi host im lặng quá lâu.
+ * @param[in] now Thời gian hiện tại (ms).
+ */
+void reliable_poll(uint32_t now)
+{
+    if (!reliable_enabled) {
+        return;
+    }
+
+    // Khung có thể được gửi sau now (trong cùng vòng lặp), nên so sánh có dấu
+    if (reliable_base != reliable_next && (int32_t)(now - reliable_last_ack_ms) >= RELIABLE_IDLE_TIMEOUT_MS) {
+        reliable_stop();
+        reliable_send_status();
+        return;
+    }
+
+    for (uint16_t seq = reliable_base; seq != reliable_next; seq++) {
+        reliable_slot_t* slot = RELIABLE_SLOT(seq);
+        if (slot->acked || (int32_t)(now - slot->sent_ms) < RELIABLE_TIMEOUT_MS) {
+            continue;
+        }
+        if (slot->retries >= RELIABLE_MAX_RETRIES) {
+            slot->acked = 1;
+            reliable_stats.lost++;
+            continue;
+        }
+        if (reliable_resend(slot, now) == 0) {
+            break;
+        }
+        reliable_stats.timeouts++;
+    }
+    reliable_release();
+}
+
+
+/**
+ * @brief Thống kê của chế độ tin cậy kể từ khi khởi động.
+ */
+const reliable_stats_t* reliable_get_stats(void)
+{
+    return &reliable_stats;
+}
+
+
+/**
+ * @brief Ghi thống kê của chế độ tin cậy thành một dòng văn bản.
+ * @param[in] buffer Bộ đệm nhận chuỗi.
+ * @param[in] size   Kích thước bộ đệm.
+ * @return Độ dài chuỗi (không kể '\0'), 0 nếu chế độ chưa từng được dùng.
+ */
+uint16_t reliable_format_stats(char *buffer, size_t size)
+{
+    if (!reliable_enabled && reliable_stats.sent == 0) {
+        return 0;
+    }
+
+    return format_line(buffer, size, "reliable win=%u inflight=%u sent=%lu retx=%lu timeouts=%lu lost=%lu stalls=%lu",
+                       reliable_enabled ? reliable_window : 0, (uint16_t)(reliable_next - reliable_base),
+                       (unsigned long)reliable_stats.sent, (unsigned long)reliable_stats.retransmits,
+                       (unsigned long)reliable_stats.timeouts, (unsigned long)reliable_stats.lost,
+                       (unsigned long)reliable_stats.stalls);
+}
+
+#endif /* RELIABLE_ENABLED */
@@ -0,0 +1,229 @@
+/*
+ * Scheduler.c
+ *
+ *  Created on: Apr 14, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Scheduler.h"
+#include "Utils.h"
+#include <string.h>
+
+
+typedef struct {
+    scheduler_producer_t producer;
+    uint16_t rate_hz;
+    uint32_t period;                             // Phần nguyên của chu kỳ (tick)
+    uint32_t period_rem;                         // Phần dư SCHEDULER_TICK_HZ % rate_hz
+    uint32_t rem_acc;                            // Phần dư tích lũy, cộng thêm 1 tick khi đủ rate_hz
+    uint32_t deadline;
+    scheduler_stats_t stats;
+} scheduler_stream_t;
+
+static scheduler_stream_t streams[SCHEDULER_MAX_STREAMS];
+
+
+/**
+ * @brief Tính lại chu kỳ của luồng theo tần số và đặt deadline đầu tiên.
+ */
+static void stream_set_rate(scheduler_stream_t *stream, uint16_t rate_hz, uint32_t now)
+{
+    stream->rate_hz = rate_hz;
+    stream->rem_acc = 0;
+
+    if (rate_hz == 0) {
+        return;
+    }
+
+    stream->period = SCHEDULER_TICK_HZ / rate_hz;
+    stream->period_rem = SCHEDULER_TICK_HZ % rate_hz;
+    stream->deadline = now + stream->period;
+}
+
+
+/**
+ * @brief Dời deadline thêm đúng một chu kỳ.
+ * Phần dư được tích lũy kiểu Bresenham: sau rate_hz chu kỳ, tổng đúng bằng
+ *      SCHEDULER_TICK_HZ, nên 3 Hz trên tick 1 ms không bị trôi 1 ms mỗi giây.
+ */
+static void stream_advance(scheduler_stream_t *stream)
+{
+    stream->deadline += stream->period;
+    stream->rem_acc += stream->period_rem;
+    if (stream->rem_acc >= stream->rate_hz) {
+        stream->rem_acc -= stream->rate_hz;
+        stream->deadline++;
+    }
+}
+
+
+/**
+ * @brief Khởi tạo scheduler, xóa mọi luồng đã đăng ký.
+ */
+void scheduler_init(void)
+{
+    memset(streams, 0, sizeof(streams));
+}
+
+
+/**
+ * @brief Đăng ký producer cho một luồng với tần số cho trước.
+ * @param[in] stream_id Chỉ số luồng (0..SCHEDULER_MAX_STREAMS-1).
+ * @param[in] producer  Hàm tạo dữ liệu.
+ * @param[in] rate_hz   Tần số (Hz), 0 để tạm tắt luồng.
+ * @param[in] now       Thời gian hiện tại (tick).
+ */
+void scheduler_add(uint8_t stream_id, scheduler_producer_t producer, uint16_t rate_hz, uint32_t now)
+{
+    if (stream_id >= SCHEDULER_MAX_STREAMS || producer == NULL) {
+        return;
+    }
+
+    scheduler_stream_t *stream = &streams[stream_id];
+    memset(stream, 0, sizeof(*stream));
+    stream->producer = producer;
+    stream_set_rate(stream, rate_hz, now);
+}
+
+
+/**
+ * @brief Thay đổi tần số của một luồng khi đang chạy.
+ * @param[in] stream_id Chỉ số luồng.
+ * @param[in] rate_hz   Tần số mới (Hz), 0 để tắt luồng.
+ * @param[in] now       Thời gian hiện tại (tick).
+ */
+void scheduler_set_rate(uint8_t stream_id, uint16_t rate_hz, uint32_t now)
+{
+    if (stream_id >= SCHEDULER_MAX_STREAMS || streams[stream_id].producer == NULL) {
+        return;
+    }
+
+    stream_set_rate(&streams[stream_id], rate_hz, now);
+}
+
+
+/**
+ * @brief Lấy tần số hiện tại của một luồng.
+ * @param[in] stream_id Chỉ số luồng.
+ * @return    Tần số (Hz), 0 nếu luồng tắt hoặc chưa đăng ký.
+ */
+uint16_t scheduler_get_rate(uint8_t stream_id)
+{
+    if (stream_id >= SCHEDULER_MAX_STREAMS) {
+        return 0;
+    }
+
+    return streams[stream_id].rate_hz;
+}
+
+
+/**
+ * @brief Kiểm tra một luồng đã được đăng ký hay chưa.
+ * @param[in] stream_id Chỉ số luồng.
+ * @return    1 nếu đã đăng ký, 0 nếu không.
+ */
+uint8_t scheduler_has_stream(uint8_t stream_id)
+{
+    return (stream_id < SCHEDULER_MAX_STREAMS && streams[stream_id].producer != NULL) ? 1 : 0;
+}
+
+
+/**
+ * @brief Gọi producer của một luồng ngay lập tức, ngoài lịch.
+ * @param[in] stream_id Chỉ số luồng.
+ * @return    1 nếu đã gọi, 0 nếu luồng chưa đăng ký.
+ */
+uint8_t scheduler_trigger(uint8_t stream_id)
+{
+    if (!scheduler_has_stream(stream_id)) {
+        return 0;
+    }
+
+    streams[stream_id].producer();
+    return 1;
+}
+
+
+/**
+ * @brief Gọi producer của mọi luồng đã đến deadline.
+ * @param[in] now Thời gian hiện tại (tick).
+ */
+void scheduler_run(uint32_t now)
+{
+    for (uint8_t i = 0; i < SCHEDULER_MAX_STREAMS; i++) {
+        scheduler_stream_t *stream = &streams[i];
+
+        if (stream->producer == NULL || stream->rate_hz == 0) {
+            continue;
+        }
+
+        // So sánh theo hiệu có dấu để đúng cả khi bộ đếm tick bị tràn
+        int32_t lateness = (int32_t)(now - stream->deadline);
+        if (lateness < 0) {
+            continue;
+        }
+
+        stream->stats.runs++;
+        stream->stats.jitter_sum += (uint32_t)lateness;
+        if ((uint32_t)lateness > stream->stats.jitter_max) {
+            stream->stats.jitter_max = (uint32_t)lateness;
+        }
+
+        stream_advance(stream);
+        while ((int32_t)(now - stream->deadline) >= 0) {
+            stream->stats.missed++;
+            stream_advance(stream);
+        }
+
+        stream->producer();
+    }
+}
+
+
+/**
+ * @brief Lấy thống kê của một luồng.
+ * @param[in] stream_id Chỉ số luồng.
+ * @return    Con trỏ đến thống kê, NULL nếu chỉ số không hợp lệ.
+ */
+const scheduler_stats_t* scheduler_get_stats(uint8_t stream_id)
+{
+    if (stream_id >= SCHEDULER_MAX_STREAMS) {
+        return NULL;
+    }
+
+    return &streams[stream_id].stats;
+}
+
+
+/**
+ * @brief Xóa thống kê của mọi luồng.
+ */
+void scheduler_reset_stats(void)
+{
+    for (uint8_t i = 0; i < SCHEDULER_MAX_STREAMS; i++) {
+        memset(&streams[i].stats, 0, sizeof(streams[i].stats));
+    }
+}
+
+
+/**
+ * @brief Định dạng thống kê của một luồng thành chuỗi để gửi đi.
+ * @param[in]  stream_id Chỉ số luồng.
+ * @param[out] buffer    Bộ đệm nhận chuỗi.
+ * @param[in]  size      Kích thước bộ đệm.
+ * @return     Độ dài chuỗi, 0 nếu luồng chưa đăng ký.
+ */
+uint16_t scheduler_format_stats(uint8_t stream_id, char *buffer, size_t size)
+{
+    if (stream_id >= SCHEDULER_MAX_STREAMS || streams[stream_id].producer == NULL) {
+        return 0;
+    }
+
+    const scheduler_stream_t *stream = &streams[stream_id];
+    uint32_t jitter_avg = stream->stats.runs ? stream->stats.jitter_sum / stream->stats.runs : 0;
+
+    return format_line(buffer, size, "sched id=%u rate=%u runs=%lu missed=%lu jit_max=%lu jit_avg=%lu",
+                       stream_id, stream->rate_hz,
+                       (unsigned long)stream->stats.runs, (unsigned long)stream->stats.missed,
+                       (unsigned long)stream->stats.jitter_max, (unsigned long)jitter_avg);
+}
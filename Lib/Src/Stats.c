@@ -0,0 +1,63 @@
+/*
+ * Stats.c
+ *
+ *  Created on: May 20, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Stats.h"
+#include "Acquisition.h"
+#include "Application.h"
+#include "Driver.h"
+#include "Pool.h"
+#include "Scheduler.h"
+#include "Utils.h"
+
+
+/**
+ * @brief Gửi một dòng thống kê, bỏ qua dòng rỗng của module chưa được dùng.
+ * @param[in] line Dòng đã được định dạng.
+ * @param[in] len  Độ dài dòng trả về bởi hàm *_format_stats() hoặc format_line().
+ */
+static void stats_send_line(char *line, uint16_t len)
+{
+    if (len > 0) {
+        send_string_data(len, (uint8_t*)line);
+    }
+}
+
+
+/**
+ * @brief Gửi mọi dòng thống kê.
+ */
+void stats_report_all(void)
+{
+    char line[STATS_LINE_SIZE];
+
+    for (uint8_t id = 0; id < SCHEDULER_MAX_STREAMS; id++) {
+        stats_send_line(line, scheduler_format_stats(id, line, sizeof(line)));
+    }
+
+    for (uint8_t prio = 0; prio < DRIVER_UART_TX_CLASSES; prio++) {
+        const driver_uart_tx_stats_t *stats = Driver_UART_GetTxStats(prio);
+        uint32_t latency_avg = stats->frames ? stats->latency_sum_us / stats->frames : 0;
+
+        stats_send_line(line, format_line(line, sizeof(line), "tx prio=%u frames=%lu lat_max_us=%lu lat_avg_us=%lu",
+                                          prio, (unsigned long)stats->frames,
+                                          (unsigned long)stats->latency_max_us, (unsigned long)latency_avg));
+    }
+    Driver_UART_ResetTxStats();
+
+    for (uint8_t pool_class = 0; pool_class < POOL_CLASS_COUNT; pool_class++) {
+        stats_send_line(line, pool_format_stats(pool_class, line, sizeof(line)));
+    }
+
+    stats_send_line(line, acquisition_format_stats(line, sizeof(line)));
+    stats_send_line(line, button_format_stats(line, sizeof(line)));
+#if RELIABLE_ENABLED
+    stats_send_line(line, reliable_format_stats(line, sizeof(line)));
+#endif
+#if FLASH_LOG_ENABLED
+    stats_send_line(line, flash_log_format_stats(line, sizeof(line)));
+#endif
+}
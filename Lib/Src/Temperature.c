@@ -0,0 +1,97 @@
+/*
+ * Temperature.c
+ *
+ *  Created on: May 08, 2025
+ *      Author: MACH TRONG HAI
+ */
+
+#include "Temperature.h"
+#include "Driver.h"
+#include "Utils.h"
+
+
+/** @brief Số bit phân số của giá trị ADC trung bình (Q4: 1/16 LSB). */
+#define TEMPERATURE_FRAC_BITS 4
+
+
+static uint16_t temperature_cal30 = TEMPERATURE_CAL30_TYPICAL;
+static uint16_t temperature_cal110 = TEMPERATURE_CAL110_TYPICAL;
+static uint32_t temperature_filter = 0;         // Giá trị ADC đã lọc, Q4 << FILTER_SHIFT
+static uint8_t  temperature_state = 0;          // 0: chưa có loạt, 1: loạt khởi động (bỏ), 2: có giá trị
+static uint32_t temperature_last_start_ms = 0;
+
+
+/**
+ * @brief Đọc giá trị hiệu chuẩn và bắt đầu loạt chuyển đổi đầu tiên.
+ * Loạt đầu tiên bị bỏ vì cảm biến vừa được bật (tSTART ~10 us) chưa ổn định.
+ */
+void temperature_init(void)
+{
+    if (Driver_TempSensor_GetCalibration(&temperature_cal30, &temperature_cal110) == 0) {
+        temperature_cal30 = TEMPERATURE_CAL30_TYPICAL;
+        temperature_cal110 = TEMPERATURE_CAL110_TYPICAL;
+    }
+
+    temperature_state = 0;
+    temperature_last_start_ms = Driver_GetTimeMs();
+    Driver_TempSensor_Start(TEMPERATURE_OVERSAMPLE);
+}
+
+
+/**
+ * @brief Lấy kết quả của loạt vừa xong và bắt đầu loạt mới khi đến hạn.
+ * @param[in] now Thời gian hiện tại (ms).
+ */
+void temperature_poll(uint32_t now)
+{
+    uint32_t sum;
+    uint16_t count = Driver_TempSensor_Read(&sum);
+
+    if (count > 0) {
+        uint32_t raw = (sum << TEMPERATURE_FRAC_BITS) / count;
+
+        if (temperature_state == 0) {
+            temperature_state = 1;
+        } else if (temperature_state == 1) {
+            // Nạp bộ lọc bằng loạt hợp lệ đầu tiên thay vì trượt lên từ 0
+            temperature_filter = raw << TEMPERATURE_FILTER_SHIFT;
+            temperature_state = 2;
+        } else {
+            temperature_filter += raw - (temperature_filter >> TEMPERATURE_FILTER_SHIFT);
+        }
+    }
+
+    if (now - temperature_last_start_ms >= TEMPERATURE_PERIOD_MS &&
+        Driver_TempSensor_Start(TEMPERATURE_OVERSAMPLE)) {
+        temperature_last_start_ms = now;
+    }
+}
+
+
+/**
+ * @brief Lấy nhiệt độ đã lọc.
+ * Nội suy tuyến tính giữa hai điểm hiệu chuẩn:
+ *      T = 30 + (raw - CAL30) * (110 - 30) / (CAL110 - CAL30), tính theo 0.01 °C.
+ * @param[out] centi_c Nhiệt độ theo đơn vị 0.01 °C.
+ * @return 1 nếu đã có giá trị, 0 nếu chưa có loạt nào xong.
+ */
+uint8_t temperature_get_centi(int16_t* centi_c)
+{
+    if (temperature_state < 2) {
+        return 0;
+    }
+
+    int32_t raw = (int32_t)(temperature_filter >> TEMPERATURE_FILTER_SHIFT);
+    int32_t offset = raw - ((int32_t)temperature_cal30 << TEMPERATURE_FRAC_BITS);
+    int32_t span = ((int32_t)temperature_cal110 - temperature_cal30) << TEMPERATURE_FRAC_BITS;
+    int32_t centi = 3000 + offset * 8000 / span;
+
+    if (centi > INT16_MAX) {
+        centi = INT16_MAX;
+    } else if (centi < INT16_MIN) {
+        centi = INT16_MIN;
+    }
+
+    *centi_c = (int16_t)centi;
+    return 1;
+}
@@ -9,6 +9,13 @@
 #include "Utils.h"
 
 #include "stm32f4xx_hal.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+
+// Phần cao của bộ đếm chu kỳ 64 bit và giá trị CYCCNT lần đọc trước để phát hiện tràn
+static uint32_t cycles_high = 0;
+static uint32_t cycles_last = 0;
 
 
 /**
@@ -20,3 +27,100 @@ uint32_t Driver_GetTimeMs(void)
 {
     return HAL_GetTick();
 }
+
+
+/**
+ * @brief Bật bộ đếm chu kỳ DWT CYCCNT của Cortex-M4.
+ * Cần được gọi một lần trước khi dùng Driver_GetCycles().
+ */
+void Driver_CycleCounterInit(void)
+{
+    // Không reset bộ đếm đang chạy để bộ đếm 64 bit không bị nhảy lùi
+    if (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+        return;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
+/**
+ * @brief Lấy giá trị hiện tại của bộ đếm chu kỳ DWT CYCCNT.
+ * @return Số chu kỳ CPU kể từ khi bộ đếm được bật.
+ */
+uint32_t Driver_GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+
+/**
+ * @brief Lấy bộ đếm chu kỳ đã được mở rộng thành 64 bit bằng phần mềm.
+ * @return Số chu kỳ CPU kể từ khi bộ đếm được bật.
+ */
+uint64_t Driver_GetCycles64(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t now = DWT->CYCCNT;
+    if (now < cycles_last) {
+        cycles_high++;
+    }
+    cycles_last = now;
+    uint64_t cycles = ((uint64_t)cycles_high << 32) | now;
+
+    __set_PRIMASK(primask);
+    return cycles;
+}
+
+
+/**
+ * @brief Lấy thời gian hệ thống hiện tại tính bằng micro giây.
+ * @return Thời gian hiện tại tính bằng micro giây (32 bit thấp).
+ */
+uint32_t Driver_GetTimeUs(void)
+{
+    return (uint32_t)(Driver_GetCycles64() / (SystemCoreClock / 1000000u));
+}
+
+
+/**
+ * @brief Đổi một khoảng chu kỳ CPU ra micro giây.
+ * @param[in] cycles Số chu kỳ.
+ * @return Số micro giây tương ứng.
+ */
+uint32_t Driver_CyclesToUs(uint32_t cycles)
+{
+    return cycles / (SystemCoreClock / 1000000u);
+}
+
+
+/**
+ * @brief Ghi một dòng văn bản theo định dạng printf, cắt theo kích thước bộ đệm.
+ * @param[in] buffer Bộ đệm nhận chuỗi.
+ * @param[in] size   Kích thước bộ đệm.
+ * @param[in] format Chuỗi định dạng printf.
+ * @return Độ dài chuỗi đã ghi (không kể '\0'), 0 nếu bộ đệm rỗng hoặc định dạng lỗi.
+ */
+uint16_t format_line(char *buffer, size_t size, const char *format, ...)
+{
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, size, format, args);
+    va_end(args);
+
+    if (len < 0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+
+    // vsnprintf() trả về độ dài đầy đủ kể cả khi chuỗi bị cắt
+    return (len >= (int)size) ? (uint16_t)(size - 1) : (uint16_t)len;
+}
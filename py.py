@@ -1,64 +1,467 @@
-import serial
+import os
+import sys
 import time
 import struct
 import csv
 
+def _make_crc16_table():
+    table = []
+    for byte in range(256):
+        crc = byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+CRC16_TABLE = _make_crc16_table()
+
 def calculate_crc16(data: bytes) -> int:
-    """Tính CRC16 (CRC-16 Modbus) cho dữ liệu."""
+    """Tính CRC16 (CRC-16 Modbus) cho dữ liệu, mỗi byte một lần tra bảng."""
     crc = 0xFFFF
+    table = CRC16_TABLE
     for byte in data:
-        crc ^= byte
+        crc = (crc >> 8) ^ table[(crc ^ byte) & 0xFF]
+    return crc
+
+# Tiêu đề khung: khung gốc (CRC16) và khung mở rộng có thêm byte cờ
+HEADER_LEGACY = b'\xde\xab'
+HEADER_EXTENDED = b'\xde\xac'
+
+# Các cờ của khung mở rộng
+FLAG_CRC32 = 0x01     # checksum 4 byte tính bởi bộ CRC phần cứng thay cho CRC16
+FLAG_TS32 = 0x02      # timestamp 4 byte tính bằng micro giây thay cho 2 byte mili giây
+FLAG_SEQ = 0x04       # số thứ tự 2 byte sau timestamp (chế độ truyền tin cậy, Lib/Inc/Reliable.h)
+FLAG_LOG = 0x08       # khung được phát lại từ nhật ký flash, timestamp là thời điểm được lưu (Lib/Inc/FlashLog.h)
+KNOWN_FLAGS = FLAG_CRC32 | FLAG_TS32 | FLAG_SEQ | FLAG_LOG
+
+# Kích thước payload lớn nhất (MAX_PAYLOAD_SIZE trong Protocol.h)
+MAX_PAYLOAD_SIZE = 1024
+
+def _make_crc32_table():
+    table = []
+    for byte in range(256):
+        crc = byte << 24
         for _ in range(8):
-            if crc & 1:
-                crc = (crc >> 1) ^ 0xA001
+            if crc & 0x80000000:
+                crc = ((crc << 1) ^ 0x04C11DB7) & 0xFFFFFFFF
             else:
-                crc >>= 1
+                crc = (crc << 1) & 0xFFFFFFFF
+        table.append(crc)
+    return table
+
+CRC32_TABLE = _make_crc32_table()
+
+def calculate_crc32_stm32(data: bytes) -> int:
+    """
+    Tính CRC-32 giống bộ CRC của STM32F4: đa thức 0x04C11DB7, khởi tạo 0xFFFFFFFF,
+    không đảo bit. Dữ liệu được nạp theo từng word 32 bit little-endian (bit cao trước),
+    phần lẻ cuối cùng được đệm thêm byte 0 cho đủ một word.
+    """
+    crc = 0xFFFFFFFF
+    padded = bytes(data) + b'\x00' * (-len(data) % 4)
+    for i in range(0, len(padded), 4):
+        # Word little-endian được xử lý từ byte cao nhất, tức là đảo thứ tự 4 byte
+        for byte in reversed(padded[i:i+4]):
+            crc = ((crc << 8) & 0xFFFFFFFF) ^ CRC32_TABLE[((crc >> 24) ^ byte) & 0xFF]
     return crc
 
-def decode_frame(buffer: bytearray):
+def decode_frame_at(buffer: bytearray, offset: int = 0):
     """
-    Giải mã một frame từ buffer.
-    Cấu trúc frame:
+    Giải mã một frame bắt đầu từ vị trí offset của buffer, không cắt buffer.
+    Cấu trúc frame gốc (DE AB):
       - Overhead: 6 byte (header, timestamp, payload_size)
       - Payload: payload_size byte
-      - Checksum: 2 byte
-    Trả về (frame_dict, remaining_buffer).
-    Nếu dữ liệu chưa đủ, trả về (None, buffer).
+      - Checksum: 2 byte CRC16
+    Cấu trúc frame mở rộng (DE AC):
+      - Overhead: header (2), flags (1), timestamp (4 byte us nếu có FLAG_TS32,
+        ngược lại 2 byte ms), seq (2, chỉ khi có FLAG_SEQ), payload_size (2)
+      - Payload: payload_size byte
+      - Checksum: 4 byte CRC-32 nếu có FLAG_CRC32, ngược lại 2 byte CRC16
+    Trường "timestamp_us" luôn tính bằng micro giây, "timestamp_wrap_us" là chu kỳ tràn của nó;
+    "seq" là None với khung không có FLAG_SEQ.
+    Trả về (frame_dict, next_offset).
+    Nếu dữ liệu chưa đủ, trả về (None, offset) với offset trỏ vào tiêu đề đang chờ.
     """
-    min_frame_length = 6 + 0 + 2  # ít nhất 8 byte
-    if len(buffer) < min_frame_length:
-        return None, buffer
-
-    # Kiểm tra header: phải là b'\xde\xab'
-    if buffer[0:2] != b'\xde\xab':
-        idx = buffer.find(0xDE)
+    # Bỏ qua các byte rác cho đến khi gặp một tiêu đề hợp lệ
+    while buffer[offset:offset+2] not in (HEADER_LEGACY, HEADER_EXTENDED):
+        if len(buffer) - offset < 2:
+            return None, offset
+        idx = buffer.find(0xDE, offset + 1)
         if idx == -1:
-            return None, bytearray()
-        buffer = buffer[idx:]
-        if len(buffer) < min_frame_length or buffer[0:2] != b'\xde\xab':
-            return None, buffer
+            return None, len(buffer)
+        offset = idx
+
+    flags = 0
+    start = offset
+    offset += 2
+    if buffer[start:start+2] == HEADER_EXTENDED:
+        if len(buffer) < start + 3:
+            return None, start
+        flags = buffer[start+2]
+        offset += 1
+        if flags & ~KNOWN_FLAGS:
+            # Cờ chưa biết thì không xác định được độ dài khung, tìm tiêu đề kế tiếp
+            return None, start + 1
 
-    timestamp = int.from_bytes(buffer[2:4], byteorder='little')
-    payload_size = int.from_bytes(buffer[4:6], byteorder='little')
-    total_length = 6 + payload_size + 2
-    if len(buffer) < total_length:
-        return None, buffer
+    checksum_size = 4 if flags & FLAG_CRC32 else 2
+    timestamp_size = 4 if flags & FLAG_TS32 else 2
+    seq_size = 2 if flags & FLAG_SEQ else 0
+    header_end = offset + timestamp_size + seq_size + 2
+    if len(buffer) < header_end + checksum_size:
+        return None, start
 
-    payload = buffer[6:6+payload_size]
-    checksum = int.from_bytes(buffer[6+payload_size:6+payload_size+2], byteorder='little')
-    computed_crc = calculate_crc16(buffer[0:6] + payload)
+    timestamp = int.from_bytes(buffer[offset:offset+timestamp_size], byteorder='little')
+    seq = None
+    if seq_size:
+        seq = int.from_bytes(buffer[offset+timestamp_size:header_end-2], byteorder='little')
+    payload_size = int.from_bytes(buffer[header_end-2:header_end], byteorder='little')
+    if payload_size > MAX_PAYLOAD_SIZE:
+        # Độ dài không thể có: tiêu đề giả, tìm tiếp ngay sau nó thay vì chờ đủ độ dài
+        return None, start + 1
+    if flags & FLAG_TS32:
+        timestamp_us, timestamp_wrap_us = timestamp, 1 << 32
+    else:
+        timestamp_us, timestamp_wrap_us = timestamp * 1000, (1 << 16) * 1000
+    payload_end = header_end + payload_size
+    total_end = payload_end + checksum_size
+    if len(buffer) < total_end:
+        return None, start
+
+    payload = buffer[header_end:payload_end]
+    checksum = int.from_bytes(buffer[payload_end:total_end], byteorder='little')
+    if flags & FLAG_CRC32:
+        computed_crc = calculate_crc32_stm32(buffer[start:payload_end])
+    else:
+        computed_crc = calculate_crc16(memoryview(buffer)[start:payload_end])
 
     frame = {
-        "header": buffer[0:2],
+        "header": buffer[start:start+2],
+        "flags": flags,
         "timestamp": timestamp,
+        "timestamp_us": timestamp_us,
+        "timestamp_wrap_us": timestamp_wrap_us,
+        "seq": seq,
         "payload_size": payload_size,
         "payload": payload,  # raw bytes
         "checksum": checksum,
         "computed_crc": computed_crc,
         "valid": (checksum == computed_crc)
     }
-    remaining = buffer[total_length:]
-    return frame, remaining
+    return frame, total_end
+
+def decode_frame(buffer: bytearray):
+    """
+    Giải mã một frame từ đầu buffer.
+    Trả về (frame_dict, remaining_buffer); nếu dữ liệu chưa đủ, trả về (None, buffer).
+    """
+    frame, offset = decode_frame_at(buffer, 0)
+    return frame, buffer[offset:]
+
+def decode_frames(buffer: bytearray):
+    """
+    Giải mã mọi frame đầy đủ trong buffer trong một lượt.
+    Trả về (danh sách (frame, payload_info), số byte đã xử lý); người gọi xóa
+    phần đã xử lý một lần, thay vì cắt buffer sau mỗi frame.
+    """
+    results = []
+    offset = 0
+    while True:
+        frame, next_offset = decode_frame_at(buffer, offset)
+        if frame is None and next_offset == offset:
+            break
+        offset = next_offset
+        if frame:
+            results.append((frame, decode_payload(frame) if frame["valid"] else None))
+    return results, offset
+
+# Kích thước lớn nhất của một khung chưa mã hóa: tiêu đề mở rộng 11 byte, payload và CRC-32
+MAX_FRAME_SIZE = 11 + MAX_PAYLOAD_SIZE + 4
+
+def cobs_decode(data):
+    """
+    Giải mã một khung COBS (Lib/Inc/Cobs.h, không kể byte 0 phân cách).
+    Trả về bytearray dữ liệu gốc, hoặc None nếu khung bị cắt ngang hoặc quá dài.
+    """
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        end = pos + code
+        if code == 0 or end > len(data) or len(out) + code > MAX_FRAME_SIZE:
+            return None
+        out += data[pos+1:end]
+        pos = end
+        # Byte 0 ẩn sau mỗi nhóm chưa đầy, trừ nhóm cuối cùng
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return out
+
+def decode_cobs_frames(buffer: bytearray):
+    """
+    Như decode_frames() nhưng cho luồng của firmware build với PROTOCOL_COBS=1:
+    mỗi khung kết thúc bằng byte 0, nên chỉ cần tách ở byte 0 rồi giải mã từng phần.
+    Phần không giải mã được hoặc không khớp đúng một khung được trả về như một khung
+    không hợp lệ ({"valid": False, "cobs": ...}); khung kế tiếp không bị ảnh hưởng.
+    """
+    results = []
+    offset = 0
+    while True:
+        end = buffer.find(0, offset)
+        if end == -1:
+            break
+        chunk = buffer[offset:end]
+        offset = end + 1
+        if not chunk:
+            continue
+        raw = cobs_decode(chunk)
+        frame = None
+        if raw is not None and raw[:2] in (HEADER_LEGACY, HEADER_EXTENDED):
+            frame, frame_end = decode_frame_at(raw, 0)
+            if frame is not None and frame_end != len(raw):
+                frame = None
+        if frame is None:
+            results.append(({"valid": False, "cobs": bytes(chunk)}, None))
+        else:
+            results.append((frame, decode_payload(frame) if frame["valid"] else None))
+    return results, offset
+
+# Kích thước cố định của từng loại bản ghi (data_id -> số byte); chuỗi có độ dài thay đổi
+RECORD_SIZES = {1: 13, 2: 6, 3: 7, 5: 4, 6: 3}
+
+def record_size(payload_bytes, offset):
+    """Trả về độ dài của bản ghi bắt đầu tại offset, hoặc None nếu không xác định được."""
+    data_id = payload_bytes[offset]
+    if data_id in RECORD_SIZES:
+        return RECORD_SIZES[data_id]
+    if data_id == 4 and offset + 3 <= len(payload_bytes):
+        return 3 + int.from_bytes(payload_bytes[offset+1:offset+3], byteorder='little')
+    return None
+
+def decode_batch(payload_bytes):
+    """
+    Giải mã payload gộp (data_id=7): [data_id (1), record_count (1), bản ghi ...].
+    Mỗi bản ghi có cùng định dạng với payload của khung đơn tương ứng.
+    Trả về danh sách kết quả decode_payload của từng bản ghi.
+    """
+    if len(payload_bytes) < 2:
+        return None
+    record_count = payload_bytes[1]
+    offset = 2
+    records = []
+    for _ in range(record_count):
+        if offset >= len(payload_bytes):
+            print("Batch truncated after", len(records), "records")
+            return None
+        size = record_size(payload_bytes, offset)
+        if size is None or offset + size > len(payload_bytes):
+            print("Unrecognized record in batch at offset", offset)
+            return None
+        record = payload_bytes[offset:offset+size]
+        records.append(decode_payload({"payload": record, "payload_size": size}))
+        offset += size
+    return records
+
+ADC_BLOCK_DATA_ID = 10
+ADC_BLOCK_HEADER = struct.Struct('<BBIH')
+ADC_BLOCK_PACKED12 = 0
+ADC_BLOCK_DELTA_VARINT = 1
+
+def decode_adc_block(payload_bytes):
+    """
+    Giải mã khối ADC nén (data_id=10): [data_id (1), encoding (1), first_sample (4), count (2), dữ liệu].
+      - encoding 0: mỗi cặp mẫu 12 bit trong 3 byte, mẫu lẻ cuối cùng 2 byte.
+      - encoding 1: mẫu đầu 2 byte, sau đó zigzag(mẫu - mẫu trước) dạng varint.
+    Mẫu thứ i có sample_count = first_sample + i. Trả về danh sách ("ADC", sample_count, value).
+    """
+    if len(payload_bytes) < ADC_BLOCK_HEADER.size:
+        return None
+    _, encoding, first, count = ADC_BLOCK_HEADER.unpack_from(payload_bytes)
+    data = payload_bytes[ADC_BLOCK_HEADER.size:]
+    values = []
+    if encoding == ADC_BLOCK_PACKED12:
+        if len(data) != count // 2 * 3 + (count & 1) * 2:
+            return None
+        for i in range(0, count - 1, 2):
+            b0, b1, b2 = data[i // 2 * 3:i // 2 * 3 + 3]
+            values.append(b0 | (b1 & 0x0F) << 8)
+            values.append(b1 >> 4 | b2 << 4)
+        if count & 1:
+            values.append(data[-2] | data[-1] << 8)
+    elif encoding == ADC_BLOCK_DELTA_VARINT:
+        if count == 0 or len(data) < 2:
+            return None
+        value = data[0] | data[1] << 8
+        values.append(value)
+        zigzag = shift = 0
+        for byte in data[2:]:
+            zigzag |= (byte & 0x7F) << shift
+            shift += 7
+            if byte & 0x80:
+                continue
+            value += (zigzag >> 1) ^ -(zigzag & 1)
+            values.append(value)
+            zigzag = shift = 0
+        if len(values) != count or shift:
+            return None
+    else:
+        return None
+    return [("ADC", first + i, v) for i, v in enumerate(values)]
+
+# Tên các điểm đo của bộ profiler (profiler_probe_t trong Profiler.h)
+PROFILER_PROBES = ["pack_packet", "calculate_crc16", "send_packet", "commit_packet", "uart_transmit"]
+PROFILER_HISTOGRAM_BINS = 16
+PROFILER_RECORD = struct.Struct('<BIIII' + 'H' * PROFILER_HISTOGRAM_BINS)
+
+def decode_profiler(payload_bytes):
+    """
+    Giải mã báo cáo profiler (data_id=8): [data_id (1), probe_count (1), core_mhz (1), bản ghi ...].
+    Mỗi bản ghi: [probe (1), count (4), min (4), max (4), mean (4), histogram (16 x 2)],
+    các giá trị tính bằng chu kỳ CPU; ô k của histogram đếm các lần đo trong [2^k, 2^(k+1)).
+    Trả về (core_mhz, danh sách dict của từng điểm đo).
+    """
+    if len(payload_bytes) < 3:
+        return None
+    probe_count = payload_bytes[1]
+    core_mhz = payload_bytes[2] or 1
+    if len(payload_bytes) != 3 + probe_count * PROFILER_RECORD.size:
+        print("Profiler report size mismatch:", len(payload_bytes))
+        return None
+    probes = []
+    for i in range(probe_count):
+        fields = PROFILER_RECORD.unpack_from(payload_bytes, 3 + i * PROFILER_RECORD.size)
+        probe = fields[0]
+        probes.append({
+            "name": PROFILER_PROBES[probe] if probe < len(PROFILER_PROBES) else f"probe{probe}",
+            "count": fields[1],
+            "min": fields[2],
+            "max": fields[3],
+            "mean": fields[4],
+            "histogram": list(fields[5:]),
+        })
+    return core_mhz, probes
+
+def format_profiler_report(core_mhz, probes):
+    """Dựng bảng báo cáo profiler: chu kỳ và micro giây, kèm histogram dạng thanh."""
+    lines = [f"Profiler report (core {core_mhz} MHz)",
+             f"{'probe':<16}{'count':>8}{'min':>9}{'mean':>9}{'max':>9}{'mean us':>10}{'max us':>10}"]
+    for p in probes:
+        if p["count"] == 0:
+            lines.append(f"{p['name']:<16}{0:>8}")
+            continue
+        lines.append(f"{p['name']:<16}{p['count']:>8}{p['min']:>9}{p['mean']:>9}{p['max']:>9}"
+                     f"{p['mean'] / core_mhz:>10.2f}{p['max'] / core_mhz:>10.2f}")
+        peak = max(p["histogram"])
+        for k, n in enumerate(p["histogram"]):
+            if n:
+                bar = '#' * max(1, n * 30 // peak)
+                label = f">={1 << k}" if k == PROFILER_HISTOGRAM_BINS - 1 else f"<{1 << (k + 1)}"
+                lines.append(f"{'':<4}{label:>8} cyc {n:>6} {bar}")
+    return "\n".join(lines)
+
+# Khung điều khiển liên kết (data_id=9, link_control_data_t trong Lib/Inc/Link.h)
+LINK_DATA_ID = 9
+LINK_CONTROL = struct.Struct('<BBIH')    # data_id, op, baud, arg
+LINK_OP_PROPOSE, LINK_OP_ACCEPT, LINK_OP_REJECT, LINK_OP_PROBE, LINK_OP_PROBE_ACK, \
+    LINK_OP_COMMIT, LINK_OP_COMMIT_ACK, LINK_OP_KEEPALIVE, LINK_OP_STATUS = range(1, 10)
+LINK_OPS = ["", "propose", "accept", "reject", "probe", "probe_ack", "commit", "commit_ack",
+            "keepalive", "status"]
+LINK_REASONS = ["none", "trial_timeout", "keepalive_timeout", "crc_errors", "rx_errors"]
+LINK_PROBE_SIZE = 256
+LINK_PROBE_PATTERN = bytes((i * 0x4B + 0x1D) & 0xFF for i in range(LINK_PROBE_SIZE))
+
+def encode_frame(payload: bytes, timestamp: int = 0) -> bytes:
+    """Đóng gói payload thành khung gốc DE AB với CRC16, giống pack_packet() của firmware."""
+    frame = HEADER_LEGACY + struct.pack('<HH', timestamp & 0xFFFF, len(payload)) + payload
+    return frame + struct.pack('<H', calculate_crc16(frame))
+
+def encode_link(op: int, baud: int, arg: int = 0) -> bytes:
+    return encode_frame(LINK_CONTROL.pack(LINK_DATA_ID, op, baud, arg))
+
+def decode_link(payload_bytes):
+    """
+    Giải mã khung điều khiển liên kết: [data_id (1), op (1), baud (4), arg (2), mẫu thử (tùy chọn)].
+    Trả về (op, baud, arg, mẫu thử) hoặc None.
+    """
+    if len(payload_bytes) < LINK_CONTROL.size:
+        return None
+    _, op, baud, arg = LINK_CONTROL.unpack_from(payload_bytes)
+    return op, baud, arg, bytes(payload_bytes[LINK_CONTROL.size:])
+
+# Lệnh host -> thiết bị và trả lời (data_id=11, command_data_t trong Lib/Inc/Command.h)
+COMMAND_DATA_ID = 11
+COMMAND = struct.Struct('<BBBBI')        # data_id, op, stream_id, status, value
+COMMAND_OP_REPLY = 0x80
+COMMAND_OPS = ["", "rate", "enable", "disable", "snapshot", "get"]
+COMMAND_STATUS = ["ok", "bad_stream", "bad_value", "unsupported"]
+COMMAND_STREAMS = {"stats": 0, "date": 1, "time": 2, "adc": 3, "hello": 4, "button": 5,
+                   "temperature": 6, "profiler": 8}
+
+def encode_command(op: int, stream_id: int, value: int = 0) -> bytes:
+    return encode_frame(COMMAND.pack(COMMAND_DATA_ID, op, stream_id, 0, value))
+
+def parse_command(text):
+    """
+    Đọc lệnh dạng op:luồng[:giá trị], ví dụ rate:adc:2000, disable:hello, snapshot:stats.
+    luồng là tên trong COMMAND_STREAMS hoặc data_id. Trả về khung đã đóng gói.
+    """
+    parts = text.split(":")
+    if len(parts) not in (2, 3) or parts[0] not in COMMAND_OPS[1:]:
+        raise ValueError(f"invalid command '{text}' (op: {', '.join(COMMAND_OPS[1:])})")
+    stream = COMMAND_STREAMS[parts[1]] if parts[1] in COMMAND_STREAMS else int(parts[1], 0)
+    value = int(parts[2], 0) if len(parts) == 3 else 0
+    return encode_command(COMMAND_OPS.index(parts[0]), stream, value)
+
+def decode_command(payload_bytes):
+    """
+    Giải mã trả lời lệnh: [data_id (1), op | 0x80 (1), stream_id (1), status (1), value (4)].
+    Trả về (op, stream_id, status, value) với op/status là tên, hoặc None.
+    """
+    if len(payload_bytes) < COMMAND.size:
+        return None
+    _, op, stream, status, value = COMMAND.unpack_from(payload_bytes)
+    op &= ~COMMAND_OP_REPLY
+    return (COMMAND_OPS[op] if op < len(COMMAND_OPS) else f"op{op}", stream,
+            COMMAND_STATUS[status] if status < len(COMMAND_STATUS) else f"status{status}", value)
+
+# Chế độ truyền tin cậy (data_id=12, reliable_control_data_t trong Lib/Inc/Reliable.h)
+RELIABLE_DATA_ID = 12
+RELIABLE_CONTROL = struct.Struct('<BBHI')  # data_id, op, seq, value
+RELIABLE_OP_ENABLE, RELIABLE_OP_DISABLE, RELIABLE_OP_ACK, RELIABLE_OP_STATUS = range(1, 5)
+RELIABLE_OPS = ["", "enable", "disable", "ack", "status"]
+RELIABLE_WINDOW_MAX = 64
+RELIABLE_SACK_BITS = 32
+
+def encode_reliable(op: int, seq: int = 0, value: int = 0) -> bytes:
+    return encode_frame(RELIABLE_CONTROL.pack(RELIABLE_DATA_ID, op, seq & 0xFFFF, value))
+
+def decode_reliable(payload_bytes):
+    """
+    Giải mã khung điều khiển chế độ tin cậy: [data_id (1), op (1), seq (2), value (4)].
+    Trả về (op, seq, value) với op là tên, hoặc None.
+    """
+    if len(payload_bytes) < RELIABLE_CONTROL.size:
+        return None
+    _, op, seq, value = RELIABLE_CONTROL.unpack_from(payload_bytes)
+    return RELIABLE_OPS[op] if op < len(RELIABLE_OPS) else f"op{op}", seq, value
+
+# Nhật ký flash (data_id=13, flash_log_control_data_t trong Lib/Inc/FlashLog.h)
+FLASH_LOG_DATA_ID = 13
+FLASH_LOG_CONTROL = struct.Struct('<BBHI')  # data_id, op, arg, value
+FLASH_LOG_OP_PRESENT, FLASH_LOG_OP_DUMP, FLASH_LOG_OP_STATUS, FLASH_LOG_OP_END = range(1, 5)
+FLASH_LOG_OPS = ["", "present", "dump", "status", "end"]
+
+def encode_flash_log(op: int, arg: int = 0, value: int = 0) -> bytes:
+    return encode_frame(FLASH_LOG_CONTROL.pack(FLASH_LOG_DATA_ID, op, arg, value))
+
+def decode_flash_log(payload_bytes):
+    """
+    Giải mã khung điều khiển nhật ký flash: [data_id (1), op (1), arg (2), value (4)].
+    Trả về (op, arg, value) với op là tên, hoặc None.
+    """
+    if len(payload_bytes) < FLASH_LOG_CONTROL.size:
+        return None
+    _, op, arg, value = FLASH_LOG_CONTROL.unpack_from(payload_bytes)
+    return FLASH_LOG_OPS[op] if op < len(FLASH_LOG_OPS) else f"op{op}", arg, value
 
 def decode_payload(frame):
     """
@@ -70,7 +473,14 @@ def decode_payload(frame):
       - ADC Data (data_id=3): 7 byte   → [data_id (1), sample_count (4), value (2)]
       - String Data (data_id=4): (1 + 2 + string_len) byte → [data_id (1), string_len (2), string (string_len)]
       - Button Data (data_id=5): 4 byte → [data_id (1), button_id (1), button_state (2)]
-      - Temperature Data (data_id=6): 3 byte → [data_id (1), mcu_temperature_in_c (2)]
+      - Temperature Data (data_id=6): 3 byte → [data_id (1), mcu_temperature_centi_c (2, có dấu, 0.01 °C)]
+      - Batch Data (data_id=7): [data_id (1), record_count (1), các bản ghi ở trên nối tiếp nhau]
+      - Profiler Data (data_id=8): xem decode_profiler()
+      - Link Control (data_id=9): xem decode_link()
+      - ADC Block (data_id=10): xem decode_adc_block()
+      - Command (data_id=11): xem decode_command()
+      - Reliable (data_id=12): xem decode_reliable()
+      - Flash Log (data_id=13): xem decode_flash_log()
     """
     payload_bytes = frame["payload"]
     ps = frame["payload_size"]
@@ -121,62 +531,716 @@ def decode_payload(frame):
             return None
     elif data_id == 6 and ps == 3:
         try:
-            unpacked = struct.unpack('<BH', payload_bytes[0:3])
-            return ("Temperature", unpacked[1])
+            unpacked = struct.unpack('<Bh', payload_bytes[0:3])
+            return ("Temperature", unpacked[1] / 100)
         except Exception as e:
             print("Error decoding Temperature Data:", e)
             return None
+    elif data_id == 7:
+        records = decode_batch(payload_bytes)
+        if records is None:
+            return None
+        return ("Batch", records)
+    elif data_id == 8:
+        report = decode_profiler(payload_bytes)
+        if report is None:
+            return None
+        return ("Profiler", report[0], report[1])
+    elif data_id == LINK_DATA_ID:
+        link = decode_link(payload_bytes)
+        if link is None:
+            return None
+        op, baud, arg, _ = link
+        name = LINK_OPS[op] if op < len(LINK_OPS) else f"op{op}"
+        return ("Link", name, baud, arg)
+    elif data_id == ADC_BLOCK_DATA_ID:
+        samples = decode_adc_block(payload_bytes)
+        if samples is None:
+            print("Error decoding ADC Block")
+            return None
+        return ("AdcBlock", samples)
+    elif data_id == COMMAND_DATA_ID:
+        reply = decode_command(payload_bytes)
+        if reply is None:
+            return None
+        return ("Command",) + reply
+    elif data_id == RELIABLE_DATA_ID:
+        control = decode_reliable(payload_bytes)
+        if control is None:
+            return None
+        return ("Reliable",) + control
+    elif data_id == FLASH_LOG_DATA_ID:
+        control = decode_flash_log(payload_bytes)
+        if control is None:
+            return None
+        return ("FlashLog",) + control
     else:
         print("Unrecognized data type or payload size mismatch.")
         return None
 
+# Thời gian chờ tối đa của một lần đọc serial; vòng lặp chỉ thức dậy khi có dữ liệu hoặc hết hạn
+READ_TIMEOUT_S = 0.05
+# Số byte tối đa lấy ra trong một lần đọc
+READ_MAX_BYTES = 64 * 1024
+# Giới hạn buffer của bộ giải mã Python; phần cũ nhất vượt quá bị bỏ và được đếm
+MAX_BUFFER_BYTES = 16 * 1024
+# Chu kỳ in thống kê nhận
+STATS_PERIOD_S = 5.0
+
+class ReplaySource:
+    """
+    Phát lại một bản ghi luồng (file nhị phân) với giao diện giống serial.Serial.
+    baud > 0: dữ liệu "đến" với tốc độ baud / 10 byte/s như trên UART 8N1;
+    baud = 0: toàn bộ dữ liệu sẵn sàng ngay để đo tốc độ giải mã tối đa.
+    """
+    def __init__(self, path, baud, timeout):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        self.pos = 0
+        self.timeout = timeout
+        self.bytes_per_s = baud / 10.0 if baud else None
+        self.start = time.perf_counter()
+
+    def _arrived(self):
+        if self.bytes_per_s is None:
+            return len(self.data)
+        return min(len(self.data), int((time.perf_counter() - self.start) * self.bytes_per_s))
+
+    @property
+    def in_waiting(self):
+        return self._arrived() - self.pos
+
+    @property
+    def exhausted(self):
+        return self.pos >= len(self.data)
+
+    def read(self, size=1):
+        deadline = time.perf_counter() + self.timeout
+        while True:
+            waiting = self.in_waiting
+            remaining = deadline - time.perf_counter()
+            if waiting >= size or self.pos + waiting >= len(self.data) or remaining <= 0:
+                break
+            time.sleep(min(remaining, (size - waiting) / self.bytes_per_s))
+        n = min(size, self.in_waiting)
+        chunk = self.data[self.pos:self.pos+n]
+        self.pos += n
+        return chunk
+
+    def close(self):
+        pass
+
+class RxStats:
+    """
+    Thống kê phía nhận: tốc độ khung, độ trễ từ lúc đọc đến lúc xử lý xong, tràn buffer,
+    và khoảng trống trong luồng ADC (sample_count phải tăng liên tục từng 1).
+    """
+    def __init__(self):
+        self.start = time.perf_counter()
+        self.window_start = self.start
+        self.bytes = 0
+        self.frames = 0
+        self.window_frames = 0
+        self.corrupted = 0
+        self.overflow_bytes = 0
+        self.overflow_events = 0
+        self.latency_sum = 0.0
+        self.latency_max = 0.0
+        self.backlog_max = 0
+        self.wakeups = 0
+        self.adc_samples = 0
+        self.adc_next = None
+        self.adc_first = None     # mẫu đầu tiên kể từ lúc bắt đầu nhận hoặc luồng khởi động lại
+        self.adc_gaps = 0
+        self.adc_missing = 0
+
+    def frame_done(self, t_rx):
+        latency = time.perf_counter() - t_rx
+        self.frames += 1
+        self.window_frames += 1
+        self.latency_sum += latency
+        self.latency_max = max(self.latency_max, latency)
+
+    def adc(self, sample_count, late=False):
+        if late and self.adc_next is not None and sample_count < self.adc_next:
+            # Mẫu của khung gửi lại ở chế độ tin cậy lấp vào khoảng trống đã được đếm,
+            # trừ khi nó thuộc phần luồng trước mẫu đầu tiên đã nhận
+            if sample_count >= self.adc_first:
+                self.adc_missing -= 1
+            self.adc_samples += 1
+            return
+        if self.adc_next is not None and sample_count > self.adc_next:
+            self.adc_gaps += 1
+            self.adc_missing += sample_count - self.adc_next
+        elif self.adc_next is None or sample_count < self.adc_next:
+            # sample_count nhỏ hơn mong đợi: thiết bị đã khởi động lại luồng, không tính là mất mẫu
+            self.adc_first = sample_count
+        self.adc_next = sample_count + 1
+        self.adc_samples += 1
+
+    def overflow(self, dropped):
+        self.overflow_bytes += dropped
+        self.overflow_events += 1
+
+    def report(self, final=False):
+        now = time.perf_counter()
+        elapsed = now - (self.start if final else self.window_start)
+        frames = self.frames if final else self.window_frames
+        latency_avg = self.latency_sum / self.frames if self.frames else 0.0
+        line = (f"rx {'total' if final else 'window'}: {frames / elapsed if elapsed else 0:.0f} frames/s, "
+                f"{self.frames} frames, {self.bytes} bytes, {self.corrupted} corrupted, "
+                f"latency avg {latency_avg * 1000:.3f} ms max {self.latency_max * 1000:.3f} ms, "
+                f"{self.frames / self.wakeups if self.wakeups else 0:.2f} frames/wakeup, "
+                f"backlog max {self.backlog_max} B, overflow {self.overflow_bytes} B/{self.overflow_events}")
+        if self.adc_samples:
+            line += f", adc {self.adc_samples} samples, {self.adc_gaps} gaps/{self.adc_missing} missing"
+        self.window_start = now
+        self.window_frames = 0
+        return line
+
+# Các tốc độ host thử khi thỏa thuận, từ cao xuống thấp; USART2 (APB1 42 MHz) đạt tối đa 5.25 Mbaud
+LINK_BAUD_CANDIDATES = [5250000, 3000000, 2625000, 2000000, 1500000, 1000000, 921600, 460800, 230400]
+LINK_REPLY_TIMEOUT_S = 0.5        # chờ ACCEPT/REJECT/COMMIT_ACK
+LINK_PROBE_TIMEOUT_S = 1.0        # chờ PROBE_ACK, gồm cả lúc thiết bị truyền nốt hàng đợi ở tốc độ cũ
+LINK_RESEND_S = 0.1               # chu kỳ gửi lại PROBE/COMMIT/KEEPALIVE khi đang chờ trả lời
+LINK_PROBE_COUNT = 3              # số mẫu thử phải đúng trước khi COMMIT
+LINK_KEEPALIVE_PERIOD_S = 1.0
+LINK_KEEPALIVE_TIMEOUT_S = 3.0    # LINK_KEEPALIVE_TIMEOUT_MS của thiết bị
+LINK_SILENCE_TIMEOUT_S = 4.0      # lâu hơn LINK_KEEPALIVE_TIMEOUT_S để thiết bị chắc chắn đã quay về
+LINK_FALLBACK_ERROR_PERMILLE = 20 # giống Link.h
+LINK_FALLBACK_STRIKES = 3
+
+class LinkManager:
+    """
+    Phía host của thỏa thuận tốc độ baud (Lib/Inc/Link.h).
+    negotiate() chạy đồng bộ lúc khởi động và sau mỗi lần quay về: thử các tốc độ trong
+    LINK_BAUD_CANDIDATES từ cao xuống, chỉ giữ tốc độ mà mọi mẫu thử đều đến nguyên vẹn.
+    observe()/poll() được gọi sau mỗi lần thức dậy của vòng lặp chính: gửi KEEPALIVE kèm
+    tỉ lệ khung lỗi CRC (‰), và quay về tốc độ mặc định khi lỗi CRC lặp lại hoặc không còn khung
+    hợp lệ nào; tốc độ bị lỗi không được thử lại trong lần thỏa thuận sau.
+    Các khung dữ liệu nhận được trong lúc thỏa thuận bị bỏ qua và được đếm vào dropped_frames.
+    decode: decode_frames hoặc decode_cobs_frames, theo cách đóng khung của firmware (--cobs).
+    """
+    def __init__(self, ser, default_baud, max_baud, decode=decode_frames):
+        self.ser = ser
+        self.decode = decode
+        self.default_baud = default_baud
+        self.baud = default_baud
+        self.cap = max_baud
+        self.buffer = bytearray()
+        self.last_valid = time.perf_counter()
+        self.last_keepalive = self.last_valid
+        self.crc_errors = 0
+        self.frames = 0
+        self.strikes = 0
+        self.fallbacks = 0
+        self.dropped_frames = 0
+
+    def _set_baud(self, baud):
+        self.ser.baudrate = baud
+        self.ser.reset_input_buffer()
+        self.buffer.clear()
+        self.baud = baud
+
+    def _wait(self, ops, baud, timeout, resend=None):
+        """
+        Đọc cho đến khi nhận được khung điều khiển có op thuộc ops với đúng baud.
+        resend: khung được gửi lại mỗi LINK_RESEND_S trong lúc chờ.
+        Trả về (op, arg, mẫu thử) hoặc None khi hết thời gian.
+        """
+        deadline = time.perf_counter() + timeout
+        next_send = 0.0
+        while time.perf_counter() < deadline:
+            if resend is not None and time.perf_counter() >= next_send:
+                self.ser.write(resend)
+                next_send = time.perf_counter() + LINK_RESEND_S
+            data = self.ser.read(max(1, self.ser.in_waiting))
+            if not data:
+                continue
+            self.buffer.extend(data)
+            results, consumed = self.decode(self.buffer)
+            del self.buffer[:consumed]
+            for frame, _ in results:
+                link = decode_link(frame["payload"]) if frame["valid"] else None
+                if link is None or frame["payload"][0] != LINK_DATA_ID:
+                    self.dropped_frames += 1
+                    continue
+                op, link_baud, arg, probe = link
+                if op in ops and link_baud == baud:
+                    return op, arg, probe
+        return None
+
+    def _try(self, baud):
+        """Thử một tốc độ. Trả về True nếu đã chuyển, False nếu bị từ chối/lỗi, None nếu thiết bị không trả lời."""
+        previous = self.baud
+        self.ser.write(encode_link(LINK_OP_PROPOSE, baud))
+        reply = self._wait({LINK_OP_ACCEPT, LINK_OP_REJECT}, baud, LINK_REPLY_TIMEOUT_S)
+        if reply is None:
+            return None
+        if reply[0] == LINK_OP_REJECT:
+            print(f"Link: device rejected {baud} baud")
+            return False
+        oversampling = reply[1]
+
+        self._set_baud(baud)
+        probe = encode_link(LINK_OP_PROBE, baud)
+        ok = True
+        for _ in range(LINK_PROBE_COUNT):
+            reply = self._wait({LINK_OP_PROBE_ACK}, baud, LINK_PROBE_TIMEOUT_S, resend=probe)
+            if reply is None or reply[2] != LINK_PROBE_PATTERN:
+                ok = False
+                break
+        if ok:
+            commit = encode_link(LINK_OP_COMMIT, baud)
+            ok = self._wait({LINK_OP_COMMIT_ACK}, baud, LINK_REPLY_TIMEOUT_S, resend=commit) is not None
+        if ok:
+            print(f"Link: switched to {baud} baud (oversampling {oversampling})")
+            self.last_valid = self.last_keepalive = time.perf_counter()
+            self.crc_errors = self.frames = self.strikes = 0
+            return True
+
+        # Thiết bị tự quay về sau LINK_TRIAL_TIMEOUT_MS (hoặc sau LINK_KEEPALIVE_TIMEOUT_MS nếu
+        # nó đã nhận COMMIT nhưng COMMIT_ACK bị mất) và báo STATUS ở tốc độ cũ
+        print(f"Link: {baud} baud failed probe, returning to {previous}")
+        self._set_baud(previous)
+        keepalive = encode_link(LINK_OP_KEEPALIVE, previous)
+        self._wait({LINK_OP_STATUS}, previous, LINK_SILENCE_TIMEOUT_S, resend=keepalive)
+        return False
+
+    def negotiate(self):
+        """Thỏa thuận tốc độ cao nhất không vượt quá cap. Trả về tốc độ hiện tại."""
+        candidates = [b for b in LINK_BAUD_CANDIDATES if self.default_baud < b <= self.cap]
+        for i, baud in enumerate(candidates):
+            result = self._try(baud)
+            if result is None and i == 0:
+                # Thiết bị có thể còn ở tốc độ của phiên trước: chờ nó quay về mặc định rồi thử lại
+                keepalive = encode_link(LINK_OP_KEEPALIVE, self.baud)
+                if self._wait({LINK_OP_STATUS}, self.baud, LINK_SILENCE_TIMEOUT_S, resend=keepalive):
+                    result = self._try(baud)
+            if result is None:
+                print("Link: no reply from device, staying at", self.baud)
+                break
+            if result:
+                break
+        return self.baud
+
+    def observe(self, results):
+        """Ghi nhận các khung vừa giải mã bởi vòng lặp chính."""
+        for frame, _ in results:
+            self.frames += 1
+            if not frame["valid"]:
+                self.crc_errors += 1
+                continue
+            self.last_valid = time.perf_counter()
+            link = decode_link(frame["payload"]) if frame["payload"][0] == LINK_DATA_ID else None
+            if link and link[0] == LINK_OP_STATUS and link[2] != 0:
+                reason = LINK_REASONS[link[2]] if link[2] < len(LINK_REASONS) else link[2]
+                print(f"Link: device returned to {link[1]} baud ({reason})")
+
+    def poll(self):
+        """Gửi KEEPALIVE định kỳ và quay về tốc độ mặc định khi liên kết xấu."""
+        if self.baud == self.default_baud:
+            return
+        now = time.perf_counter()
+        if now - self.last_keepalive >= LINK_KEEPALIVE_PERIOD_S:
+            self.last_keepalive = now
+            permille = self.crc_errors * 1000 // self.frames if self.frames else 0
+            self.crc_errors = self.frames = 0
+            self.ser.write(encode_link(LINK_OP_KEEPALIVE, self.baud, permille))
+            self.strikes = self.strikes + 1 if permille >= LINK_FALLBACK_ERROR_PERMILLE else 0
+            if self.strikes >= LINK_FALLBACK_STRIKES:
+                self._fallback(f"{permille / 10:.1f}% crc errors")
+                return
+        if now - self.last_valid >= LINK_SILENCE_TIMEOUT_S:
+            self._fallback("no valid frames")
+
+    def _fallback(self, reason):
+        failed = self.baud
+        self.fallbacks += 1
+        self.cap = max([b for b in LINK_BAUD_CANDIDATES if b < failed], default=self.default_baud)
+        print(f"Link: falling back from {failed} baud ({reason}), next attempt at most {self.cap}")
+        self._set_baud(self.default_baud)
+        keepalive = encode_link(LINK_OP_KEEPALIVE, self.default_baud)
+        self._wait({LINK_OP_STATUS}, self.default_baud, LINK_SILENCE_TIMEOUT_S, resend=keepalive)
+        self.negotiate()
+        self.last_valid = self.last_keepalive = time.perf_counter()
+
+RELIABLE_WINDOW_DEFAULT = 32     # RELIABLE_WINDOW_DEFAULT của thiết bị
+RELIABLE_ACK_PERIOD_S = 0.02      # ACK sớm nhất sau khung mới, gom nhiều khung vào một ACK
+RELIABLE_ACK_REFRESH_S = 0.5      # ACK lặp lại khi không có khung mới (RELIABLE_IDLE_TIMEOUT_MS = 5 s)
+RELIABLE_ENABLE_RESEND_S = 0.5    # gửi lại ENABLE khi chưa nhận được STATUS
+RELIABLE_HOLE_TIMEOUT_S = 6.0     # lâu hơn RELIABLE_MAX_RETRIES x RELIABLE_TIMEOUT_MS: thiết bị đã bỏ khung
+# Kết quả của ReliableReceiver.accept()
+RELIABLE_DUPLICATE, RELIABLE_IN_ORDER, RELIABLE_LATE = range(3)
+
+class ReliableReceiver:
+    """
+    Phía host của chế độ truyền tin cậy (Lib/Inc/Reliable.h).
+    accept() được gọi cho mỗi khung hợp lệ theo thứ tự nhận: khung trùng (bản gửi lại của khung
+    đã đến) bị bỏ, khung đến sau một khoảng trống được giữ lại để báo trong bitmap xác nhận
+    chọn lọc. poll() gửi ACK, gom các khung mới trong RELIABLE_ACK_PERIOD_S, và bỏ qua khoảng
+    trống đã chờ quá RELIABLE_HOLE_TIMEOUT_S, tính các khung đó là mất.
+    Khung được ghi theo thứ tự đến, không sắp xếp lại; mỗi bản ghi vẫn mang timestamp và
+    sample_count riêng.
+    """
+    def __init__(self, ser, window):
+        self.ser = ser
+        self.window = window
+        self.expected = None      # seq kế tiếp đang chờ, None khi chưa nhận STATUS
+        self.received = set()     # các seq đã nhận sau expected
+        self.hole_since = None    # thời điểm khoảng trống hiện tại xuất hiện
+        self.pending_ack = False
+        self.last_ack = 0.0
+        self.last_enable = 0.0
+        self.device_window = 0
+        self.frames = 0
+        self.duplicates = 0
+        self.recovered = 0
+        self.lost = 0
+        self.acks = 0
+
+    def start(self):
+        self.ser.write(encode_reliable(RELIABLE_OP_ENABLE, value=self.window))
+        self.last_enable = time.perf_counter()
+
+    def stop(self):
+        self.ser.write(encode_reliable(RELIABLE_OP_DISABLE))
+
+    def _distance(self, seq):
+        return (seq - self.expected) & 0xFFFF
+
+    def _advance(self):
+        while self.expected in self.received:
+            self.received.remove(self.expected)
+            self.expected = (self.expected + 1) & 0xFFFF
+        self.hole_since = (self.hole_since or time.perf_counter()) if self.received else None
+
+    def accept(self, frame):
+        """
+        Ghi nhận một khung hợp lệ. Trả về RELIABLE_DUPLICATE nếu khung là bản trùng và phải bỏ qua,
+        RELIABLE_LATE nếu khung đến sau một khung có seq lớn hơn (đã được gửi lại), ngược lại RELIABLE_IN_ORDER.
+        """
+        seq = frame["seq"]
+        payload = frame["payload"]
+        if payload[0] == RELIABLE_DATA_ID:
+            control = decode_reliable(payload)
+            if control is not None and control[0] == "status":
+                window = control[2]
+                if window and self.expected is None and seq is not None:
+                    # Khung có seq đến trước STATUS (STATUS bị lỗi và được gửi lại) đã được ghi nhận
+                    self.expected = seq
+                    self.received = {s for s in self.received if self._distance(s) < 0x8000}
+                    self._advance()
+                elif not window:
+                    # Thiết bị đã tắt chế độ (host im lặng quá lâu): poll() sẽ bật lại
+                    self.expected = None
+                    self.received.clear()
+                    self.hole_since = None
+                self.device_window = window
+                print(f"Reliable: device window {window}" if window else "Reliable: device disabled reliable mode")
+        if seq is None:
+            return RELIABLE_IN_ORDER
+        if self.expected is None:
+            self.received.add(seq)
+            return RELIABLE_IN_ORDER
+
+        distance = self._distance(seq)
+        self.pending_ack = True
+        if distance >= 0x8000 or seq in self.received:
+            # ACK trước đó có thể đã mất nên thiết bị gửi lại; ACK mới sẽ giải phóng khung
+            self.duplicates += 1
+            return RELIABLE_DUPLICATE
+
+        self.frames += 1
+        order = RELIABLE_IN_ORDER
+        if self.received and distance < max(self._distance(s) for s in self.received):
+            self.recovered += 1
+            order = RELIABLE_LATE
+        if distance == 0:
+            self.expected = (self.expected + 1) & 0xFFFF
+            self.hole_since = None
+        else:
+            self.received.add(seq)
+        self._advance()
+        return order
+
+    def poll(self):
+        """Gửi lại ENABLE khi cần, bỏ qua khoảng trống quá hạn và gửi ACK."""
+        now = time.perf_counter()
+        if self.expected is None:
+            if now - self.last_enable >= RELIABLE_ENABLE_RESEND_S:
+                self.start()
+            return
+
+        if self.hole_since is not None and now - self.hole_since >= RELIABLE_HOLE_TIMEOUT_S:
+            first = min(self.received, key=self._distance)
+            self.lost += self._distance(first)
+            self.expected = first
+            self.hole_since = None
+            self._advance()
+            self.pending_ack = True
+
+        if (self.pending_ack and now - self.last_ack >= RELIABLE_ACK_PERIOD_S) or \
+                now - self.last_ack >= RELIABLE_ACK_REFRESH_S:
+            bitmap = 0
+            for seq in self.received:
+                bit = self._distance(seq) - 1
+                if bit < RELIABLE_SACK_BITS:
+                    bitmap |= 1 << bit
+            self.ser.write(encode_reliable(RELIABLE_OP_ACK, self.expected, bitmap))
+            self.acks += 1
+            self.pending_ack = False
+            self.last_ack = now
+
+    def report(self):
+        return (f"reliable: window {self.device_window}, {self.frames} frames, {self.duplicates} duplicates, "
+                f"{self.recovered} recovered, {self.lost} lost, {self.acks} acks")
+
+FLASH_LOG_PRESENT_PERIOD_S = 1.0   # nhỏ hơn nhiều so với FLASH_LOG_HOST_TIMEOUT_MS = 3 s của thiết bị
+
+class FlashLogClient:
+    """
+    Phía host của nhật ký flash (Lib/Inc/FlashLog.h).
+    poll() gửi PRESENT mỗi FLASH_LOG_PRESENT_PERIOD_S để thiết bị không lưu trong lúc host đang nhận.
+    Thiết bị gửi STATUS khi thấy host xuất hiện; với drain, STATUS có phần tồn đọng được trả lời
+    bằng DUMP và các khung phát lại (FLAG_LOG) đến xen với luồng trực tiếp cho đến END.
+    """
+    def __init__(self, ser, drain):
+        self.ser = ser
+        self.drain = drain
+        self.dumping = False
+        self.last_present = 0.0
+        self.replayed = 0
+
+    def poll(self):
+        now = time.perf_counter()
+        if now - self.last_present >= FLASH_LOG_PRESENT_PERIOD_S:
+            self.ser.write(encode_flash_log(FLASH_LOG_OP_PRESENT))
+            self.last_present = now
+
+    def handle(self, record):
+        """Xử lý một bản ghi ("FlashLog", op, arg, value) từ thiết bị."""
+        _, op, arg, value = record
+        if op == "status":
+            print(f"Flash log: {value} bytes pending, {arg} sectors overwritten")
+            if self.drain and value > 0 and not self.dumping:
+                self.ser.write(encode_flash_log(FLASH_LOG_OP_DUMP))
+                self.dumping = True
+        elif op == "end":
+            print(f"Flash log: {value} records replayed")
+            self.dumping = False
+
+    def report(self):
+        return f"flash log: {self.replayed} replayed frames"
+
+def load_native_decoder(cobs=False):
+    """
+    Trả về bộ giải mã C++ (Host/frame_decoder.py) nếu thư viện đã được build
+    bằng `make -C Host`, ngược lại None để dùng bộ giải mã Python ở trên.
+    """
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "Host"))
+    try:
+        from frame_decoder import NativeDecoder
+        return NativeDecoder(cobs)
+    except (ImportError, OSError):
+        return None
+
 def main():
-    ser = serial.Serial("COM6", 115200, timeout=0.1)
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Nhận và giải mã luồng telemetry")
+    parser.add_argument("--port", default="COM6", help="cổng serial hoặc đường dẫn pty")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--replay", help="phát lại file bản ghi thay cho cổng serial (pacing theo --baud, 0 = tối đa)")
+    parser.add_argument("--python", action="store_true", help="luôn dùng bộ giải mã Python")
+    parser.add_argument("--quiet", action="store_true", help="không in từng dòng, chỉ in thống kê")
+    parser.add_argument("--negotiate", action="store_true",
+                        help="thỏa thuận tốc độ baud cao nhất với thiết bị, bắt đầu từ --baud")
+    parser.add_argument("--max-baud", type=int, default=LINK_BAUD_CANDIDATES[0],
+                        help="tốc độ cao nhất được thử khi --negotiate")
+    parser.add_argument("--cmd", action="append", default=[], metavar="OP:STREAM[:VALUE]",
+                        help="gửi lệnh sau khi mở cổng, có thể lặp lại; ví dụ rate:adc:2000, "
+                             "disable:hello, enable:hello, snapshot:temperature, snapshot:stats, get:date")
+    parser.add_argument("--cobs", action="store_true",
+                        help="luồng được đóng khung bằng COBS (firmware build với PROTOCOL_COBS=1)")
+    parser.add_argument("--reliable", type=int, nargs="?", const=RELIABLE_WINDOW_DEFAULT, metavar="WINDOW",
+                        help="bật chế độ truyền tin cậy (số thứ tự, ACK chọn lọc, gửi lại) với cửa sổ "
+                             f"WINDOW khung, tối đa {RELIABLE_WINDOW_MAX} (firmware build với RELIABLE_ENABLED=1)")
+    parser.add_argument("--drain", action="store_true",
+                        help="lấy phần thiết bị đã lưu vào nhật ký flash khi không có host "
+                             "(firmware build với FLASH_LOG_ENABLED=1), ghi vào backlog.csv")
+    args = parser.parse_args()
+    try:
+        commands = [parse_command(c) for c in args.cmd]
+    except (ValueError, KeyError) as e:
+        parser.error(str(e))
+    if args.reliable is not None and not 1 <= args.reliable <= RELIABLE_WINDOW_MAX:
+        parser.error(f"--reliable window must be 1..{RELIABLE_WINDOW_MAX}")
+
+    native = None if args.python else load_native_decoder(args.cobs)
+    print("Decoder:", ("native" if native is not None else "python") + (" (cobs)" if args.cobs else ""))
+    decode_buffer = decode_cobs_frames if args.cobs else decode_frames
+
+    link = None
+    reliable = None
+    flash_log = None
+    if args.replay:
+        ser = ReplaySource(args.replay, args.baud, READ_TIMEOUT_S)
+    else:
+        import serial
+        ser = serial.Serial(args.port, args.baud, timeout=READ_TIMEOUT_S)
+        if args.negotiate:
+            link = LinkManager(ser, args.baud, args.max_baud, decode_buffer)
+            print("Link baud:", link.negotiate())
+        if args.reliable is not None:
+            reliable = ReliableReceiver(ser, args.reliable)
+            reliable.start()
+        for command in commands:
+            ser.write(command)
+        flash_log = FlashLogClient(ser, args.drain)
+        flash_log.poll()
     
     csv_file = open('data.csv', 'w', newline='')
     csv_writer = csv.writer(csv_file)
     csv_writer.writerow(["Client Timestamp", "Interval (ms)", "Type", "Data..."])
     
     log_file = open("log.txt", "a")
+    backlog_file = None
+    backlog_writer = None
     
+    stats = RxStats()
     last_client_timestamp = None
     buffer = bytearray()
     try:
         while True:
-            if ser.in_waiting > 0:
-                data = ser.read(ser.in_waiting)
+            # Chặn đến khi có ít nhất một byte hoặc hết READ_TIMEOUT_S, rồi lấy hết phần đang chờ
+            waiting = ser.in_waiting
+            stats.backlog_max = max(stats.backlog_max, waiting)
+            data = ser.read(min(max(1, waiting), READ_MAX_BYTES))
+            if not data:
+                if getattr(ser, "exhausted", False):
+                    break
+                if link is not None:
+                    link.poll()
+                if reliable is not None:
+                    reliable.poll()
+                if flash_log is not None:
+                    flash_log.poll()
+                continue
+            t_rx = time.perf_counter()
+            stats.bytes += len(data)
+            stats.wakeups += 1
+
+            # Giải mã mọi khung đầy đủ trong lần thức dậy này
+            if native is not None:
+                results = native.feed(data)
+            else:
                 buffer.extend(data)
-            
-            frame, buffer = decode_frame(buffer)
-            if frame:
+                results, consumed = decode_buffer(buffer)
+                del buffer[:consumed]
+                if len(buffer) > MAX_BUFFER_BYTES:
+                    dropped = len(buffer) - MAX_BUFFER_BYTES
+                    del buffer[:dropped]
+                    stats.overflow(dropped)
+                    log_file.write(f"Receive buffer overflow at system time {time.time()}: dropped {dropped} bytes\n")
+
+            for frame, payload_info in results:
                 if not frame["valid"]:
+                    stats.corrupted += 1
                     log_file.write(f"Corrupted message at system time {time.time()}: {frame}\n")
-                    log_file.flush()
-                    continue  # Bỏ qua frame lỗi
+                    continue  # Bỏ qua frame lỗi; ở chế độ tin cậy thiết bị sẽ gửi lại
+                order = reliable.accept(frame) if reliable is not None else RELIABLE_IN_ORDER
+                if order == RELIABLE_DUPLICATE:
+                    continue  # Bản gửi lại của khung đã nhận
+
+                if frame["flags"] & FLAG_LOG:
+                    # Khung phát lại từ nhật ký flash: ghi riêng, không tính vào khoảng cách và thống kê trực tiếp
+                    if backlog_writer is None:
+                        backlog_file = open('backlog.csv', 'w', newline='')
+                        backlog_writer = csv.writer(backlog_file)
+                        backlog_writer.writerow(["Device Timestamp", "Type", "Data..."])
+                    if flash_log is not None:
+                        flash_log.replayed += 1
+                    if payload_info:
+                        if payload_info[0] in ("Batch", "AdcBlock"):
+                            records = [r for r in payload_info[1] if r]
+                        else:
+                            records = [payload_info]
+                        for record in records:
+                            backlog_writer.writerow([frame["timestamp"]] + list(record))
+                    continue
 
                 current_timestamp = frame["timestamp"]
+                # Khoảng cách được tính theo micro giây, có xử lý tràn của trường timestamp
                 if last_client_timestamp is not None:
-                    interval = current_timestamp - last_client_timestamp
-                    print(f"Received Data Interval: {interval} ms")
+                    delta_us = (frame["timestamp_us"] - last_client_timestamp) % frame["timestamp_wrap_us"]
+                    interval = delta_us / 1000.0
+                    if not args.quiet:
+                        print(f"Received Data Interval: {interval:.3f} ms")
                 else:
                     interval = None
-                last_client_timestamp = current_timestamp
+                last_client_timestamp = frame["timestamp_us"]
 
-                payload_info = decode_payload(frame)
                 if payload_info:
-                    row = [current_timestamp, interval]
-                    row.extend(payload_info)
-                    csv_writer.writerow(row)
-                    csv_file.flush()
-                    print("Logged row:", row)
+                    # Mỗi bản ghi trong khung gộp được ghi thành một dòng riêng
+                    if payload_info[0] in ("Batch", "AdcBlock"):
+                        records = [r for r in payload_info[1] if r]
+                    elif payload_info[0] == "Profiler":
+                        # Báo cáo profiler được in thành bảng, mỗi điểm đo một dòng CSV
+                        print(format_profiler_report(payload_info[1], payload_info[2]))
+                        records = [("Profiler", p["name"], p["count"], p["min"], p["mean"], p["max"])
+                                   for p in payload_info[2]]
+                    else:
+                        records = [payload_info]
+                    for record in records:
+                        if record[0] == "ADC":
+                            stats.adc(record[1], late=(order == RELIABLE_LATE))
+                        elif record[0] == "Command":
+                            print("Command reply:", *record[1:])
+                        elif record[0] == "FlashLog" and flash_log is not None:
+                            flash_log.handle(record)
+                        row = [current_timestamp, interval]
+                        row.extend(record)
+                        csv_writer.writerow(row)
+                        if not args.quiet:
+                            print("Logged row:", row)
                 else:
                     log_file.write(f"Failed to decode payload at system time {time.time()}\n")
-                    log_file.flush()
-            time.sleep(0.05)
+                stats.frame_done(t_rx)
+
+            if link is not None:
+                link.observe(results)
+                link.poll()
+            if reliable is not None:
+                reliable.poll()
+            if flash_log is not None:
+                flash_log.poll()
+
+            # Ghi đĩa một lần cho mỗi lần thức dậy thay vì sau mỗi khung
+            csv_file.flush()
+            log_file.flush()
+            if backlog_file is not None:
+                backlog_file.flush()
+
+            if time.perf_counter() - stats.window_start >= STATS_PERIOD_S:
+                print(stats.report())
+                if reliable is not None:
+                    print(reliable.report())
     except KeyboardInterrupt:
         print("Exiting...")
     finally:
+        print(stats.report(final=True))
+        if link is not None:
+            print(f"link: {link.baud} baud, {link.fallbacks} fallbacks, "
+                  f"{link.dropped_frames} frames dropped while negotiating")
+        if reliable is not None:
+            reliable.stop()
+            print(reliable.report())
+        if flash_log is not None and flash_log.replayed:
+            print(flash_log.report())
         csv_file.close()
+        if backlog_file is not None:
+            backlog_file.close()
         log_file.close()
         ser.close()
 